@@ -9,11 +9,34 @@
 
 #include "api/BamAlignment.h"
 #include "api/BamConstants.h"
+#include "api/internal/bam/BamSequenceCodec_p.h"
 using namespace BamTools;
+using namespace BamTools::Internal;
 
+#include <algorithm>
 #include <cstddef>
 #include <cstring>
 
+namespace {
+
+// fixed-size part of BamAlignment::Pack() data, followed by the raw char data
+struct PackedAlignmentCore
+{
+    int32_t RefID;
+    int32_t Position;
+    uint32_t AlignmentFlag;
+    int32_t MateRefID;
+    int32_t MatePosition;
+    int32_t InsertSize;
+    uint32_t NumCigarOperations;
+    uint32_t QueryNameLength;
+    uint32_t QuerySequenceLength;
+    uint16_t Bin;
+    uint16_t MapQuality;
+};
+
+}  // namespace
+
 /*! \class BamTools::BamAlignment
     \brief The main BAM alignment data structure.
 
@@ -113,55 +136,91 @@ bool BamAlignment::BuildCharData()
         return true;
     }
 
-    // check system endianness
-    bool IsBigEndian = BamTools::SystemIsBigEndian();
+    // decode all fields not already retrieved on demand
+    DecodeName();
+    DecodeQueryBases();
+    DecodeQualities();
+    if (!DecodeAlignedBases() || !DecodeTagData()) {
+        return false;
+    }
 
-    // calculate character lengths/offsets
-    const unsigned int dataLength = SupportData.BlockLength - Constants::BAM_CORE_SIZE;
-    const unsigned int seqDataOffset =
-        SupportData.QueryNameLength + (SupportData.NumCigarOperations * 4);
-    const unsigned int qualDataOffset = seqDataOffset + (SupportData.QuerySequenceLength + 1) / 2;
-    const unsigned int tagDataOffset = qualDataOffset + SupportData.QuerySequenceLength;
-    const unsigned int tagDataLength = dataLength - tagDataOffset;
+    // clear core-only flag & return success
+    SupportData.HasCoreOnly = false;
+    return true;
+}
 
-    // check offsets to see what char data exists
-    const bool hasSeqData = (seqDataOffset < qualDataOffset);
-    const bool hasQualData = (qualDataOffset < tagDataOffset);
-    const bool hasTagData = (tagDataOffset < dataLength);
+/*! \fn bool BamAlignment::BuildTagIndex()
+    \brief Indexes the offsets of the alignment's tags.
 
-    // store alignment name (relies on null char in name as terminator)
-    Name.assign(SupportData.AllCharData.data());
+    Following GetTag(), HasTag(), GetTagType() & GetArrayTagType() calls look up the
+    first tags (up to BamAlignmentTagIndex::MaxEntries, within the first 64 KiB of tag data)
+    directly, instead of scanning the tag data from its start. Useful if several tags are
+    queried per alignment.
 
-    // save query sequence
-    QueryBases.clear();
-    if (hasSeqData) {
-        const char* seqData = SupportData.AllCharData.data() + seqDataOffset;
-        QueryBases.reserve(SupportData.QuerySequenceLength);
-        for (std::size_t i = 0; i < SupportData.QuerySequenceLength; ++i) {
-            const char singleBase =
-                Constants::BAM_DNA_LOOKUP[((seqData[(i / 2)] >> (4 * (1 - (i % 2)))) & 0xf)];
-            QueryBases.append(1, singleBase);
+    The index is dropped by AddTag(), EditTag(), EditTags(), RemoveTag() & by BamReader when
+    it loads the next alignment.
+
+    \warning If BamAlignment::TagData is modified directly, the index may no longer match it.
+    Call BuildTagIndex() again after any such change.
+
+    \return \c true if tag data could be indexed (possibly only partially, if it is invalid)
+*/
+bool BamAlignment::BuildTagIndex()
+{
+
+    TagIndex.Clear();
+
+    // localize the tag data
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength)) {
+        return false;
+    }
+
+    TagIndex.TagData = pTagData;
+    TagIndex.TagDataLength = tagDataLength;
+    TagIndex.NumEntries = 0;
+    TagIndex.EndOffset = 0;
+    TagIndex.IsComplete = false;
+
+    // record tags until index is full, stopping at (& leaving unindexed) any invalid tag or
+    // any tag ending past the offsets the index can hold
+    unsigned int numBytesParsed = 0;
+    while (numBytesParsed < tagDataLength && *pTagData != '\0' &&
+           TagIndex.NumEntries < BamAlignmentTagIndex::MaxEntries) {
+        const char* pTagName = pTagData;
+        const char storageType = pTagData[2];
+        pTagData += 3;
+        numBytesParsed += 3;
+        if (storageType == '\0' || !SkipToNextTag(storageType, pTagData, numBytesParsed) ||
+            numBytesParsed > BamAlignmentTagIndex::MaxOffset) {
+            return true;
         }
+        BamAlignmentTagIndex::Entry& entry = TagIndex.Entries[TagIndex.NumEntries++];
+        entry.Name[0] = pTagName[0];
+        entry.Name[1] = pTagName[1];
+        entry.Offset = static_cast<uint16_t>(TagIndex.EndOffset + 3);
+        TagIndex.EndOffset = static_cast<uint16_t>(numBytesParsed);
     }
+    TagIndex.IsComplete = (numBytesParsed >= tagDataLength || *pTagData == '\0');
+    return true;
+}
 
-    // save qualities
+/*! \fn bool BamAlignment::DecodeAlignedBases()
+    \internal
 
-    Qualities.clear();
-    if (hasQualData) {
-        const char* qualData = SupportData.AllCharData.data() + qualDataOffset;
+    Builds AlignedBases from QueryBases & CIGAR data, if not already done for this record.
 
-        // if marked as unstored (sequence of 0xFF) - don't do conversion, just fill with 0xFFs
-        if (qualData[0] == (char)0xFF) {
-            Qualities.resize(SupportData.QuerySequenceLength, (char)0xFF);
+    \return \c false if CIGAR data contains an invalid operation
+*/
+bool BamAlignment::DecodeAlignedBases()
+{
 
-            // otherwise convert from numeric QV to 'FASTQ-style' ASCII character
-        } else {
-            Qualities.reserve(SupportData.QuerySequenceLength);
-            for (std::size_t i = 0; i < SupportData.QuerySequenceLength; ++i) {
-                Qualities.append(1, qualData[i] + 33);
-            }
-        }
+    // skip if already decoded
+    if (SupportData.DecodedFields & AlignedBasesField) {
+        return true;
     }
+    DecodeQueryBases();
 
     // clear previous AlignedBases
     AlignedBases.clear();
@@ -187,7 +246,7 @@ bool BamAlignment::BuildCharData()
                 case (Constants::BAM_CIGAR_INS_CHAR):
                 case (Constants::BAM_CIGAR_SEQMATCH_CHAR):
                 case (Constants::BAM_CIGAR_MISMATCH_CHAR):
-                    AlignedBases.append(QueryBases.substr(k, op.Length));
+                    AlignedBases.append(QueryBases, k, op.Length);
                     // fall through
 
                 // for 'S' - soft clip, do not write bases
@@ -225,13 +284,128 @@ bool BamAlignment::BuildCharData()
         }
     }
 
+    SupportData.DecodedFields |= AlignedBasesField;
+    return true;
+}
+
+/*! \fn void BamAlignment::DecodeName()
+    \internal
+
+    Populates Name from raw char data, if not already done for this record.
+*/
+void BamAlignment::DecodeName()
+{
+
+    // skip if already decoded
+    if (SupportData.DecodedFields & NameField) {
+        return;
+    }
+
+    // store alignment name (relies on null char in name as terminator)
+    Name.assign(SupportData.AllCharData.data());
+    SupportData.DecodedFields |= NameField;
+}
+
+/*! \fn void BamAlignment::DecodeQualities()
+    \internal
+
+    Populates Qualities from raw char data, if not already done for this record.
+*/
+void BamAlignment::DecodeQualities()
+{
+
+    // skip if already decoded
+    if (SupportData.DecodedFields & QualitiesField) {
+        return;
+    }
+
+    // calculate character lengths/offsets
+    const unsigned int seqDataOffset =
+        SupportData.QueryNameLength + (SupportData.NumCigarOperations * 4);
+    const unsigned int qualDataOffset = seqDataOffset + (SupportData.QuerySequenceLength + 1) / 2;
+    const unsigned int tagDataOffset = qualDataOffset + SupportData.QuerySequenceLength;
+
+    // save qualities
+    Qualities.clear();
+    if (qualDataOffset < tagDataOffset) {
+        const char* qualData = SupportData.AllCharData.data() + qualDataOffset;
+
+        // if marked as unstored (sequence of 0xFF) - don't do conversion, just fill with 0xFFs
+        if (qualData[0] == (char)0xFF) {
+            Qualities.resize(SupportData.QuerySequenceLength, (char)0xFF);
+
+            // otherwise convert from numeric QV to 'FASTQ-style' ASCII character
+        } else {
+            Qualities.resize(SupportData.QuerySequenceLength);
+            BamSequenceCodec::DecodeQualities(qualData, SupportData.QuerySequenceLength,
+                                              &Qualities[0]);
+        }
+    }
+
+    SupportData.DecodedFields |= QualitiesField;
+}
+
+/*! \fn void BamAlignment::DecodeQueryBases()
+    \internal
+
+    Populates QueryBases from raw char data, if not already done for this record.
+*/
+void BamAlignment::DecodeQueryBases()
+{
+
+    // skip if already decoded
+    if (SupportData.DecodedFields & QueryBasesField) {
+        return;
+    }
+
+    // calculate character lengths/offsets
+    const unsigned int seqDataOffset =
+        SupportData.QueryNameLength + (SupportData.NumCigarOperations * 4);
+    const unsigned int qualDataOffset = seqDataOffset + (SupportData.QuerySequenceLength + 1) / 2;
+
+    // save query sequence
+    QueryBases.clear();
+    if (seqDataOffset < qualDataOffset) {
+        const char* seqData = SupportData.AllCharData.data() + seqDataOffset;
+        QueryBases.resize(SupportData.QuerySequenceLength);
+        BamSequenceCodec::DecodeBases(seqData, SupportData.QuerySequenceLength, &QueryBases[0]);
+    }
+
+    SupportData.DecodedFields |= QueryBasesField;
+}
+
+/*! \fn bool BamAlignment::DecodeTagData()
+    \internal
+
+    Populates TagData from raw char data, if not already done for this record.
+
+    \return \c false if tag data contains an invalid type-code
+*/
+bool BamAlignment::DecodeTagData()
+{
+
+    // skip if already decoded
+    if (SupportData.DecodedFields & TagDataField) {
+        return true;
+    }
+
+    // calculate character lengths/offsets
+    const unsigned int seqDataOffset =
+        SupportData.QueryNameLength + (SupportData.NumCigarOperations * 4);
+    const unsigned int qualDataOffset = seqDataOffset + (SupportData.QuerySequenceLength + 1) / 2;
+    const unsigned int tagDataOffset = qualDataOffset + SupportData.QuerySequenceLength;
+    const unsigned int dataLength = SupportData.BlockLength - Constants::BAM_CORE_SIZE;
+    const unsigned int tagDataLength = dataLength - tagDataOffset;
+
     // save tag data
     TagData.clear();
-    if (hasTagData) {
+    if (tagDataOffset < dataLength) {
 
-        char* tagData = (((char*)SupportData.AllCharData.data()) + tagDataOffset);
+        // copy raw tag data, then swap endian-ness in the copy if necessary
+        TagData.assign(SupportData.AllCharData.data() + tagDataOffset, tagDataLength);
+        char* tagData = &TagData[0];
 
-        if (IsBigEndian) {
+        if (BamTools::SystemIsBigEndian()) {
             std::size_t i = 0;
             while (i < tagDataLength) {
 
@@ -322,14 +496,103 @@ bool BamAlignment::BuildCharData()
                 }
             }
         }
+    }
+
+    SupportData.DecodedFields |= TagDataField;
+    return true;
+}
+
+/*! \fn bool BamAlignment::EditTags(const BamTagEdits& edits)
+    \brief Applies several tag edits in a single pass over the tag data.
+
+    Each edited tag is replaced where it stands (or dropped, for removals), and tags that
+    did not exist yet are appended in the order they were requested. This is equivalent to
+    calling EditTag()/RemoveTag() for each edit, but rebuilds the tag data just once.
+
+    \param[in] edits tag edits to apply
+
+    \return \c true if edits were applied. If the existing tag data could not be parsed,
+            it is left unchanged & \c false is returned.
+    \sa BamTagEdits
+*/
+bool BamAlignment::EditTags(const BamTagEdits& edits)
+{
 
-        // store tagData in alignment
-        TagData.resize(tagDataLength);
-        std::memcpy((char*)(TagData.data()), tagData, tagDataLength);
+    // if char data not populated, do that first
+    if (SupportData.HasCoreOnly) {
+        BuildCharData();
     }
 
-    // clear core-only flag & return success
-    SupportData.HasCoreOnly = false;
+    // only the last edit of each tag takes effect
+    const std::vector<BamTagEdits::TagEdit>& tagEdits = edits.m_edits;
+    const std::size_t numEdits = tagEdits.size();
+    std::vector<bool> isPending(numEdits, true);
+    std::size_t newTagDataLength = TagData.size();
+    for (std::size_t i = 0; i < numEdits; ++i) {
+        for (std::size_t j = i + 1; j < numEdits; ++j) {
+            if (tagEdits[i].Tag == tagEdits[j].Tag) {
+                isPending[i] = false;
+                break;
+            }
+        }
+        newTagDataLength += tagEdits[i].EncodedTag.size();
+    }
+
+    // walk through original tags, copying either the tag or its edit
+    std::string newTagData;
+    newTagData.reserve(newTagDataLength);
+    char* pTagData = (char*)TagData.data();
+    const unsigned int tagDataLength = TagData.size();
+    unsigned int numBytesParsed = 0;
+    while (numBytesParsed < tagDataLength) {
+
+        // find the end of current tag
+        const unsigned int tagBegin = numBytesParsed;
+        const char* pTagName = pTagData;
+        const char storageType = pTagData[2];
+        pTagData += 3;
+        numBytesParsed += 3;
+        if (storageType == '\0' || !SkipToNextTag(storageType, pTagData, numBytesParsed) ||
+            numBytesParsed > tagDataLength) {
+            return false;
+        }
+
+        // look for a pending edit of this tag
+        std::size_t i = 0;
+        for (; i < numEdits; ++i) {
+            if (isPending[i] && std::strncmp(pTagName, tagEdits[i].Tag.c_str(), 2) == 0) {
+                break;
+            }
+        }
+
+        // apply it, or keep original tag
+        if (i < numEdits) {
+            isPending[i] = false;
+            if (!tagEdits[i].IsRemoval) {
+                newTagData.append(tagEdits[i].EncodedTag);
+            }
+        } else {
+            newTagData.append(TagData, tagBegin, numBytesParsed - tagBegin);
+        }
+
+        // keep any trailing data after the last tag
+        if (numBytesParsed < tagDataLength && *pTagData == '\0') {
+            newTagData.append(TagData, numBytesParsed, std::string::npos);
+            break;
+        }
+    }
+
+    // append tags that were not present
+    for (std::size_t i = 0; i < numEdits; ++i) {
+        if (isPending[i] && !tagEdits[i].IsRemoval) {
+            newTagData.append(tagEdits[i].EncodedTag);
+        }
+    }
+
+    // store new tag data
+    TagData.swap(newTagData);
+    TagIndex.Clear();
+    SupportData.HasRawCharData = false;
     return true;
 }
 
@@ -348,11 +611,34 @@ bool BamAlignment::BuildCharData()
     \post If \a tag is found, \a pTagData will point to the byte where the tag data begins.
           \a numBytesParsed will correspond to the position in the full TagData string.
 
+    Searches starting from the beginning of the tag data look up the tag index first, if
+    BuildTagIndex() built one for this tag data. The index is only read here.
 */
 bool BamAlignment::FindTag(const std::string& tag, char*& pTagData,
                            const unsigned int& tagDataLength, unsigned int& numBytesParsed) const
 {
 
+    // look up tag in index, if searching the full tag data it describes
+    if (numBytesParsed == 0 && tag.size() == Constants::BAM_TAG_TAGSIZE &&
+        TagIndex.TagData == pTagData && TagIndex.TagDataLength == tagDataLength) {
+
+        for (unsigned int i = 0; i < TagIndex.NumEntries; ++i) {
+            const BamAlignmentTagIndex::Entry& entry = TagIndex.Entries[i];
+            if (entry.Name[0] == tag[0] && entry.Name[1] == tag[1]) {
+                pTagData += entry.Offset;
+                numBytesParsed = entry.Offset;
+                return true;
+            }
+        }
+
+        // return if all tags checked, otherwise resume scanning after the indexed tags
+        if (TagIndex.IsComplete) {
+            return false;
+        }
+        pTagData += TagIndex.EndOffset;
+        numBytesParsed = TagIndex.EndOffset;
+    }
+
     while (numBytesParsed < tagDataLength) {
 
         const char* pTagType = pTagData;
@@ -381,6 +667,25 @@ bool BamAlignment::FindTag(const std::string& tag, char*& pTagData,
     return false;
 }
 
+/*! \fn const std::string& BamAlignment::GetAlignedBases()
+    \brief Returns the aligned sequence, decoding it on first access if necessary.
+
+    For an alignment retrieved using BamReader::GetNextAlignmentCore(), only this field is
+    decoded from the raw record data; the other character data fields are left untouched.
+    Otherwise, this simply returns BamAlignment::AlignedBases.
+
+    \note If the CIGAR data is invalid, the result is incomplete & GetErrorString() describes the problem.
+
+    \return reference to BamAlignment::AlignedBases
+*/
+const std::string& BamAlignment::GetAlignedBases()
+{
+    if (SupportData.HasCoreOnly) {
+        DecodeAlignedBases();
+    }
+    return AlignedBases;
+}
+
 /*! \fn bool BamAlignment::GetArrayTagType(const std::string& tag, char& type) const
     \brief Retrieves the BAM tag type-code for the array elements associated with requested tag name.
 
@@ -393,21 +698,13 @@ bool BamAlignment::FindTag(const std::string& tag, char*& pTagData,
 bool BamAlignment::GetArrayTagType(const std::string& tag, char& type) const
 {
 
-    // skip if alignment is core-only
-    if (SupportData.HasCoreOnly) {
+    // localize the tag data, skip if not available or no tags present
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength) || tagDataLength == 0) {
         // TODO: set error string?
         return false;
     }
-
-    // skip if no tags present
-    if (TagData.empty()) {
-        // TODO: set error string?
-        return false;
-    }
-
-    // localize the tag data
-    char* pTagData = (char*)TagData.data();
-    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
 
     // if tag not found, return failure
@@ -520,6 +817,57 @@ std::string BamAlignment::GetErrorString() const
     return ErrorString;
 }
 
+/*! \fn const std::string& BamAlignment::GetName()
+    \brief Returns the read name, decoding it on first access if necessary.
+
+    For an alignment retrieved using BamReader::GetNextAlignmentCore(), only this field is
+    decoded from the raw record data; the other character data fields are left untouched.
+    Otherwise, this simply returns BamAlignment::Name.
+
+    \return reference to BamAlignment::Name
+*/
+const std::string& BamAlignment::GetName()
+{
+    if (SupportData.HasCoreOnly) {
+        DecodeName();
+    }
+    return Name;
+}
+
+/*! \fn const std::string& BamAlignment::GetQualities()
+    \brief Returns the FASTQ qualities, decoding it on first access if necessary.
+
+    For an alignment retrieved using BamReader::GetNextAlignmentCore(), only this field is
+    decoded from the raw record data; the other character data fields are left untouched.
+    Otherwise, this simply returns BamAlignment::Qualities.
+
+    \return reference to BamAlignment::Qualities
+*/
+const std::string& BamAlignment::GetQualities()
+{
+    if (SupportData.HasCoreOnly) {
+        DecodeQualities();
+    }
+    return Qualities;
+}
+
+/*! \fn const std::string& BamAlignment::GetQueryBases()
+    \brief Returns the query sequence, decoding it on first access if necessary.
+
+    For an alignment retrieved using BamReader::GetNextAlignmentCore(), only this field is
+    decoded from the raw record data; the other character data fields are left untouched.
+    Otherwise, this simply returns BamAlignment::QueryBases.
+
+    \return reference to BamAlignment::QueryBases
+*/
+const std::string& BamAlignment::GetQueryBases()
+{
+    if (SupportData.HasCoreOnly) {
+        DecodeQueryBases();
+    }
+    return QueryBases;
+}
+
 /*! \fn bool BamAlignment::GetSoftClips(std::vector<int>& clipSizes, std::vector<int>& readPositions, std::vector<int>& genomePositions, bool usePadded = false) const
     \brief Identifies if an alignment has a soft clip. If so, identifies the
            sizes of the soft clips, as well as their positions in the read and reference.
@@ -608,6 +956,25 @@ bool BamAlignment::GetSoftClips(std::vector<int>& clipSizes, std::vector<int>& r
     return softClipFound;
 }
 
+/*! \fn const std::string& BamAlignment::GetTagData()
+    \brief Returns the raw tag data, decoding it on first access if necessary.
+
+    For an alignment retrieved using BamReader::GetNextAlignmentCore(), only this field is
+    decoded from the raw record data; the other character data fields are left untouched.
+    Otherwise, this simply returns BamAlignment::TagData.
+
+    \note If the tag data is invalid, the result is incomplete & GetErrorString() describes the problem.
+
+    \return reference to BamAlignment::TagData
+*/
+const std::string& BamAlignment::GetTagData()
+{
+    if (SupportData.HasCoreOnly) {
+        DecodeTagData();
+    }
+    return TagData;
+}
+
 /*! \fn std::vector<std::string> BamAlignment::GetTagNames() const
     \brief Retrieves the BAM tag names.
 
@@ -622,12 +989,12 @@ std::vector<std::string> BamAlignment::GetTagNames() const
 {
 
     std::vector<std::string> result;
-    if (SupportData.HasCoreOnly || TagData.empty()) {
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength) || tagDataLength == 0) {
         return result;
     }
 
-    char* pTagData = (char*)TagData.data();
-    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
     while (numBytesParsed < tagDataLength) {
 
@@ -667,21 +1034,13 @@ std::vector<std::string> BamAlignment::GetTagNames() const
 bool BamAlignment::GetTagType(const std::string& tag, char& type) const
 {
 
-    // skip if alignment is core-only
-    if (SupportData.HasCoreOnly) {
+    // localize the tag data, skip if not available or no tags present
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength) || tagDataLength == 0) {
         // TODO: set error string?
         return false;
     }
-
-    // skip if no tags present
-    if (TagData.empty()) {
-        // TODO: set error string?
-        return false;
-    }
-
-    // localize the tag data
-    char* pTagData = (char*)TagData.data();
-    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
 
     // if tag not found, return failure
@@ -723,14 +1082,12 @@ bool BamAlignment::GetTagType(const std::string& tag, char& type) const
 bool BamAlignment::HasTag(const std::string& tag) const
 {
 
-    // return false if no tag data present
-    if (SupportData.HasCoreOnly || TagData.empty()) {
+    // localize the tag data for lookup, return false if no tag data present
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength) || tagDataLength == 0) {
         return false;
     }
-
-    // localize the tag data for lookup
-    char* pTagData = (char*)TagData.data();
-    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
 
     // if result of tag lookup
@@ -817,6 +1174,96 @@ bool BamAlignment::IsProperPair() const
     return ((AlignmentFlag & Constants::BAM_ALIGNMENT_PROPER_PAIR) != 0);
 }
 
+/*! \fn bool BamAlignment::IsRawCharDataValid() const
+    \internal
+
+    Checks whether the raw char data (as read from file) still describes the alignment's
+    name, CIGAR, bases, qualities & tags, so that it can be copied as-is.
+
+    The fields are compared against the raw data itself, so direct assignments are detected
+    even if they keep the field's length. On big-endian systems, TagData is only compared by
+    length, as it is held in host byte order there.
+
+    \return \c false if alignment was not read from file, its tags were modified, or its char
+            data fields no longer match the raw data
+*/
+bool BamAlignment::IsRawCharDataValid() const
+{
+
+    // core-only alignments always keep their raw char data
+    if (SupportData.HasCoreOnly) {
+        return true;
+    }
+
+    // skip if not read from file, or modified through tag methods
+    if (!SupportData.HasRawCharData) {
+        return false;
+    }
+
+    // calculate character lengths/offsets
+    const unsigned int seqLength = SupportData.QuerySequenceLength;
+    const unsigned int seqDataOffset =
+        SupportData.QueryNameLength + (SupportData.NumCigarOperations * 4);
+    const unsigned int qualDataOffset = seqDataOffset + (seqLength + 1) / 2;
+    const unsigned int tagDataOffset = qualDataOffset + seqLength;
+    const unsigned int dataLength = SupportData.BlockLength - Constants::BAM_CORE_SIZE;
+    if ((Name.size() + 1 != SupportData.QueryNameLength) ||
+        (CigarData.size() != SupportData.NumCigarOperations) || (QueryBases.size() != seqLength) ||
+        (Qualities.size() != seqLength) || (tagDataOffset > dataLength) ||
+        (TagData.size() != dataLength - tagDataOffset)) {
+        return false;
+    }
+    const char* rawData = SupportData.AllCharData.data();
+
+    // check name
+    if (std::memcmp(rawData, Name.data(), Name.size()) != 0) {
+        return false;
+    }
+
+    // check CIGAR ops
+    const char* cigarData = rawData + SupportData.QueryNameLength;
+    for (unsigned int i = 0; i < SupportData.NumCigarOperations; ++i) {
+        uint32_t packedOp;
+        std::memcpy(&packedOp, cigarData + i * sizeof(uint32_t), sizeof(uint32_t));
+        if (BamTools::SystemIsBigEndian()) {
+            BamTools::SwapEndian_32(packedOp);
+        }
+        const CigarOp& op = CigarData[i];
+        if ((op.Length != (packedOp >> Constants::BAM_CIGAR_SHIFT)) ||
+            (op.Type != Constants::BAM_CIGAR_LOOKUP[(packedOp & Constants::BAM_CIGAR_MASK)])) {
+            return false;
+        }
+    }
+
+    // check bases & qualities, re-encoding them in chunks (chunk size is even, so that packed
+    // bases stay byte-aligned)
+    const unsigned int chunkSize = 512;
+    char encoded[chunkSize];
+    const bool hasQualities = (seqLength > 0 && rawData[qualDataOffset] != (char)0xFF);
+    for (unsigned int i = 0; i < seqLength; i += chunkSize) {
+        const unsigned int numBases = std::min(chunkSize, seqLength - i);
+        const std::size_t numBytes = (numBases + 1) / 2;
+        if ((BamSequenceCodec::EncodeBases(QueryBases.data() + i, numBases, encoded) != numBases) ||
+            (std::memcmp(encoded, rawData + seqDataOffset + i / 2, numBytes) != 0)) {
+            return false;
+        }
+        if (hasQualities) {
+            BamSequenceCodec::EncodeQualities(Qualities.data() + i, numBases, encoded);
+            if (std::memcmp(encoded, rawData + qualDataOffset + i, numBases) != 0) {
+                return false;
+            }
+        } else if (Qualities.find_first_not_of((char)0xFF, i) < i + numBases) {
+            return false;
+        }
+    }
+
+    // check tags
+    if (BamTools::SystemIsBigEndian()) {
+        return true;
+    }
+    return (std::memcmp(rawData + tagDataOffset, TagData.data(), TagData.size()) == 0);
+}
+
 /*! \fn bool BamAlignment::IsReverseStrand() const
     \return \c true if alignment mapped to reverse strand
 */
@@ -848,6 +1295,94 @@ bool BamAlignment::IsValidSize(const std::string& tag, const std::string& type)
            (type.size() == Constants::BAM_TAG_TYPESIZE);
 }
 
+/*! \fn bool BamAlignment::LocateTagData(char*& pTagData, unsigned int& tagDataLength) const
+    \internal
+
+    Finds the tag data to search. This is TagData when populated, otherwise for core-only
+    alignments the tags are read in place from the raw record data.
+
+    \param[out] pTagData      pointer to beginning of tag data
+    \param[out] tagDataLength length of tag data
+
+    \return \c false if tag data is not available without decoding
+*/
+bool BamAlignment::LocateTagData(char*& pTagData, unsigned int& tagDataLength) const
+{
+
+    // use TagData if populated
+    if (!SupportData.HasCoreOnly || (SupportData.DecodedFields & TagDataField)) {
+        pTagData = (char*)TagData.data();
+        tagDataLength = TagData.size();
+        return true;
+    }
+
+    // raw tag data is stored little-endian, so can only be read in place on matching systems
+    // (BamReader decodes TagData up front otherwise)
+    if (BamTools::SystemIsBigEndian()) {
+        return false;
+    }
+
+    // calculate tag data offset
+    const unsigned int dataLength = SupportData.BlockLength - Constants::BAM_CORE_SIZE;
+    const unsigned int tagDataOffset =
+        SupportData.QueryNameLength + (SupportData.NumCigarOperations * 4) +
+        (SupportData.QuerySequenceLength + 1) / 2 + SupportData.QuerySequenceLength;
+    if (tagDataOffset > dataLength) {
+        return false;
+    }
+
+    // point into raw tag data
+    pTagData = (char*)SupportData.AllCharData.data() + tagDataOffset;
+    tagDataLength = dataLength - tagDataOffset;
+    return true;
+}
+
+/*! \fn bool BamAlignment::Pack(std::string& buffer) const
+    \brief Appends alignment to \a buffer in a compact binary form.
+
+    The packed form holds only the core data & the raw character data as read from the BAM
+    file, so it takes about as much memory as the record does on disk. This is much less than
+    a BamAlignment with its separate string fields & allocations, which is useful for keeping
+    many alignments in memory (e.g. sort buffers).
+
+    The layout is specific to this BamTools build, so packed data is only meant to be read
+    back by Unpack() within the same program. The Filename field is not stored.
+
+    \param[in,out] buffer data buffer, packed alignment is appended to it
+    \return \c false if alignment has no raw character data to pack, e.g. if it was not read
+            from a BAM file or its character data was modified since
+    \sa Unpack()
+*/
+bool BamAlignment::Pack(std::string& buffer) const
+{
+
+    // skip if raw char data does not match alignment
+    if (!IsRawCharDataValid()) {
+        SetErrorString("BamAlignment::Pack", "alignment has no unmodified raw data to pack");
+        return false;
+    }
+
+    // store core data
+    PackedAlignmentCore core;
+    core.RefID = RefID;
+    core.Position = Position;
+    core.AlignmentFlag = AlignmentFlag;
+    core.MateRefID = MateRefID;
+    core.MatePosition = MatePosition;
+    core.InsertSize = InsertSize;
+    core.NumCigarOperations = SupportData.NumCigarOperations;
+    core.QueryNameLength = SupportData.QueryNameLength;
+    core.QuerySequenceLength = SupportData.QuerySequenceLength;
+    core.Bin = Bin;
+    core.MapQuality = MapQuality;
+    buffer.append(reinterpret_cast<const char*>(&core), sizeof(core));
+
+    // store raw char data
+    const unsigned int dataLength = SupportData.BlockLength - Constants::BAM_CORE_SIZE;
+    buffer.append(SupportData.AllCharData.data(), dataLength);
+    return true;
+}
+
 /*! \fn void BamAlignment::RemoveTag(const std::string& tag)
     \brief Removes field from BAM tags.
 
@@ -867,40 +1402,68 @@ void BamAlignment::RemoveTag(const std::string& tag)
     }
 
     // localize the tag data
-    char* pOriginalTagData = (char*)TagData.data();
-    char* pTagData = pOriginalTagData;
-    const unsigned int originalTagDataLength = TagData.size();
+    char* pTagData = (char*)TagData.data();
+    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
 
     // skip if tag not found
-    if (!FindTag(tag, pTagData, originalTagDataLength, numBytesParsed)) {
+    if (!FindTag(tag, pTagData, tagDataLength, numBytesParsed)) {
         return;
     }
 
-    // otherwise, remove it
-    RaiiBuffer newTagData(originalTagDataLength);
+    // otherwise, find where it ends & squeeze remaining tag data over it
+    const unsigned int tagBegin = numBytesParsed - 3;
+    if (SkipToNextTag(*(pTagData - 1), pTagData, numBytesParsed)) {
+        TagData.erase(tagBegin, numBytesParsed - tagBegin);
+        TagIndex.Clear();
+        SupportData.HasRawCharData = false;
+    }
+}
+
+/*! \fn bool BamAlignment::ReplaceTag(const std::string& tag, const std::string& newTag)
+    \internal
+
+    Stores a tag over the existing tag of the same name, or appends it if there is none.
+
+    \param[in] tag    2-character tag name
+    \param[in] newTag raw data for the new tag (name, type-code & value)
+
+    \return \c false if the existing tag could not be parsed
+*/
+bool BamAlignment::ReplaceTag(const std::string& tag, const std::string& newTag)
+{
 
-    // copy original tag data up til desired tag
-    pTagData -= 3;
-    numBytesParsed -= 3;
-    const unsigned int beginningTagDataLength = numBytesParsed;
-    std::memcpy(newTagData.Buffer, pOriginalTagData, numBytesParsed);
+    // localize the tag data
+    char* pTagData = (char*)TagData.data();
+    const unsigned int tagDataLength = TagData.size();
+    unsigned int numBytesParsed = 0;
 
-    // attemp to skip to next tag
-    const char* pTagStorageType = pTagData + 2;
-    pTagData += 3;
-    numBytesParsed += 3;
-    if (SkipToNextTag(*pTagStorageType, pTagData, numBytesParsed)) {
+    // if tag not found, append new one
+    if (!FindTag(tag, pTagData, tagDataLength, numBytesParsed)) {
+        TagData.append(newTag);
+        TagIndex.Clear();
+        SupportData.HasRawCharData = false;
+        return true;
+    }
 
-        // squeeze remaining tag data
-        const unsigned int skippedDataLength = (numBytesParsed - beginningTagDataLength);
-        const unsigned int endTagDataLength =
-            originalTagDataLength - beginningTagDataLength - skippedDataLength;
-        std::memcpy(newTagData.Buffer + beginningTagDataLength, pTagData, endTagDataLength);
+    // otherwise find where the existing tag ends
+    const unsigned int tagBegin = numBytesParsed - 3;
+    if (!SkipToNextTag(*(pTagData - 1), pTagData, numBytesParsed) ||
+        numBytesParsed > tagDataLength) {
+        return false;
+    }
+    const unsigned int oldTagLength = numBytesParsed - tagBegin;
 
-        // save modified tag data in alignment
-        TagData.assign(newTagData.Buffer, beginningTagDataLength + endTagDataLength);
+    // overwrite tag in place if sizes match (tag offsets, and so TagIndex, remain valid),
+    // otherwise move the following tags just once
+    if (oldTagLength == newTag.size()) {
+        std::memcpy(&TagData[tagBegin], newTag.data(), oldTagLength);
+    } else {
+        TagData.replace(tagBegin, oldTagLength, newTag);
+        TagIndex.Clear();
     }
+    SupportData.HasRawCharData = false;
+    return true;
 }
 
 /*! \fn void BamAlignment::SetErrorString(const std::string& where, const std::string& what) const
@@ -1089,15 +1652,13 @@ bool BamAlignment::SkipToNextTag(const char storageType, char*& pTagData,
             break;
 
         case (Constants::BAM_TAG_TYPE_STRING):
-        case (Constants::BAM_TAG_TYPE_HEX):
-            while (*pTagData) {
-                ++numBytesParsed;
-                ++pTagData;
-            }
-            // increment for null-terminator
-            ++numBytesParsed;
-            ++pTagData;
+        case (Constants::BAM_TAG_TYPE_HEX): {
+            // skip string, plus its null-terminator
+            const unsigned int stringLength = std::strlen(pTagData) + 1;
+            numBytesParsed += stringLength;
+            pTagData += stringLength;
             break;
+        }
 
         case (Constants::BAM_TAG_TYPE_ARRAY):
 
@@ -1152,3 +1713,123 @@ bool BamAlignment::SkipToNextTag(const char storageType, char*& pTagData,
     // if we get here, tag skipped OK - return success
     return true;
 }
+
+/*! \fn bool BamAlignment::Unpack(const char* data, std::size_t length)
+    \brief Restores alignment from data written by Pack().
+
+    Afterwards, the alignment is set up as if retrieved by BamReader::GetNextAlignmentCore():
+    the character data fields are decoded on demand, or all at once using BuildCharData().
+
+    \param[in] data   packed alignment data
+    \param[in] length size of packed alignment data, in bytes
+    \return \c true if alignment was restored successfully
+    \sa Pack()
+*/
+bool BamAlignment::Unpack(const char* data, std::size_t length)
+{
+
+    // read core data
+    PackedAlignmentCore core;
+    if (length < sizeof(core)) {
+        SetErrorString("BamAlignment::Unpack", "packed data is truncated");
+        return false;
+    }
+    std::memcpy(&core, data, sizeof(core));
+
+    // make sure char data holds the expected fields
+    const std::size_t dataLength = length - sizeof(core);
+    const std::size_t seqLength = core.QuerySequenceLength;
+    const std::size_t tagDataOffset =
+        core.QueryNameLength + (core.NumCigarOperations * 4) + (seqLength + 1) / 2 + seqLength;
+    if (tagDataOffset > dataLength) {
+        SetErrorString("BamAlignment::Unpack", "packed data is truncated");
+        return false;
+    }
+
+    // set core & support data
+    RefID = core.RefID;
+    Position = core.Position;
+    AlignmentFlag = core.AlignmentFlag;
+    MateRefID = core.MateRefID;
+    MatePosition = core.MatePosition;
+    InsertSize = core.InsertSize;
+    Bin = core.Bin;
+    MapQuality = core.MapQuality;
+    Length = core.QuerySequenceLength;
+    Filename.clear();
+
+    SupportData.AllCharData.assign(data + sizeof(core), dataLength);
+    SupportData.BlockLength = Constants::BAM_CORE_SIZE + dataLength;
+    SupportData.NumCigarOperations = core.NumCigarOperations;
+    SupportData.QueryNameLength = core.QueryNameLength;
+    SupportData.QuerySequenceLength = core.QuerySequenceLength;
+    SupportData.HasCoreOnly = true;
+    SupportData.HasRawCharData = true;
+    SupportData.DecodedFields = 0;
+    TagIndex.Clear();
+
+    // decode CIGAR ops, so that GetEndPosition() works without char data
+    const char* cigarDataPtr = SupportData.AllCharData.data() + SupportData.QueryNameLength;
+    CigarData.resize(core.NumCigarOperations);
+    for (unsigned int i = 0; i < core.NumCigarOperations; cigarDataPtr += sizeof(uint32_t), ++i) {
+        uint32_t cigarData;
+        std::memcpy(&cigarData, cigarDataPtr, sizeof(uint32_t));
+        if (BamTools::SystemIsBigEndian()) {
+            BamTools::SwapEndian_32(cigarData);
+        }
+        CigarOp& op = CigarData[i];
+        op.Length = (cigarData >> Constants::BAM_CIGAR_SHIFT);
+        op.Type = Constants::BAM_CIGAR_LOOKUP[(cigarData & Constants::BAM_CIGAR_MASK)];
+    }
+
+    // raw tag data is stored little-endian, decode it up front on other systems (like BamReader)
+    if (BamTools::SystemIsBigEndian()) {
+        return DecodeTagData();
+    }
+    return true;
+}
+
+// ---------------------------------------------------------
+// BamTagEdits implementation
+
+/*! \class BamTools::BamTagEdits
+    \brief Collects BAM tag changes, to be applied in one pass by BamAlignment::EditTags().
+
+    Edits can be re-used across alignments, e.g. when setting the same tags on every record.
+*/
+
+/*! \fn void BamTagEdits::Clear()
+    \brief Clears all requested edits.
+*/
+void BamTagEdits::Clear()
+{
+    m_edits.clear();
+}
+
+/*! \fn bool BamTagEdits::IsEmpty() const
+    \brief Returns true if no edits have been requested.
+*/
+bool BamTagEdits::IsEmpty() const
+{
+    return m_edits.empty();
+}
+
+/*! \fn bool BamTagEdits::Remove(const std::string& tag)
+    \brief Requests that a BAM tag field be removed.
+
+    If \a tag is edited (or removed) more than once, the last request takes effect.
+
+    \param tag[in] 2-character tag name
+    \return \c true if the tag name is valid & the removal was recorded
+*/
+bool BamTagEdits::Remove(const std::string& tag)
+{
+    if (tag.size() != Constants::BAM_TAG_TAGSIZE) {
+        return false;
+    }
+    m_edits.push_back(TagEdit());
+    TagEdit& edit = m_edits.back();
+    edit.Tag = tag;
+    edit.IsRemoval = true;
+    return true;
+}
@@ -29,6 +29,49 @@ class BamWriterPrivate;
 }  // namespace Internal
 //! \endcond
 
+// collects tag changes, to be applied together by BamAlignment::EditTags()
+class API_EXPORT BamTagEdits
+{
+
+    // BamTagEdits interface
+public:
+    // sets tag to value, adding the tag if not present
+    template <typename T>
+    bool Edit(const std::string& tag, const std::string& type, const T& value);
+    template <typename T>
+    bool Edit(const std::string& tag, const std::vector<T>& values);
+    // removes tag, if present
+    bool Remove(const std::string& tag);
+
+    // clears all edits
+    void Clear();
+    // returns true if no edits have been requested
+    bool IsEmpty() const;
+
+    //! \internal
+    // internal utility methods, shared with BamAlignment
+private:
+    template <typename T>
+    static bool EncodeTag(const std::string& tag, const std::string& type, const T& value,
+                          std::string& encodedTag);
+    template <typename T>
+    static bool EncodeTag(const std::string& tag, const std::vector<T>& values,
+                          std::string& encodedTag);
+
+    //! \internal
+    // data members
+private:
+    struct TagEdit
+    {
+        std::string Tag;         // 2-character tag name
+        bool IsRemoval;          // true if tag is to be removed
+        std::string EncodedTag;  // replacement tag (name, type-code & value), if not a removal
+    };
+    std::vector<TagEdit> m_edits;
+
+    friend class BamAlignment;
+};
+
 // BamAlignment data structure
 class API_EXPORT BamAlignment
 {
@@ -83,6 +126,8 @@ public:
     bool EditTag(const std::string& tag, const std::string& type, const T& value);
     template <typename T>
     bool EditTag(const std::string& tag, const std::vector<T>& values);
+    // applies several tag edits in one pass over the tag data
+    bool EditTags(const BamTagEdits& edits);
 
     // retrieves tag data
     template <typename T>
@@ -105,6 +150,17 @@ public:
     // removes a tag
     void RemoveTag(const std::string& tag);
 
+    // indexes tag offsets, so that following tag queries skip the linear scan
+    bool BuildTagIndex();
+
+    // character data access methods, decoding only the requested field on demand
+public:
+    const std::string& GetAlignedBases();
+    const std::string& GetName();
+    const std::string& GetQualities();
+    const std::string& GetQueryBases();
+    const std::string& GetTagData();
+
     // additional methods
 public:
     // populates alignment string fields
@@ -120,6 +176,11 @@ public:
     bool GetSoftClips(std::vector<int>& clipSizes, std::vector<int>& readPositions,
                       std::vector<int>& genomePositions, bool usePadded = false) const;
 
+    // appends alignment to buffer in a compact binary form, for holding many alignments in memory
+    bool Pack(std::string& buffer) const;
+    // restores alignment from data written by Pack()
+    bool Unpack(const char* data, std::size_t length);
+
     // public data fields
 public:
     std::string Name;        // read name
@@ -143,9 +204,17 @@ public:
     //! \internal
     // internal utility methods
 private:
+    bool DecodeAlignedBases();
+    void DecodeName();
+    void DecodeQualities();
+    void DecodeQueryBases();
+    bool DecodeTagData();
     bool FindTag(const std::string& tag, char*& pTagData, const unsigned int& tagDataLength,
                  unsigned int& numBytesParsed) const;
+    bool IsRawCharDataValid() const;
     bool IsValidSize(const std::string& tag, const std::string& type) const;
+    bool LocateTagData(char*& pTagData, unsigned int& tagDataLength) const;
+    bool ReplaceTag(const std::string& tag, const std::string& newTag);
     void SetErrorString(const std::string& where, const std::string& what) const;
     bool SkipToNextTag(const char storageType, char*& pTagData, unsigned int& numBytesParsed) const;
 
@@ -163,6 +232,8 @@ private:
         uint32_t QueryNameLength;
         uint32_t QuerySequenceLength;
         bool HasCoreOnly;
+        bool HasRawCharData;    // true while AllCharData matches the char data fields, as read
+        uint8_t DecodedFields;  // CharDataField flags, for core-only alignments
 
         //! \internal
         // constructor
@@ -172,9 +243,72 @@ private:
             , QueryNameLength(0)
             , QuerySequenceLength(0)
             , HasCoreOnly(false)
+            , HasRawCharData(false)
+            , DecodedFields(0)
         {}
     };
+    enum CharDataField
+    {
+        NameField = 0x01,
+        QueryBasesField = 0x02,
+        QualitiesField = 0x04,
+        AlignedBasesField = 0x08,
+        TagDataField = 0x10
+    };
     BamAlignmentSupportData SupportData;
+
+    // offsets of the first tags in the tag data, built on request by BuildTagIndex()
+    // only non-const methods modify it, so const tag queries stay safe to run concurrently
+    // (kept small, as every BamAlignment carries one: tags past the first 64 KiB aren't indexed)
+    struct BamAlignmentTagIndex
+    {
+
+        //! \internal
+        // data members
+        static const unsigned int MaxEntries = 16;
+        static const unsigned int MaxOffset = 0xFFFF;
+        struct Entry
+        {
+            char Name[2];     // 2-character tag name
+            uint16_t Offset;  // position of tag's value, just past its type-code
+        } Entries[MaxEntries];
+        const char* TagData;     // tag data this index describes, 0 if not built
+        uint32_t TagDataLength;  // length of that tag data
+        uint16_t EndOffset;      // where the first tag not yet indexed begins
+        uint8_t NumEntries;
+        bool IsComplete;  // true if every tag is indexed
+
+        //! \internal
+        // constructors & assignment; a copy describes a different buffer, so starts out unbuilt
+        BamAlignmentTagIndex()
+            : TagData(0)
+            , TagDataLength(0)
+            , EndOffset(0)
+            , NumEntries(0)
+            , IsComplete(false)
+        {}
+        BamAlignmentTagIndex(const BamAlignmentTagIndex&)
+            : TagData(0)
+            , TagDataLength(0)
+            , EndOffset(0)
+            , NumEntries(0)
+            , IsComplete(false)
+        {}
+        BamAlignmentTagIndex& operator=(const BamAlignmentTagIndex&)
+        {
+            Clear();
+            return *this;
+        }
+
+        //! \internal
+        // marks index as out-of-date
+        void Clear()
+        {
+            TagData = 0;
+        }
+    };
+    BamAlignmentTagIndex TagIndex;
+
     friend class Internal::BamReaderPrivate;
     friend class Internal::BamWriterPrivate;
 
@@ -251,6 +385,8 @@ bool BamAlignment::AddTag(const std::string& tag, const std::string& type, const
     // store temp buffer back in TagData
     const char* newTagData = (const char*)originalTagData.Buffer;
     TagData.assign(newTagData, newTagDataLength);
+    TagIndex.Clear();
+    SupportData.HasRawCharData = false;
     return true;
 }
 
@@ -301,6 +437,8 @@ inline bool BamAlignment::AddTag<std::string>(const std::string& tag, const std:
     // store temp buffer back in TagData
     const char* newTagData = (const char*)originalTagData.Buffer;
     TagData.assign(newTagData, newTagDataLength);
+    TagIndex.Clear();
+    SupportData.HasRawCharData = false;
     return true;
 }
 
@@ -371,20 +509,24 @@ bool BamAlignment::AddTag(const std::string& tag, const std::vector<T>& values)
     // store temp buffer back in TagData
     const char* newTagData = (const char*)originalTagData.Buffer;
     TagData.assign(newTagData, newTagDataLength);
+    TagIndex.Clear();
+    SupportData.HasRawCharData = false;
     return true;
 }
 
 /*! \fn template<typename T> bool EditTag(const std::string& tag, const std::string& type, const T& value)
     \brief Edits a BAM tag field.
 
-    If \a tag does not exist, a new entry is created.
+    If \a tag does not exist, a new entry is created. Otherwise the tag is replaced where it
+    stands: in place if the new value has the same size, else by shifting the following tags once.
 
     \param tag[in]   2-character tag name
-    \param type[in]  1-character tag type (must be "Z" or "H")
+    \param type[in]  1-character tag type
     \param value[in] new data value
 
     \return \c true if the tag was modified/created successfully
 
+    \sa BamAlignment::EditTags()
     \sa BamAlignment::RemoveTag()
     \sa \samSpecURL for more details on reserved tag names, supported tag types, etc.
 */
@@ -397,22 +539,26 @@ bool BamAlignment::EditTag(const std::string& tag, const std::string& type, cons
         BuildCharData();
     }
 
-    // remove existing tag if present, then append tag with new value
-    if (HasTag(tag)) {
-        RemoveTag(tag);
+    // encode new tag, then store it over existing tag (if present)
+    std::string newTag;
+    if (!BamTagEdits::EncodeTag(tag, type, value, newTag)) {
+        // TODO: set error string?
+        return false;
     }
-    return AddTag(tag, type, value);
+    return ReplaceTag(tag, newTag);
 }
 
 /*! \fn template<typename T> bool EditTag(const std::string& tag, const std::vector<T>& values)
     \brief Edits a BAM tag field containing a numeric array.
 
-    If \a tag does not exist, a new entry is created.
+    If \a tag does not exist, a new entry is created. Otherwise the tag is replaced where it
+    stands: in place if the new array has the same size, else by shifting the following tags once.
 
     \param tag[in]   2-character tag name
     \param value[in] vector of data values
 
     \return \c true if the tag was modified/created successfully
+    \sa BamAlignment::EditTags()
     \sa \samSpecURL for more details on reserved tag names, supported tag types, etc.
 */
 template <typename T>
@@ -424,11 +570,13 @@ bool BamAlignment::EditTag(const std::string& tag, const std::vector<T>& values)
         BuildCharData();
     }
 
-    // remove existing tag if present, then append tag with new values
-    if (HasTag(tag)) {
-        RemoveTag(tag);
+    // encode new tag, then store it over existing tag (if present)
+    std::string newTag;
+    if (!BamTagEdits::EncodeTag(tag, values, newTag)) {
+        // TODO: set error string?
+        return false;
     }
-    return AddTag(tag, values);
+    return ReplaceTag(tag, newTag);
 }
 
 /*! \fn template<typename T> bool GetTag(const std::string& tag, T& destination) const
@@ -442,21 +590,13 @@ template <typename T>
 bool BamAlignment::GetTag(const std::string& tag, T& destination) const
 {
 
-    // skip if alignment is core-only
-    if (SupportData.HasCoreOnly) {
-        // TODO: set error string?
-        return false;
-    }
-
-    // skip if no tags present
-    if (TagData.empty()) {
+    // localize the tag data, skip if not available or no tags present
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength) || tagDataLength == 0) {
         // TODO: set error string?
         return false;
     }
-
-    // localize the tag data
-    char* pTagData = (char*)TagData.data();
-    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
 
     // return failure if tag not found
@@ -523,21 +663,13 @@ template <>
 inline bool BamAlignment::GetTag<std::string>(const std::string& tag,
                                               std::string& destination) const
 {
-    // skip if alignment is core-only
-    if (SupportData.HasCoreOnly) {
+    // localize the tag data, skip if not available or no tags present
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength) || tagDataLength == 0) {
         // TODO: set error string?
         return false;
     }
-
-    // skip if no tags present
-    if (TagData.empty()) {
-        // TODO: set error string?
-        return false;
-    }
-
-    // localize the tag data
-    char* pTagData = (char*)TagData.data();
-    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
 
     // return failure if tag not found
@@ -567,21 +699,13 @@ template <typename T>
 bool BamAlignment::GetTag(const std::string& tag, std::vector<T>& destination) const
 {
 
-    // skip if alignment is core-only
-    if (SupportData.HasCoreOnly) {
+    // localize the tag data, skip if not available or no tags present
+    char* pTagData = 0;
+    unsigned int tagDataLength = 0;
+    if (!LocateTagData(pTagData, tagDataLength) || tagDataLength == 0) {
         // TODO: set error string?
         return false;
     }
-
-    // skip if no tags present
-    if (TagData.empty()) {
-        // TODO: set error string?
-        return false;
-    }
-
-    // localize the tag data
-    char* pTagData = (char*)TagData.data();
-    const unsigned int tagDataLength = TagData.size();
     unsigned int numBytesParsed = 0;
 
     // return false if tag not found
@@ -655,6 +779,131 @@ bool BamAlignment::GetTag(const std::string& tag, std::vector<T>& destination) c
     return true;
 }
 
+// ---------------------------------------------------------
+// BamTagEdits methods
+
+/*! \fn template<typename T> bool BamTagEdits::Edit(const std::string& tag, const std::string& type, const T& value)
+    \brief Requests that a BAM tag field be set to \a value.
+
+    If the alignment has no such tag, a new entry is created.
+    If \a tag is edited (or removed) more than once, the last request takes effect.
+
+    \param tag[in]   2-character tag name
+    \param type[in]  1-character tag type
+    \param value[in] new data value
+
+    \return \c true if the edit is valid & was recorded
+*/
+template <typename T>
+bool BamTagEdits::Edit(const std::string& tag, const std::string& type, const T& value)
+{
+    m_edits.push_back(TagEdit());
+    TagEdit& edit = m_edits.back();
+    if (!EncodeTag(tag, type, value, edit.EncodedTag)) {
+        m_edits.pop_back();
+        return false;
+    }
+    edit.Tag = tag;
+    edit.IsRemoval = false;
+    return true;
+}
+
+/*! \fn template<typename T> bool BamTagEdits::Edit(const std::string& tag, const std::vector<T>& values)
+    \brief Requests that a BAM tag field be set to the numeric array \a values.
+
+    If the alignment has no such tag, a new entry is created.
+    If \a tag is edited (or removed) more than once, the last request takes effect.
+
+    \param tag[in]    2-character tag name
+    \param values[in] vector of data values
+
+    \return \c true if the edit is valid & was recorded
+*/
+template <typename T>
+bool BamTagEdits::Edit(const std::string& tag, const std::vector<T>& values)
+{
+    m_edits.push_back(TagEdit());
+    TagEdit& edit = m_edits.back();
+    if (!EncodeTag(tag, values, edit.EncodedTag)) {
+        m_edits.pop_back();
+        return false;
+    }
+    edit.Tag = tag;
+    edit.IsRemoval = false;
+    return true;
+}
+
+// builds the raw tag data for a single-value tag
+template <typename T>
+bool BamTagEdits::EncodeTag(const std::string& tag, const std::string& type, const T& value,
+                            std::string& encodedTag)
+{
+
+    // check tag/type size
+    if (tag.size() != Constants::BAM_TAG_TAGSIZE || type.size() != Constants::BAM_TAG_TYPESIZE) {
+        return false;
+    }
+
+    // check that storage type code is OK for T
+    if (!TagTypeHelper<T>::CanConvertTo(type.at(0))) {
+        return false;
+    }
+
+    // store tag name & type, followed by value
+    encodedTag.assign(tag);
+    encodedTag.append(type);
+    encodedTag.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    return true;
+}
+
+template <>
+inline bool BamTagEdits::EncodeTag<std::string>(const std::string& tag, const std::string& type,
+                                                const std::string& value, std::string& encodedTag)
+{
+
+    // check tag/type size
+    if (tag.size() != Constants::BAM_TAG_TAGSIZE || type.size() != Constants::BAM_TAG_TYPESIZE) {
+        return false;
+    }
+
+    // check that storage type code is OK for string
+    if (!TagTypeHelper<std::string>::CanConvertTo(type.at(0))) {
+        return false;
+    }
+
+    // store tag name & type, followed by null-terminated value
+    encodedTag.assign(tag);
+    encodedTag.append(type);
+    encodedTag.append(value.c_str());
+    encodedTag.append(1, '\0');
+    return true;
+}
+
+// builds the raw tag data for a numeric array tag
+template <typename T>
+bool BamTagEdits::EncodeTag(const std::string& tag, const std::vector<T>& values,
+                            std::string& encodedTag)
+{
+
+    // check for valid tag name length
+    if (tag.size() != Constants::BAM_TAG_TAGSIZE) {
+        return false;
+    }
+
+    // store tag name, array type & element type, then number of elements
+    encodedTag.assign(tag);
+    encodedTag.append(1, Constants::BAM_TAG_TYPE_ARRAY);
+    encodedTag.append(1, TagTypeHelper<T>::TypeCode());
+    const int32_t numElements = values.size();
+    encodedTag.append(reinterpret_cast<const char*>(&numElements), sizeof(int32_t));
+
+    // store elements
+    if (numElements > 0) {
+        encodedTag.append(reinterpret_cast<const char*>(&values[0]), numElements * sizeof(T));
+    }
+    return true;
+}
+
 typedef std::vector<BamAlignment> BamAlignmentVector;
 
 }  // namespace BamTools
@@ -11,6 +11,7 @@
 #define BAM_INDEX_H
 
 #include <string>
+#include <vector>
 #include "api/BamAux.h"
 #include "api/api_global.h"
 
@@ -43,6 +44,18 @@ public:
         STANDARD
     };
 
+    // range of BAM file (virtual) offsets [Start, Stop)
+    struct Chunk
+    {
+        int64_t Start;
+        int64_t Stop;
+
+        Chunk(const int64_t& start = 0, const int64_t& stop = 0)
+            : Start(start)
+            , Stop(stop)
+        {}
+    };
+
     // ctor & dtor
 public:
     BamIndex(Internal::BamReaderPrivate* reader)
@@ -76,6 +89,17 @@ public:
     // returns the 'type' enum for derived index format
     virtual BamIndex::IndexType Type() const = 0;
 
+    // appends file offset ranges holding every alignment that may overlap @region, which
+    // lies on a single reference (its right bound, if any, is on the left bound reference)
+    //   * ranges need not be sorted or distinct, & may hold non-overlapping alignments too
+    //   * returns false if index type does not support this, readers then just jump to
+    //     the first region & read on from there
+    //   * added in 2.6.0, after the other virtuals so that their vtable slots are unchanged
+    virtual bool GetChunks(const BamTools::BamRegion&, std::vector<Chunk>&)
+    {
+        return false;
+    }
+
     //! \cond
 
     // internal methods
@@ -37,6 +37,12 @@ using namespace BamTools;
 /*! \var BamMultiReader::MergeOrder BamMultiReader::MergeByName
     \brief Merge strategy when BAM files are sorted by read name ('queryname')
 */
+/*! \var BamMultiReader::MergeOrder BamMultiReader::MergeByNaturalName
+    \brief Merge strategy when BAM files are sorted by read name, with numbers in names
+    compared by value ('queryname' with sub-sort order 'queryname:natural')
+
+    \sa Algorithms::Sort::ByNaturalName
+*/
 
 /*! \fn BamMultiReader::BamMultiReader()
     \brief constructor
@@ -199,6 +205,40 @@ bool BamMultiReader::GetNextAlignmentCore(BamAlignment& nextAlignment)
     return d->GetNextAlignmentCore(nextAlignment);
 }
 
+/*! \fn std::size_t BamMultiReader::GetNextAlignments(std::vector<BamAlignment>& alignments, const std::size_t maxCount)
+    \brief Retrieves a batch of next available alignments.
+
+    Equivalent to calling GetNextAlignment() up to \a maxCount times, with the same
+    region & merge order semantics. Existing entries in \a alignments are re-used, so passing the same
+    vector to each call avoids re-allocating their data buffers.
+
+    \param[out] alignments destination for alignment records, resized to number retrieved
+    \param[in]  maxCount   maximum number of alignments to retrieve
+    \returns number of alignments retrieved (less than \a maxCount at end of data, or on error)
+    \sa GetNextAlignmentsCore(), BamReader::GetNextAlignments()
+*/
+std::size_t BamMultiReader::GetNextAlignments(std::vector<BamAlignment>& alignments,
+                                              const std::size_t maxCount)
+{
+    return d->GetNextAlignments(alignments, maxCount, false);
+}
+
+/*! \fn std::size_t BamMultiReader::GetNextAlignmentsCore(std::vector<BamAlignment>& alignments, const std::size_t maxCount)
+    \brief Retrieves a batch of next available alignments, without populating their string data fields.
+
+    Equivalent to calling GetNextAlignmentCore() up to \a maxCount times.
+
+    \param[out] alignments destination for alignment records, resized to number retrieved
+    \param[in]  maxCount   maximum number of alignments to retrieve
+    \returns number of alignments retrieved (less than \a maxCount at end of data, or on error)
+    \sa GetNextAlignments(), BamReader::GetNextAlignmentsCore()
+*/
+std::size_t BamMultiReader::GetNextAlignmentsCore(std::vector<BamAlignment>& alignments,
+                                                  const std::size_t maxCount)
+{
+    return d->GetNextAlignments(alignments, maxCount, true);
+}
+
 /*! \fn int BamMultiReader::GetReferenceCount() const
     \brief Returns number of reference sequences.
     \sa BamReader::GetReferenceCount()
@@ -397,6 +437,25 @@ bool BamMultiReader::SetExplicitMergeOrder(BamMultiReader::MergeOrder order)
     return d->SetExplicitMergeOrder(order);
 }
 
+/*! \fn void BamMultiReader::SetNumThreads(int numThreads)
+    \brief Sets the number of threads used to read ahead from the BAM files.
+
+    Default is 1, which reads each file on demand on the calling thread. With more than
+    one thread, each file's next alignments are decompressed & decoded ahead in small
+    batches on a shared pool of worker threads, so merging only picks records that are
+    already loaded. Results are identical either way.
+
+    \note Changing the number of threads is disabled while BAM files are open (i.e. the
+    request will be ignored). Call this method before Open().
+
+    \param[in] numThreads number of read-ahead threads
+    \sa BamReader::SetNumThreads()
+*/
+void BamMultiReader::SetNumThreads(int numThreads)
+{
+    d->SetNumThreads(numThreads);
+}
+
 /*! \fn bool BamMultiReader::SetRegion(const BamRegion& region)
     \brief Sets a target region of interest
 
@@ -440,3 +499,39 @@ bool BamMultiReader::SetRegion(const int& leftRefID, const int& leftPosition, co
 {
     return d->SetRegion(BamRegion(leftRefID, leftPosition, rightRefID, rightPosition));
 }
+
+/*! \fn bool BamMultiReader::SetRegions(const std::vector<BamRegion>& regions)
+    \brief Sets multiple target regions of interest
+
+    Equivalent to calling BamReader::SetRegions() on all open BAM files.
+
+    \param[in] regions desired regions-of-interest to activate
+    \returns \c true if ALL readers set the regions successfully
+    \sa HasIndexes(), SetRegion(), BamReader::SetRegions()
+*/
+bool BamMultiReader::SetRegions(const std::vector<BamRegion>& regions)
+{
+    return d->SetRegions(regions);
+}
+
+/*! \fn void BamMultiReader::SetStableMerge(bool ok)
+    \brief Sets how ties between equal alignments are broken when merging.
+
+    By default, when alignments from several files compare equal under the merge order,
+    they are returned in the order they were loaded from their files, which depends on
+    how far each file has been read. With stable merging enabled, they are returned in
+    the order the files were opened instead. Merging sorted pieces of a file (e.g. the
+    runs of an external sort) then gives the same result as a stable sort of the whole.
+
+    Has no effect on RoundRobinMerge.
+
+    \note Changing tie-breaking is disabled while BAM files are open (i.e. the request
+    will be ignored). Call this method before Open().
+
+    \param[in] ok \c true to break ties by the order files were opened
+    \sa SetExplicitMergeOrder()
+*/
+void BamMultiReader::SetStableMerge(bool ok)
+{
+    d->SetStableMerge(ok);
+}
@@ -33,7 +33,8 @@ public:
     {
         RoundRobinMerge = 0,
         MergeByCoordinate,
-        MergeByName
+        MergeByName,
+        MergeByNaturalName
     };
 
     // constructor / destructor
@@ -67,11 +68,17 @@ public:
     bool Rewind();
     // sets an explicit merge order, regardless of the BAM files' SO header tag
     bool SetExplicitMergeOrder(BamMultiReader::MergeOrder order);
+    // sets the number of threads used to read ahead from the BAM files
+    void SetNumThreads(int numThreads);
     // sets the target region of interest
     bool SetRegion(const BamRegion& region);
     // sets the target region of interest
     bool SetRegion(const int& leftRefID, const int& leftPosition, const int& rightRefID,
                    const int& rightPosition);
+    // sets multiple target regions of interest
+    bool SetRegions(const std::vector<BamRegion>& regions);
+    // breaks ties between equal alignments by the order the files were opened
+    void SetStableMerge(bool ok);
 
     // ----------------------
     // access alignment data
@@ -81,6 +88,12 @@ public:
     bool GetNextAlignment(BamAlignment& alignment);
     // retrieves next available alignment (without populating the alignment's string data fields)
     bool GetNextAlignmentCore(BamAlignment& alignment);
+    // retrieves up to maxCount next available alignments, returns number retrieved
+    std::size_t GetNextAlignments(std::vector<BamAlignment>& alignments,
+                                  const std::size_t maxCount);
+    // retrieves up to maxCount next available alignments (without string data fields)
+    std::size_t GetNextAlignmentsCore(std::vector<BamAlignment>& alignments,
+                                      const std::size_t maxCount);
 
     // ----------------------
     // access auxiliary data
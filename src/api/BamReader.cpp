@@ -180,7 +180,10 @@ bool BamReader::GetNextAlignment(BamAlignment& alignment)
     However, this method does NOT populate the alignment's string data fields
     (read name, bases, qualities, tags, filename). This provides a boost in speed
     when these fields are not required for every alignment. These fields, excluding filename,
-    can be populated 'lazily' (as needed) by calling BamAlignment::BuildCharData() later.
+    can be populated 'lazily' (as needed) by calling BamAlignment::BuildCharData() later,
+    or one at a time with BamAlignment::GetName(), GetQueryBases(), GetQualities(),
+    GetAlignedBases() & GetTagData(). Tag queries such as BamAlignment::GetTag() and
+    BamAlignment::HasTag() work directly on the record's tag data.
 
     \param[out] alignment destination for alignment record data
     \returns \c true if a valid alignment was found
@@ -191,6 +194,40 @@ bool BamReader::GetNextAlignmentCore(BamAlignment& alignment)
     return d->GetNextAlignmentCore(alignment);
 }
 
+/*! \fn std::size_t BamReader::GetNextAlignments(std::vector<BamAlignment>& alignments, const std::size_t maxCount)
+    \brief Retrieves a batch of next available alignments.
+
+    Equivalent to calling GetNextAlignment() up to \a maxCount times, with the same
+    region semantics. Existing entries in \a alignments are re-used, so passing the same
+    vector to each call avoids re-allocating their data buffers.
+
+    \param[out] alignments destination for alignment records, resized to number retrieved
+    \param[in]  maxCount   maximum number of alignments to retrieve
+    \returns number of alignments retrieved (less than \a maxCount at end of data, or on error)
+    \sa GetNextAlignmentsCore(), GetErrorString()
+*/
+std::size_t BamReader::GetNextAlignments(std::vector<BamAlignment>& alignments,
+                                         const std::size_t maxCount)
+{
+    return d->GetNextAlignments(alignments, maxCount, false);
+}
+
+/*! \fn std::size_t BamReader::GetNextAlignmentsCore(std::vector<BamAlignment>& alignments, const std::size_t maxCount)
+    \brief Retrieves a batch of next available alignments, without populating their string data fields.
+
+    Equivalent to calling GetNextAlignmentCore() up to \a maxCount times.
+
+    \param[out] alignments destination for alignment records, resized to number retrieved
+    \param[in]  maxCount   maximum number of alignments to retrieve
+    \returns number of alignments retrieved (less than \a maxCount at end of data, or on error)
+    \sa GetNextAlignments(), GetErrorString()
+*/
+std::size_t BamReader::GetNextAlignmentsCore(std::vector<BamAlignment>& alignments,
+                                             const std::size_t maxCount)
+{
+    return d->GetNextAlignments(alignments, maxCount, true);
+}
+
 /*! \fn int BamReader::GetReferenceCount() const
     \brief Returns number of reference sequences.
 */
@@ -347,6 +384,25 @@ void BamReader::SetIndex(BamIndex* index)
     d->SetIndex(index);
 }
 
+/*! \fn void BamReader::SetNumThreads(int numThreads)
+    \brief Sets the number of threads used to decompress BGZF blocks.
+
+    Default is 1, which decompresses each block on demand on the calling thread. With more
+    than one thread, the reader reads several compressed blocks ahead and inflates them on a
+    pool of worker threads, handing them back in file order. Jump(), SetRegion() and Rewind()
+    discard any read-ahead blocks that are no longer needed.
+
+    \note Changing the number of threads is disabled on open files (i.e. the request will
+    be ignored). Be sure to call this function before opening the BAM file.
+
+    \param[in] numThreads number of decompression threads
+    \sa Open()
+*/
+void BamReader::SetNumThreads(int numThreads)
+{
+    d->SetNumThreads(numThreads);
+}
+
 /*! \fn bool BamReader::SetRegion(const BamRegion& region)
     \brief Sets a target region of interest
 
@@ -401,6 +457,30 @@ bool BamReader::SetRegion(const int& leftRefID, const int& leftBound, const int&
     return d->SetRegion(BamRegion(leftRefID, leftBound, rightRefID, rightBound));
 }
 
+/*! \fn bool BamReader::SetRegions(const std::vector<BamRegion>& regions)
+    \brief Sets multiple target regions of interest
+
+    Requires that index data be available. Regions may be given in any order
+    and may overlap each other.
+
+    Subsequent calls to GetNextAlignment() or GetNextAlignmentCore()
+    will only return \c true when alignments can be found that overlap
+    any of the \a regions. Each such alignment is returned once, in file order.
+
+    The index is used to read only those parts of the BAM file that may hold
+    overlapping alignments, so this is much cheaper than a SetRegion() call
+    (and re-scan) per region.
+
+    \param[in] regions desired regions-of-interest to activate
+
+    \returns \c true if regions were valid & reader was able to jump to the first one
+    \sa HasIndex(), SetRegion()
+*/
+bool BamReader::SetRegions(const std::vector<BamRegion>& regions)
+{
+    return d->SetRegions(regions);
+}
+
 int64_t BamReader::Tell() const
 {
     return d->Tell();
@@ -10,7 +10,9 @@
 #ifndef BAMREADER_H
 #define BAMREADER_H
 
+#include <cstddef>
 #include <string>
+#include <vector>
 #include "api/BamAlignment.h"
 #include "api/BamIndex.h"
 #include "api/SamHeader.h"
@@ -48,11 +50,15 @@ public:
     bool Open(const std::string& filename);
     // returns internal file pointer to beginning of alignment data
     bool Rewind();
+    // sets the number of threads used to decompress BAM data
+    void SetNumThreads(int numThreads);
     // sets the target region of interest
     bool SetRegion(const BamRegion& region);
     // sets the target region of interest
     bool SetRegion(const int& leftRefID, const int& leftPosition, const int& rightRefID,
                    const int& rightPosition);
+    // sets multiple target regions of interest
+    bool SetRegions(const std::vector<BamRegion>& regions);
     int64_t Tell() const;
 
     // ----------------------
@@ -63,6 +69,12 @@ public:
     bool GetNextAlignment(BamAlignment& alignment);
     // retrieves next available alignmnet (without populating the alignment's string data fields)
     bool GetNextAlignmentCore(BamAlignment& alignment);
+    // retrieves up to maxCount next available alignments, returns number retrieved
+    std::size_t GetNextAlignments(std::vector<BamAlignment>& alignments,
+                                  const std::size_t maxCount);
+    // retrieves up to maxCount next available alignments (without string data fields)
+    std::size_t GetNextAlignmentsCore(std::vector<BamAlignment>& alignments,
+                                      const std::size_t maxCount);
 
     // ----------------------
     // access header data
@@ -30,6 +30,26 @@ using namespace BamTools::Internal;
     It would be wasteful to compress, and then immediately decompress
     the data.
 */
+/*! \enum BamTools::BamWriter::CompressionStrategy
+    \brief This enum describes the zlib deflate strategies available for output BAM files.
+*/
+/*! \var BamWriter::CompressionStrategy BamWriter::DefaultStrategy
+    \brief Normal deflate compression (Z_DEFAULT_STRATEGY)
+*/
+/*! \var BamWriter::CompressionStrategy BamWriter::Filtered
+    \brief Favor Huffman coding over string matching (Z_FILTERED)
+*/
+/*! \var BamWriter::CompressionStrategy BamWriter::HuffmanOnly
+    \brief Huffman coding only, no string matching (Z_HUFFMAN_ONLY)
+*/
+/*! \var BamWriter::CompressionStrategy BamWriter::RunLength
+    \brief Limit string matching to run-length encoding (Z_RLE)
+
+    Often nearly as small as the default strategy on BAM data, at a fraction of the cost.
+*/
+/*! \var BamWriter::CompressionStrategy BamWriter::Fixed
+    \brief Use fixed Huffman codes only (Z_FIXED)
+*/
 
 /*! \fn BamWriter::BamWriter()
     \brief constructor
@@ -131,6 +151,57 @@ bool BamWriter::SaveAlignment(const BamAlignment& alignment)
     return d->SaveAlignment(alignment);
 }
 
+/*! \fn bool BamWriter::SaveRawAlignment(const BamAlignment& alignment)
+    \brief Saves an alignment to the BAM file, passing its raw record data through if possible.
+
+    For an alignment read by BamReader/BamMultiReader whose character data has not been
+    modified since, the original name, CIGAR, sequence, qualities & tags are copied straight
+    into the output, instead of being re-encoded from BamAlignment's string fields. Core
+    fields (position, flags, etc.) are always written from their current values.
+
+    Alignments changed through the tag methods (AddTag(), EditTag(), RemoveTag(), etc.), or
+    whose Name, QueryBases, Qualities, CigarData or TagData no longer match the raw data, are
+    encoded just like SaveAlignment() does. Checking this costs a comparison of those fields
+    against the raw data, which is still much cheaper than encoding them.
+
+    \note As with SaveAlignment(), alignments read by GetNextAlignmentCore() (and not
+    expanded by BuildCharData() since) are always written from their raw char data.
+
+    \param[in] alignment BamAlignment record to save
+    \sa SaveAlignment()
+*/
+bool BamWriter::SaveRawAlignment(const BamAlignment& alignment)
+{
+    return d->SaveRawAlignment(alignment);
+}
+
+/*! \fn void BamWriter::SetCompressionLevel(int level)
+    \brief Sets the output compression level.
+
+    Levels follow zlib: 0 stores blocks uncompressed, 1 is fastest, 9 gives the
+    smallest output. A negative value selects zlib's default level (currently 6),
+    and values above 9 are treated as 9.
+
+    This overrides any level previously chosen with SetCompressionMode(), and vice versa.
+
+    \note Changing the compression level is disabled on open files (i.e. the request will
+    be ignored). Be sure to call this function before opening the BAM file.
+
+    \code
+        BamWriter writer;
+        writer.SetCompressionLevel(1);
+        writer.Open( ... );
+        // ...
+    \endcode
+
+    \param[in] level desired output compression level
+    \sa SetCompressionMode(), SetCompressionStrategy()
+*/
+void BamWriter::SetCompressionLevel(int level)
+{
+    d->SetCompressionLevel(level);
+}
+
 /*! \fn void BamWriter::SetCompressionMode(const BamWriter::CompressionMode& compressionMode)
     \brief Sets the output compression mode.
 
@@ -153,3 +224,44 @@ void BamWriter::SetCompressionMode(const BamWriter::CompressionMode& compression
 {
     d->SetWriteCompressed(compressionMode == BamWriter::Compressed);
 }
+
+/*! \fn void BamWriter::SetCompressionStrategy(const BamWriter::CompressionStrategy& strategy)
+    \brief Sets the output compression strategy.
+
+    Default strategy is BamWriter::DefaultStrategy.
+
+    \note Changing the compression strategy is disabled on open files (i.e. the request will
+    be ignored). Be sure to call this function before opening the BAM file.
+
+    \param[in] strategy desired zlib deflate strategy
+    \sa SetCompressionLevel()
+*/
+void BamWriter::SetCompressionStrategy(const BamWriter::CompressionStrategy& strategy)
+{
+    d->SetCompressionStrategy(strategy);
+}
+
+/*! \fn void BamWriter::SetNumThreads(int numThreads)
+    \brief Sets the number of threads used to compress output BGZF blocks.
+
+    Default is 1, which compresses each block on the calling thread. With more than one
+    thread, filled blocks are queued to a pool of worker threads and written to the output
+    in their original order, so the resulting file is byte-identical to single-threaded output.
+
+    \note Changing the number of threads is disabled on open files (i.e. the request will
+    be ignored). Be sure to call this function before opening the BAM file.
+
+    \code
+        BamWriter writer;
+        writer.SetNumThreads(4);
+        writer.Open( ... );
+        // ...
+    \endcode
+
+    \param[in] numThreads number of compression threads
+    \sa SetCompressionMode(), Open()
+*/
+void BamWriter::SetNumThreads(int numThreads)
+{
+    d->SetNumThreads(numThreads);
+}
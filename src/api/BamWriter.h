@@ -36,6 +36,15 @@ public:
         Uncompressed
     };
 
+    enum CompressionStrategy
+    {
+        DefaultStrategy = 0,
+        Filtered,
+        HuffmanOnly,
+        RunLength,
+        Fixed
+    };
+
     // ctor & dtor
 public:
     BamWriter();
@@ -57,8 +66,16 @@ public:
               const RefVector& referenceSequences);
     // saves the alignment to the alignment archive
     bool SaveAlignment(const BamAlignment& alignment);
+    // saves the alignment, copying its raw record data if it is unmodified since read
+    bool SaveRawAlignment(const BamAlignment& alignment);
+    // sets the output compression level
+    void SetCompressionLevel(int level);
     // sets the output compression mode
     void SetCompressionMode(const BamWriter::CompressionMode& compressionMode);
+    // sets the output compression strategy
+    void SetCompressionStrategy(const BamWriter::CompressionStrategy& strategy);
+    // sets the number of threads used to compress output blocks
+    void SetNumThreads(int numThreads);
 
     // private implementation
 private:
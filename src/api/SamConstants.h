@@ -31,6 +31,7 @@ const std::string SAM_HD_BEGIN_TOKEN = "@HD";
 const std::string SAM_HD_VERSION_TAG = "VN";
 const std::string SAM_HD_SORTORDER_TAG = "SO";
 const std::string SAM_HD_GROUPORDER_TAG = "GO";
+const std::string SAM_HD_SUBSORTORDER_TAG = "SS";  // stored in SamHeader::CustomTags
 
 // SQ entries
 const std::string SAM_SQ_BEGIN_TOKEN = "@SQ";
@@ -73,6 +74,9 @@ const std::string SAM_HD_SORTORDER_QUERYNAME = "queryname";
 const std::string SAM_HD_SORTORDER_UNKNOWN = "unknown";
 const std::string SAM_HD_SORTORDER_UNSORTED = "unsorted";
 
+// HD:SS values
+const std::string SAM_HD_SUBSORTORDER_QUERYNAME_NATURAL = "queryname:natural";
+
 // HD:GO values
 const std::string SAM_HD_GROUPORDER_NONE = "none";
 const std::string SAM_HD_GROUPORDER_QUERY = "query";
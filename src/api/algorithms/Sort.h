@@ -13,8 +13,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 #include "api/BamAlignment.h"
 #include "api/BamMultiReader.h"
@@ -101,6 +103,148 @@ struct API_EXPORT Sort
         const Sort::Order m_order;
     };
 
+    /*! \struct BamTools::Algorithms::Sort::ByNaturalName
+        \brief Function object for comparing alignments by name, with numbers compared by value
+
+        Runs of digits in read names are compared as numbers (e.g. "read9" comes before
+        "read10"), everything else character by character. This is the order used by
+        'samtools sort -n'.
+
+        Default sort order is Sort::AscendingOrder.
+
+        \code
+            std::vector<BamAlignment> a;
+
+            // sort by name, in natural ascending order
+            std::stable_sort( a.begin(), a.end(), Sort::ByNaturalName() );
+        \endcode
+    */
+    struct ByNaturalName
+    {
+
+        // ctor
+        ByNaturalName(const Sort::Order& order = Sort::AscendingOrder)
+            : m_order(order)
+        {}
+
+        // comparison function
+        bool operator()(const BamTools::BamAlignment& lhs, const BamTools::BamAlignment& rhs) const
+        {
+            const int result = CompareNames(lhs.Name.c_str(), rhs.Name.c_str());
+            return (m_order == Sort::AscendingOrder ? result < 0 : result > 0);
+        }
+
+        // compares null-terminated names, returns <0, 0 or >0 like strcmp()
+        static int CompareNames(const char* lhs, const char* rhs)
+        {
+            const unsigned char* l = reinterpret_cast<const unsigned char*>(lhs);
+            const unsigned char* r = reinterpret_cast<const unsigned char*>(rhs);
+            while (*l && *r) {
+
+                // compare characters
+                if (!IsDigit(*l) || !IsDigit(*r)) {
+                    if (*l != *r) {
+                        return static_cast<int>(*l) - static_cast<int>(*r);
+                    }
+                    ++l;
+                    ++r;
+                    continue;
+                }
+
+                // compare numbers: skip leading zeros & common leading digits
+                while (*l == '0') {
+                    ++l;
+                }
+                while (*r == '0') {
+                    ++r;
+                }
+                while (IsDigit(*l) && *l == *r) {
+                    ++l;
+                    ++r;
+                }
+
+                // the longer number is larger, otherwise the first differing digit decides
+                const int diff = static_cast<int>(*l) - static_cast<int>(*r);
+                while (IsDigit(*l) && IsDigit(*r)) {
+                    ++l;
+                    ++r;
+                }
+                if (IsDigit(*l)) {
+                    return 1;
+                }
+                if (IsDigit(*r)) {
+                    return -1;
+                }
+                if (diff != 0) {
+                    return diff;
+                }
+            }
+            return (*l ? 1 : (*r ? -1 : 0));
+        }
+
+        // used by BamMultiReader internals
+        static bool UsesCharData()
+        {
+            return true;
+        }
+
+        // internal methods
+    private:
+        static bool IsDigit(unsigned char c)
+        {
+            return (c >= '0' && c <= '9');
+        }
+
+        // data members
+    private:
+        const Sort::Order m_order;
+    };
+
+    /*! \struct BamTools::Algorithms::Sort::PositionKey
+        \brief Function object for computing an alignment's 64-bit position key
+
+        Keys order alignments exactly like Sort::ByPosition does (including unmapped alignments
+        always coming last), so sorting by key with SortByKey() gives the same order as a
+        stable sort using Sort::ByPosition.
+
+        \code
+            std::vector<BamAlignment> a;
+
+            // radix sort by position (the following two lines are equivalent):
+            Sort::SortByKey( a, Sort::PositionKey() );
+            Sort::SortAlignments( a, Sort::ByPosition() );
+        \endcode
+    */
+    struct PositionKey
+    {
+
+        // ctor
+        PositionKey(const Sort::Order& order = Sort::AscendingOrder)
+            : m_order(order)
+        {}
+
+        // key function
+        uint64_t operator()(const BamTools::BamAlignment& al) const
+        {
+
+            // force unmapped alignments to end
+            const uint64_t unmappedKey = static_cast<uint64_t>(0xFFFFFFFF) << 32;
+            if (al.RefID == -1) {
+                return unmappedKey;
+            }
+
+            // (refID, position), offset so that negative values order first
+            const uint32_t refKey = static_cast<uint32_t>(al.RefID) ^ 0x80000000;
+            const uint32_t posKey = static_cast<uint32_t>(al.Position) ^ 0x80000000;
+            const uint64_t key = (static_cast<uint64_t>(refKey) << 32) | posKey;
+            return (m_order == Sort::AscendingOrder ? key : unmappedKey - 1 - key);
+        }
+
+        // data members
+    private:
+        const Sort::Order m_order;
+    };
+
     /*! \struct BamTools::Algorithms::Sort::ByPosition
         \brief Function object for comparing alignments by position
 
@@ -146,6 +290,12 @@ struct API_EXPORT Sort
             return sort_helper(m_order, lhs.RefID, rhs.RefID);
         }
 
+        // key function giving the same order, see SortByKey()
+        PositionKey GetKeyFunction() const
+        {
+            return PositionKey(m_order);
+        }
+
         // used by BamMultiReader internals
         static bool UsesCharData()
         {
@@ -259,6 +409,111 @@ struct API_EXPORT Sort
         std::sort(data.begin(), data.end(), comp);
     }
 
+    /*! Sorts a std::vector of alignments (in-place) by position.
+
+        Uses a radix sort on position keys (see SortByKey()), which is much faster than
+        comparison sorting whole alignments. Alignments at the same position keep their order.
+
+        \param[in,out] data vector of alignments to be sorted
+        \param[in]     comp position comparison function object, determines sort order
+    */
+    static void SortAlignments(std::vector<BamAlignment>& data, const ByPosition& comp)
+    {
+        SortByKey(data, comp.GetKeyFunction());
+    }
+
+    /*! Sorts a std::vector (in-place) by 64-bit keys, using an LSD radix sort.
+
+        Keys are computed once per element, then sorted together with each element's index,
+        one byte at a time (skipping bytes that are the same for all keys). Finally the
+        elements are moved into sorted order in one pass, so each is moved only once however
+        large it is. The sort is stable: elements with equal keys keep their order.
+
+        \code
+            std::vector<BamAlignment> a;
+            // populate data
+
+            // sort our alignment list by position
+            Sort::SortByKey(a, Sort::PositionKey());
+        \endcode
+
+        \param[in,out] data   vector of elements to be sorted
+        \param[in]     getKey function object, returns the uint64_t key of an element
+    */
+    template <typename T, typename KeyFunction>
+    static void SortByKey(std::vector<T>& data, const KeyFunction& getKey)
+    {
+        const std::size_t size = data.size();
+        if (size < 2) {
+            return;
+        }
+
+        // compute keys
+        std::vector<KeyIndex> keys(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            keys[i].Key = getKey(data[i]);
+            keys[i].Index = i;
+        }
+
+        // sort keys, then move elements into place
+        RadixSortKeys(keys);
+        std::vector<T> sorted;
+        sorted.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            sorted.push_back(std::move(data[keys[i].Index]));
+        }
+        data.swap(sorted);
+    }
+
+    //! \internal
+    // key & original index of an element, sorted by SortByKey()
+    struct KeyIndex
+    {
+        uint64_t Key;
+        std::size_t Index;
+    };
+
+    /*! \fn static void RadixSortKeys(std::vector<KeyIndex>& keys)
+        \internal
+
+        Stable LSD radix sort of keys, 8 bits per pass.
+    */
+    static void RadixSortKeys(std::vector<KeyIndex>& keys)
+    {
+        const std::size_t size = keys.size();
+
+        // find which bytes differ between keys, others need no pass
+        uint64_t differentBits = 0;
+        for (std::size_t i = 1; i < size; ++i) {
+            differentBits |= (keys[i].Key ^ keys[0].Key);
+        }
+
+        std::vector<KeyIndex> buffer(size);
+        for (unsigned int shift = 0; shift < 64; shift += 8) {
+            if (((differentBits >> shift) & 0xFF) == 0) {
+                continue;
+            }
+
+            // count keys per byte value, then turn counts into output offsets
+            std::size_t offsets[256] = {0};
+            for (std::size_t i = 0; i < size; ++i) {
+                ++offsets[(keys[i].Key >> shift) & 0xFF];
+            }
+            std::size_t total = 0;
+            for (unsigned int b = 0; b < 256; ++b) {
+                const std::size_t count = offsets[b];
+                offsets[b] = total;
+                total += count;
+            }
+
+            // scatter keys into buffer, keeping order within each byte value
+            for (std::size_t i = 0; i < size; ++i) {
+                buffer[offsets[(keys[i].Key >> shift) & 0xFF]++] = keys[i];
+            }
+            keys.swap(buffer);
+        }
+    }
+
     /*! Returns a sorted copy of the input alignments, using the provided compare function.
 
         \code
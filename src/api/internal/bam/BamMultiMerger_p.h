@@ -23,10 +23,10 @@
 //
 // We mean it.
 
+#include <cstddef>
 #include <deque>
-#include <functional>
-#include <set>
 #include <string>
+#include <vector>
 #include "api/BamAlignment.h"
 #include "api/BamReader.h"
 #include "api/algorithms/Sort.h"
@@ -34,38 +34,95 @@
 namespace BamTools {
 namespace Internal {
 
+class BamReaderPrefetcher;
+
 struct API_NO_EXPORT MergeItem
 {
 
     // data members
     BamReader* Reader;
     BamAlignment* Alignment;
+    BamReaderPrefetcher* Prefetcher;  // reads ahead from Reader, if enabled
+    std::size_t Index;                // order in which Reader was opened
 
     // ctors & dtor
-    MergeItem(BamReader* reader = 0, BamAlignment* alignment = 0)
+    MergeItem(BamReader* reader = 0, BamAlignment* alignment = 0,
+              BamReaderPrefetcher* prefetcher = 0, std::size_t index = 0)
         : Reader(reader)
         , Alignment(alignment)
+        , Prefetcher(prefetcher)
+        , Index(index)
     {}
 };
 
+// precomputed sort keys, so most merge comparisons avoid touching the alignments
+//
+// Keys are built from the merger's Compare object & must order alignments consistently
+// with it, including its Sort::Order. If IsExact, equal keys mean equal alignments;
+// otherwise ties are resolved by Compare itself.
 template <typename Compare>
-struct API_NO_EXPORT MergeItemSorter
+struct API_NO_EXPORT MergeKey
 {
+    static const bool IsExact = false;
+    explicit MergeKey(const Compare&) {}
+    uint64_t operator()(const BamAlignment&) const
+    {
+        return 0;
+    }
+};
 
-public:
-    MergeItemSorter(const Compare& comp = Compare())
-        : m_comp(comp)
+// (refID, position) packed into 64 bits, with unmapped (refID -1) alignments last
+template <>
+struct API_NO_EXPORT MergeKey<Algorithms::Sort::ByPosition>
+{
+    static const bool IsExact = true;
+    explicit MergeKey(const Algorithms::Sort::ByPosition& comp)
+        : m_key(comp.GetKeyFunction())
+    {}
+    uint64_t operator()(const BamAlignment& al) const
+    {
+        return m_key(al);
+    }
+
+private:
+    Algorithms::Sort::PositionKey m_key;
+};
+
+// first 8 characters of read name, big-endian so that keys compare like the names do
+// (inverted for descending order)
+template <>
+struct API_NO_EXPORT MergeKey<Algorithms::Sort::ByName>
+{
+    static const bool IsExact = false;
+    explicit MergeKey(const Algorithms::Sort::ByName& comp)
+        : m_isDescending(IsDescending(comp))
     {}
+    uint64_t operator()(const BamAlignment& al) const
+    {
+        uint64_t key = 0;
+        const std::size_t nameLength = al.Name.size();
+        for (std::size_t i = 0; i < 8; ++i) {
+            key <<= 8;
+            if (i < nameLength) {
+                key |= static_cast<unsigned char>(al.Name[i]);
+            }
+        }
+        return (m_isDescending ? ~key : key);
+    }
 
-    bool operator()(const MergeItem& lhs, const MergeItem& rhs) const
+private:
+    // ByName doesn't expose its order, so ask it to compare two names
+    static bool IsDescending(const Algorithms::Sort::ByName& comp)
     {
-        const BamAlignment& l = *lhs.Alignment;
-        const BamAlignment& r = *rhs.Alignment;
-        return m_comp(l, r);
+        BamAlignment a;
+        BamAlignment b;
+        a.Name = "a";
+        b.Name = "b";
+        return comp(b, a);
     }
 
 private:
-    Compare m_comp;
+    bool m_isDescending;
 };
 
 // pure ABC so we can just work polymorphically with any specific merger implementation
@@ -84,21 +141,31 @@ public:
     virtual void Remove(BamReader* reader) = 0;
     virtual int Size() const = 0;
     virtual MergeItem TakeFirst() = 0;
+    virtual void UpdateFirst() = 0;
 };
 
 // general merger
+//
+// Keeps one entry per reader in a binary min-heap. Entries with equal alignments come out
+// in the order they were added, same as the std::multiset this replaces. If isStable, they
+// come out in the order their readers were opened instead, so merging sorted files is stable:
+// the result does not depend on how the alignments were split between the files. UpdateFirst()
+// re-sorts the first entry in place after its reader loads the next alignment, so the
+// usual pop-then-refill step of a merge costs a single sift & no allocation.
 template <typename Compare>
 class API_NO_EXPORT MultiMerger : public IMultiMerger
 {
 
 public:
     typedef Compare CompareType;
-    typedef MergeItemSorter<CompareType> MergeType;
 
 public:
-    explicit MultiMerger(const Compare& comp = Compare())
+    explicit MultiMerger(const Compare& comp = Compare(), const bool isStable = false)
         : IMultiMerger()
-        , m_data(MergeType(comp))
+        , m_comp(comp)
+        , m_key(comp)
+        , m_isStable(isStable)
+        , m_nextSequence(0)
     {}
 
 public:
@@ -109,26 +176,35 @@ public:
     void Remove(BamReader* reader);
     int Size() const;
     MergeItem TakeFirst();
+    void UpdateFirst();
 
 private:
-    typedef MergeItem ValueType;
-    typedef std::multiset<ValueType, MergeType> ContainerType;
-    typedef typename ContainerType::iterator DataIterator;
-    typedef typename ContainerType::const_iterator DataConstIterator;
+    struct Entry
+    {
+        MergeItem Item;
+        uint64_t Key;       // m_key of item's alignment
+        uint64_t Sequence;  // insertion order, breaks ties between equal alignments
+    };
+    bool IsLess(const Entry& lhs, const Entry& rhs) const;
+    void SetEntry(Entry& entry, const MergeItem& item);
+    void SiftDown(std::size_t index);
+    void SiftUp(std::size_t index);
+
+private:
+    typedef std::vector<Entry> ContainerType;
     ContainerType m_data;
+    Compare m_comp;
+    MergeKey<Compare> m_key;
+    bool m_isStable;
+    uint64_t m_nextSequence;
 };
 
 template <typename Compare>
 void MultiMerger<Compare>::Add(MergeItem item)
 {
-
-    // N.B. - any future custom Compare types must define this method
-    //        see algorithms/Sort.h
-
-    if (CompareType::UsesCharData()) {
-        item.Alignment->BuildCharData();
-    }
-    m_data.insert(item);
+    m_data.push_back(Entry());
+    SetEntry(m_data.back(), item);
+    SiftUp(m_data.size() - 1);
 }
 
 template <typename Compare>
@@ -140,8 +216,7 @@ void MultiMerger<Compare>::Clear()
 template <typename Compare>
 const MergeItem& MultiMerger<Compare>::First() const
 {
-    const ValueType& entry = (*m_data.begin());
-    return entry;
+    return m_data.front().Item;
 }
 
 template <typename Compare>
@@ -149,6 +224,29 @@ bool MultiMerger<Compare>::IsEmpty() const
 {
     return m_data.empty();
 }
+
+template <typename Compare>
+bool MultiMerger<Compare>::IsLess(const Entry& lhs, const Entry& rhs) const
+{
+    if (lhs.Key != rhs.Key) {
+        return lhs.Key < rhs.Key;
+    }
+    if (!MergeKey<Compare>::IsExact) {
+        const BamAlignment& l = *lhs.Item.Alignment;
+        const BamAlignment& r = *rhs.Item.Alignment;
+        if (m_comp(l, r)) {
+            return true;
+        }
+        if (m_comp(r, l)) {
+            return false;
+        }
+    }
+    if (m_isStable) {
+        return lhs.Item.Index < rhs.Item.Index;
+    }
+    return lhs.Sequence < rhs.Sequence;
+}
+
 template <typename Compare>
 void MultiMerger<Compare>::Remove(BamReader* reader)
 {
@@ -159,22 +257,77 @@ void MultiMerger<Compare>::Remove(BamReader* reader)
     const std::string& filenameToRemove = reader->GetFilename();
 
     // iterate over readers in cache
-    DataIterator dataIter = m_data.begin();
-    DataIterator dataEnd = m_data.end();
-    for (; dataIter != dataEnd; ++dataIter) {
-        const MergeItem& item = (*dataIter);
-        const BamReader* itemReader = item.Reader;
+    for (std::size_t i = 0; i < m_data.size(); ++i) {
+        const BamReader* itemReader = m_data[i].Item.Reader;
         if (itemReader == 0) {
             continue;
         }
 
-        // remove iterator on match
+        // remove entry on match, moving last entry into its place
         if (itemReader->GetFilename() == filenameToRemove) {
-            m_data.erase(dataIter);
+            m_data[i] = m_data.back();
+            m_data.pop_back();
+            if (i < m_data.size()) {
+                SiftDown(i);
+                SiftUp(i);
+            }
             return;
         }
     }
 }
+
+template <typename Compare>
+void MultiMerger<Compare>::SetEntry(Entry& entry, const MergeItem& item)
+{
+
+    // N.B. - any future custom Compare types must define this method
+    //        see algorithms/Sort.h
+
+    if (CompareType::UsesCharData()) {
+        item.Alignment->BuildCharData();
+    }
+    entry.Item = item;
+    entry.Key = m_key(*item.Alignment);
+    entry.Sequence = m_nextSequence++;
+}
+
+template <typename Compare>
+void MultiMerger<Compare>::SiftDown(std::size_t index)
+{
+    const std::size_t size = m_data.size();
+    const Entry entry = m_data[index];
+    while (true) {
+        std::size_t child = 2 * index + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && IsLess(m_data[child + 1], m_data[child])) {
+            ++child;
+        }
+        if (!IsLess(m_data[child], entry)) {
+            break;
+        }
+        m_data[index] = m_data[child];
+        index = child;
+    }
+    m_data[index] = entry;
+}
+
+template <typename Compare>
+void MultiMerger<Compare>::SiftUp(std::size_t index)
+{
+    const Entry entry = m_data[index];
+    while (index > 0) {
+        const std::size_t parent = (index - 1) / 2;
+        if (!IsLess(entry, m_data[parent])) {
+            break;
+        }
+        m_data[index] = m_data[parent];
+        index = parent;
+    }
+    m_data[index] = entry;
+}
+
 template <typename Compare>
 int MultiMerger<Compare>::Size() const
 {
@@ -184,12 +337,22 @@ int MultiMerger<Compare>::Size() const
 template <typename Compare>
 MergeItem MultiMerger<Compare>::TakeFirst()
 {
-    DataIterator firstIter = m_data.begin();
-    MergeItem firstItem = (*firstIter);
-    m_data.erase(firstIter);
+    const MergeItem firstItem = m_data.front().Item;
+    m_data.front() = m_data.back();
+    m_data.pop_back();
+    if (!m_data.empty()) {
+        SiftDown(0);
+    }
     return firstItem;
 }
 
+template <typename Compare>
+void MultiMerger<Compare>::UpdateFirst()
+{
+    SetEntry(m_data.front(), m_data.front().Item);
+    SiftDown(0);
+}
+
 // unsorted "merger"
 template <>
 class API_NO_EXPORT MultiMerger<Algorithms::Sort::Unsorted> : public IMultiMerger
@@ -208,6 +371,7 @@ public:
     void Remove(BamReader* reader);
     int Size() const;
     MergeItem TakeFirst();
+    void UpdateFirst();
 
 private:
     typedef MergeItem ValueType;
@@ -275,6 +439,12 @@ inline MergeItem MultiMerger<Algorithms::Sort::Unsorted>::TakeFirst()
     return firstItem;
 }
 
+inline void MultiMerger<Algorithms::Sort::Unsorted>::UpdateFirst()
+{
+    m_data.push_back(m_data.front());
+    m_data.pop_front();
+}
+
 }  // namespace Internal
 }  // namespace BamTools
 
@@ -12,6 +12,8 @@
 #include "api/BamMultiReader.h"
 #include "api/SamConstants.h"
 #include "api/algorithms/Sort.h"
+#include "api/internal/bam/BamReaderPrefetcher_p.h"
+#include "api/internal/utils/BamThreadPool_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
@@ -26,7 +28,10 @@ using namespace BamTools::Internal;
 BamMultiReaderPrivate::BamMultiReaderPrivate()
     : m_alignmentCache(0)
     , m_hasUserMergeOrder(false)
+    , m_isStableMerge(false)
     , m_mergeOrder(BamMultiReader::RoundRobinMerge)
+    , m_numThreads(1)
+    , m_threadPool(0)
 {}
 
 // dtor
@@ -102,6 +107,10 @@ bool BamMultiReaderPrivate::CloseFiles(const std::vector<std::string>& filenames
                 // remove reader's entry from alignment cache
                 m_alignmentCache->Remove(reader);
 
+                // stop reading ahead (waits for reader to be idle)
+                delete item.Prefetcher;
+                item.Prefetcher = 0;
+
                 // clean up reader & its alignment
                 if (!reader->Close()) {
                     m_errorString.append(1, '\t');
@@ -140,6 +149,10 @@ bool BamMultiReaderPrivate::CloseFiles(const std::vector<std::string>& filenames
         // reset merge flags
         m_hasUserMergeOrder = false;
         m_mergeOrder = BamMultiReader::RoundRobinMerge;
+
+        // clean up read-ahead workers
+        delete m_threadPool;
+        m_threadPool = 0;
     }
 
     // return whether all readers closed OK
@@ -164,13 +177,20 @@ bool BamMultiReaderPrivate::CreateIndexes(const BamIndex::IndexType& type)
         }
 
         // if reader doesn't have an index, create one
+        // (this rewinds the reader, so any read-ahead restarts from there)
         if (!reader->HasIndex()) {
+            if (item.Prefetcher) {
+                item.Prefetcher->Reset();
+            }
             if (!reader->CreateIndex(type)) {
                 m_errorString.append(1, '\t');
                 m_errorString.append(reader->GetErrorString());
                 m_errorString.append(1, '\n');
                 errorsEncountered = true;
             }
+            if (item.Prefetcher) {
+                item.Prefetcher->Start();
+            }
         }
     }
 
@@ -199,9 +219,16 @@ IMultiMerger* BamMultiReaderPrivate::CreateAlignmentCache()
         if (header.SortOrder == Constants::SAM_HD_SORTORDER_COORDINATE) {
             m_mergeOrder = BamMultiReader::MergeByCoordinate;
 
-            // if BAM files are sorted by read name
+            // if BAM files are sorted by read name (naturally, if sub-sort order says so)
         } else if (header.SortOrder == Constants::SAM_HD_SORTORDER_QUERYNAME) {
             m_mergeOrder = BamMultiReader::MergeByName;
+            for (std::size_t i = 0; i < header.CustomTags.size(); ++i) {
+                const CustomHeaderTag& tag = header.CustomTags[i];
+                if (tag.TagName == Constants::SAM_HD_SUBSORTORDER_TAG &&
+                    tag.TagValue == Constants::SAM_HD_SUBSORTORDER_QUERYNAME_NATURAL) {
+                    m_mergeOrder = BamMultiReader::MergeByNaturalName;
+                }
+            }
 
             // otherwise, sorting is either "unknown" or marked as "unsorted"
         } else {
@@ -214,11 +241,18 @@ IMultiMerger* BamMultiReaderPrivate::CreateAlignmentCache()
 
         // merge BAM files by position
         case BamMultiReader::MergeByCoordinate:
-            return new MultiMerger<Algorithms::Sort::ByPosition>();
+            return new MultiMerger<Algorithms::Sort::ByPosition>(Algorithms::Sort::ByPosition(),
+                                                                 m_isStableMerge);
 
         // merge BAM files by read name
         case BamMultiReader::MergeByName:
-            return new MultiMerger<Algorithms::Sort::ByName>();
+            return new MultiMerger<Algorithms::Sort::ByName>(Algorithms::Sort::ByName(),
+                                                             m_isStableMerge);
+
+        // merge BAM files by read name, comparing numbers in names by value
+        case BamMultiReader::MergeByNaturalName:
+            return new MultiMerger<Algorithms::Sort::ByNaturalName>(
+                Algorithms::Sort::ByNaturalName(), m_isStableMerge);
 
         // sorting is "unknown", "unsorted" or "ignored"... so use unsorted merger
         case BamMultiReader::RoundRobinMerge:
@@ -330,6 +364,29 @@ bool BamMultiReaderPrivate::GetNextAlignmentCore(BamAlignment& al)
     return PopNextCachedAlignment(al, false);
 }
 
+// get up to maxCount next alignments among all files, returns number retrieved
+std::size_t BamMultiReaderPrivate::GetNextAlignments(std::vector<BamAlignment>& alignments,
+                                                     const std::size_t maxCount,
+                                                     const bool isCoreOnly)
+{
+
+    // re-use existing entries (& their buffers) where possible
+    if (alignments.size() < maxCount) {
+        alignments.resize(maxCount);
+    }
+
+    // fill with next alignments
+    std::size_t numAlignments = 0;
+    while (numAlignments < maxCount &&
+           PopNextCachedAlignment(alignments[numAlignments], !isCoreOnly)) {
+        ++numAlignments;
+    }
+
+    // drop unused entries & return count
+    alignments.resize(numAlignments);
+    return numAlignments;
+}
+
 // ---------------------------------------------------------------------------------------
 //
 // NB: The following GetReferenceX() functions assume that we have identical
@@ -460,6 +517,9 @@ bool BamMultiReaderPrivate::Jump(int refID, int position)
     // alignments here."  It makes sense to simply accept the failure,
     // UpdateAlignments(), and continue.
 
+    // discard any alignments read ahead of old position
+    ResetPrefetchers();
+
     // iterate over readers
     std::vector<MergeItem>::iterator readerIter = m_readers.begin();
     std::vector<MergeItem>::iterator readerEnd = m_readers.end();
@@ -478,6 +538,15 @@ bool BamMultiReaderPrivate::Jump(int refID, int position)
     return UpdateAlignmentCache();
 }
 
+// reads next (core-only) alignment from item's reader into item's alignment
+bool BamMultiReaderPrivate::LoadNextAlignment(const MergeItem& item)
+{
+    if (item.Prefetcher) {
+        return item.Prefetcher->GetNextAlignmentCore(*item.Alignment);
+    }
+    return item.Reader->GetNextAlignmentCore(*item.Alignment);
+}
+
 // locate (& load) index files for BAM readers that don't already have one loaded
 bool BamMultiReaderPrivate::LocateIndexes(const BamIndex::IndexType& preferredType)
 {
@@ -497,6 +566,9 @@ bool BamMultiReaderPrivate::LocateIndexes(const BamIndex::IndexType& preferredTy
 
         // if reader has no index, try to locate one
         if (!reader->HasIndex()) {
+            if (item.Prefetcher) {
+                item.Prefetcher->Wait();
+            }
             if (!reader->LocateIndex(preferredType)) {
                 m_errorString.append(1, '\t');
                 m_errorString.append(reader->GetErrorString());
@@ -547,9 +619,17 @@ bool BamMultiReaderPrivate::Open(const std::vector<std::string>& filenames)
         BamReader* reader = new BamReader;
         const bool readerOpened = reader->Open(filename);
 
-        // if opened OK, store it
+        // if opened OK, store it (with its read-ahead, if enabled)
         if (readerOpened) {
-            m_readers.push_back(MergeItem(reader, new BamAlignment));
+            BamReaderPrefetcher* prefetcher = 0;
+            if (m_numThreads > 1) {
+                if (m_threadPool == 0) {
+                    m_threadPool = new BamThreadPool(m_numThreads);
+                }
+                prefetcher = new BamReaderPrefetcher(reader, m_threadPool);
+            }
+            const std::size_t index = (m_readers.empty() ? 0 : m_readers.back().Index + 1);
+            m_readers.push_back(MergeItem(reader, new BamAlignment, prefetcher, index));
 
             // otherwise store error & clean up invalid reader
         } else {
@@ -626,6 +706,9 @@ bool BamMultiReaderPrivate::OpenIndexes(const std::vector<std::string>& indexFil
 
         // open index filename on reader
         if (reader) {
+            if (item.Prefetcher) {
+                item.Prefetcher->Wait();
+            }
             const std::string& indexFilename = (*indexFilenameIter);
             if (!reader->OpenIndex(indexFilename)) {
                 m_errorString.append(1, '\t');
@@ -661,11 +744,12 @@ bool BamMultiReaderPrivate::PopNextCachedAlignment(BamAlignment& al, const bool
         return false;
     }
 
-    // pop next merge item entry from cache
-    MergeItem item = m_alignmentCache->TakeFirst();
+    // fetch next merge item entry from cache
+    const MergeItem& item = m_alignmentCache->First();
     BamReader* reader = item.Reader;
     BamAlignment* alignment = item.Alignment;
     if (reader == 0 || alignment == 0) {
+        m_alignmentCache->TakeFirst();
         return false;
     }
 
@@ -678,11 +762,28 @@ bool BamMultiReaderPrivate::PopNextCachedAlignment(BamAlignment& al, const bool
     // store cached alignment into destination parameter (by copy)
     al = *alignment;
 
-    // load next alignment from reader & store in cache
-    SaveNextAlignment(reader, alignment);
+    // load next alignment from reader into same cache entry, or drop entry if reader is done
+    if (LoadNextAlignment(item)) {
+        m_alignmentCache->UpdateFirst();
+    } else {
+        m_alignmentCache->TakeFirst();
+    }
     return true;
 }
 
+// waits for & discards any read-ahead, so readers can be repositioned
+void BamMultiReaderPrivate::ResetPrefetchers()
+{
+    std::vector<MergeItem>::iterator readerIter = m_readers.begin();
+    std::vector<MergeItem>::iterator readerEnd = m_readers.end();
+    for (; readerIter != readerEnd; ++readerIter) {
+        MergeItem& item = (*readerIter);
+        if (item.Prefetcher) {
+            item.Prefetcher->Reset();
+        }
+    }
+}
+
 // returns BAM file pointers to beginning of alignment data & resets alignment cache
 bool BamMultiReaderPrivate::Rewind()
 {
@@ -711,6 +812,9 @@ bool BamMultiReaderPrivate::RewindReaders()
     m_errorString.clear();
     bool errorsEncountered = false;
 
+    // discard any alignments read ahead
+    ResetPrefetchers();
+
     // iterate over readers
     std::vector<MergeItem>::iterator readerIter = m_readers.begin();
     std::vector<MergeItem>::iterator readerEnd = m_readers.end();
@@ -733,7 +837,7 @@ bool BamMultiReaderPrivate::RewindReaders()
     return !errorsEncountered;
 }
 
-void BamMultiReaderPrivate::SaveNextAlignment(BamReader* reader, BamAlignment* alignment)
+void BamMultiReaderPrivate::SaveNextAlignment(const MergeItem& item)
 {
 
     // if can read alignment from reader, store in cache
@@ -742,8 +846,8 @@ void BamMultiReaderPrivate::SaveNextAlignment(BamReader* reader, BamAlignment* a
     //        automatically by alignment cache to maintain its sorting OR
     //        on demand from client call to future call to GetNextAlignment()
 
-    if (reader->GetNextAlignmentCore(*alignment)) {
-        m_alignmentCache->Add(MergeItem(reader, alignment));
+    if (LoadNextAlignment(item)) {
+        m_alignmentCache->Add(item);
     }
 }
 
@@ -789,6 +893,14 @@ void BamMultiReaderPrivate::SetErrorString(const std::string& where, const std::
     m_errorString = where + SEPARATOR + what;
 }
 
+void BamMultiReaderPrivate::SetNumThreads(int numThreads)
+{
+    // modifying read-ahead threads is not allowed while BAM files are open
+    if (m_readers.empty()) {
+        m_numThreads = numThreads;
+    }
+}
+
 bool BamMultiReaderPrivate::SetRegion(const BamRegion& region)
 {
 
@@ -797,6 +909,9 @@ bool BamMultiReaderPrivate::SetRegion(const BamRegion& region)
     // alignments here."  It makes sense to simply accept the failure,
     // UpdateAlignments(), and continue.
 
+    // discard any alignments read ahead of old position
+    ResetPrefetchers();
+
     // iterate over alignments
     std::vector<MergeItem>::iterator readerIter = m_readers.begin();
     std::vector<MergeItem>::iterator readerEnd = m_readers.end();
@@ -815,6 +930,40 @@ bool BamMultiReaderPrivate::SetRegion(const BamRegion& region)
     return UpdateAlignmentCache();
 }
 
+bool BamMultiReaderPrivate::SetRegions(const std::vector<BamRegion>& regions)
+{
+
+    // NB: as with SetRegion(), a reader failing to set regions is accepted
+
+    // discard any alignments read ahead of old position
+    ResetPrefetchers();
+
+    // iterate over alignments
+    std::vector<MergeItem>::iterator readerIter = m_readers.begin();
+    std::vector<MergeItem>::iterator readerEnd = m_readers.end();
+    for (; readerIter != readerEnd; ++readerIter) {
+        MergeItem& item = (*readerIter);
+        BamReader* reader = item.Reader;
+        if (reader == 0) {
+            continue;
+        }
+
+        // set regions of interest
+        reader->SetRegions(regions);
+    }
+
+    // return status of cache update
+    return UpdateAlignmentCache();
+}
+
+void BamMultiReaderPrivate::SetStableMerge(bool ok)
+{
+    // modifying merge tie-breaking is not allowed while BAM files are open
+    if (m_readers.empty()) {
+        m_isStableMerge = ok;
+    }
+}
+
 // updates our alignment cache
 bool BamMultiReaderPrivate::UpdateAlignmentCache()
 {
@@ -832,10 +981,18 @@ bool BamMultiReaderPrivate::UpdateAlignmentCache()
     // clear any prior cache data
     m_alignmentCache->Clear();
 
-    // iterate over readers
+    // start reading ahead on all readers at once, if enabled
     std::vector<MergeItem>::iterator readerIter = m_readers.begin();
     std::vector<MergeItem>::iterator readerEnd = m_readers.end();
     for (; readerIter != readerEnd; ++readerIter) {
+        MergeItem& item = (*readerIter);
+        if (item.Prefetcher) {
+            item.Prefetcher->Start();
+        }
+    }
+
+    // iterate over readers
+    for (readerIter = m_readers.begin(); readerIter != readerEnd; ++readerIter) {
         MergeItem& item = (*readerIter);
         BamReader* reader = item.Reader;
         BamAlignment* alignment = item.Alignment;
@@ -844,7 +1001,7 @@ bool BamMultiReaderPrivate::UpdateAlignmentCache()
         }
 
         // save next alignment from each reader in cache
-        SaveNextAlignment(reader, alignment);
+        SaveNextAlignment(item);
     }
 
     // if we get here, ok
@@ -31,6 +31,8 @@
 namespace BamTools {
 namespace Internal {
 
+class BamThreadPool;
+
 class API_NO_EXPORT BamMultiReaderPrivate
 {
 
@@ -54,13 +56,18 @@ public:
     bool OpenFile(const std::string& filename);
     bool Rewind();
     bool SetRegion(const BamRegion& region);
+    bool SetRegions(const std::vector<BamRegion>& regions);
+    void SetStableMerge(bool ok);
 
     // access alignment data
     BamMultiReader::MergeOrder GetMergeOrder() const;
     bool GetNextAlignment(BamAlignment& al);
     bool GetNextAlignmentCore(BamAlignment& al);
+    std::size_t GetNextAlignments(std::vector<BamAlignment>& alignments, const std::size_t maxCount,
+                                  const bool isCoreOnly);
     bool HasOpenReaders();
     bool SetExplicitMergeOrder(BamMultiReader::MergeOrder order);
+    void SetNumThreads(int numThreads);
 
     // access auxiliary data
     SamHeader GetHeader() const;
@@ -82,9 +89,11 @@ public:
 public:
     bool CloseFiles(const std::vector<std::string>& filenames);
     IMultiMerger* CreateAlignmentCache();
+    bool LoadNextAlignment(const MergeItem& item);
     bool PopNextCachedAlignment(BamAlignment& al, const bool needCharData);
+    void ResetPrefetchers();
     bool RewindReaders();
-    void SaveNextAlignment(BamReader* reader, BamAlignment* alignment);
+    void SaveNextAlignment(const MergeItem& item);
     void SetErrorString(const std::string& where, const std::string& what) const;  //
     bool UpdateAlignmentCache();
     bool ValidateReaders() const;
@@ -95,8 +104,12 @@ public:
     IMultiMerger* m_alignmentCache;
 
     bool m_hasUserMergeOrder;
+    bool m_isStableMerge;
     BamMultiReader::MergeOrder m_mergeOrder;
 
+    int m_numThreads;
+    BamThreadPool* m_threadPool;
+
     mutable std::string m_errorString;
 };
 
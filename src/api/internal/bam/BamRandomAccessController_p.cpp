@@ -15,12 +15,44 @@
 using namespace BamTools;
 using namespace BamTools::Internal;
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 #include <sstream>
 
+namespace BamTools {
+namespace Internal {
+
+// sorts intervals by (reference, begin position)
+struct IntervalLessThan
+{
+    bool operator()(const BamRegionInterval& lhs, const BamRegionInterval& rhs) const
+    {
+        if (lhs.RefID != rhs.RefID) {
+            return lhs.RefID < rhs.RefID;
+        }
+        return lhs.Begin < rhs.Begin;
+    }
+};
+
+// sorts chunks by start offset
+struct ChunkLessThan
+{
+    bool operator()(const BamIndex::Chunk& lhs, const BamIndex::Chunk& rhs) const
+    {
+        return lhs.Start < rhs.Start;
+    }
+};
+
+}  // namespace Internal
+}  // namespace BamTools
+
 BamRandomAccessController::BamRandomAccessController()
     : m_index(0)
     , m_hasAlignmentsInRegion(true)
+    , m_hasRegions(false)
+    , m_intervalIndex(0)
+    , m_chunkIndex(0)
 {}
 
 BamRandomAccessController::~BamRandomAccessController()
@@ -64,9 +96,14 @@ void BamRandomAccessController::AdjustRegion(const int& referenceCount)
 
 // returns alignments' "RegionState": { Before|Overlaps|After } current region
 BamRandomAccessController::RegionState BamRandomAccessController::AlignmentState(
-    const BamAlignment& alignment) const
+    const BamAlignment& alignment)
 {
 
+    // if multiple regions set
+    if (m_hasRegions) {
+        return IntervalState(alignment);
+    }
+
     // if region has no left bound at all
     if (!m_region.isLeftBoundSpecified()) {
         return OverlapsRegion;
@@ -163,6 +200,11 @@ void BamRandomAccessController::ClearRegion()
 {
     m_region.clear();
     m_hasAlignmentsInRegion = true;
+    m_hasRegions = false;
+    m_intervals.clear();
+    m_intervalIndex = 0;
+    m_chunks.clear();
+    m_chunkIndex = 0;
 }
 
 bool BamRandomAccessController::CreateIndex(BamReaderPrivate* reader,
@@ -210,7 +252,7 @@ bool BamRandomAccessController::HasIndex() const
 
 bool BamRandomAccessController::HasRegion() const
 {
-    return (!m_region.isNull());
+    return (m_hasRegions || !m_region.isNull());
 }
 
 bool BamRandomAccessController::IndexHasAlignmentsForReference(const int& refId)
@@ -218,6 +260,48 @@ bool BamRandomAccessController::IndexHasAlignmentsForReference(const int& refId)
     return m_index->HasAlignments(refId);
 }
 
+// returns alignment's "RegionState" w.r.t. the multi-region intervals
+//   * alignments are visited in sorted order, so intervals that end before the alignment
+//     can be dropped for good
+BamRandomAccessController::RegionState BamRandomAccessController::IntervalState(
+    const BamAlignment& alignment)
+{
+
+    // handle unmapped reads - return AFTER region to halt processing
+    if (alignment.RefID == -1) {
+        return AfterRegion;
+    }
+
+    // skip any intervals that lie completely before alignment's start
+    const std::size_t numIntervals = m_intervals.size();
+    while (m_intervalIndex < numIntervals) {
+        const BamRegionInterval& interval = m_intervals[m_intervalIndex];
+        if (interval.RefID > alignment.RefID ||
+            (interval.RefID == alignment.RefID && interval.End > alignment.Position)) {
+            break;
+        }
+        ++m_intervalIndex;
+    }
+
+    // alignment is after the last interval
+    if (m_intervalIndex == numIntervals) {
+        return AfterRegion;
+    }
+
+    // alignment is on a reference before the next interval
+    const BamRegionInterval& interval = m_intervals[m_intervalIndex];
+    if (interval.RefID != alignment.RefID) {
+        return BeforeRegion;
+    }
+
+    // alignment starts in, or overlaps the left bound of, the next interval
+    if (alignment.Position >= interval.Begin || alignment.GetEndPosition() > interval.Begin) {
+        return OverlapsRegion;
+    } else {
+        return BeforeRegion;
+    }
+}
+
 bool BamRandomAccessController::LocateIndex(BamReaderPrivate* reader,
                                             const BamIndex::IndexType& preferredType)
 {
@@ -269,6 +353,37 @@ bool BamRandomAccessController::RegionHasAlignments() const
     return m_hasAlignmentsInRegion;
 }
 
+// positions reader within the next chunk of a multi-region request, if not already there
+// returns false if all chunks are used up (or on seek failure)
+bool BamRandomAccessController::SeekToNextChunk(BamReaderPrivate* reader)
+{
+
+    // nothing to do unless reading by chunks
+    if (m_chunks.empty()) {
+        return true;
+    }
+
+    // skip chunks that reader has already passed
+    const int64_t offset = reader->Tell();
+    const std::size_t numChunks = m_chunks.size();
+    while (m_chunkIndex < numChunks && offset >= m_chunks[m_chunkIndex].Stop) {
+        ++m_chunkIndex;
+    }
+
+    // no chunks left
+    if (m_chunkIndex == numChunks) {
+        m_hasAlignmentsInRegion = false;
+        return false;
+    }
+
+    // jump ahead to chunk start if needed
+    const int64_t chunkStart = m_chunks[m_chunkIndex].Start;
+    if (offset < chunkStart) {
+        return reader->Seek(chunkStart);
+    }
+    return true;
+}
+
 void BamRandomAccessController::SetErrorString(const std::string& where, const std::string& what)
 {
     m_errorString = where + ": " + what;
@@ -285,6 +400,9 @@ void BamRandomAccessController::SetIndex(BamIndex* index)
 bool BamRandomAccessController::SetRegion(const BamRegion& region, const int& referenceCount)
 {
 
+    // drop any previous region(s)
+    ClearRegion();
+
     // store region
     m_region = region;
 
@@ -321,3 +439,134 @@ bool BamRandomAccessController::SetRegion(const BamRegion& region, const int& re
         return true;
     }
 }
+
+// sets multiple regions, reading only the parts of the file that may overlap them
+bool BamRandomAccessController::SetRegions(const std::vector<BamRegion>& regions,
+                                           const int& referenceCount, BamReaderPrivate* reader)
+{
+
+    // drop any previous region(s)
+    ClearRegion();
+
+    // cannot jump when no index is available
+    if (!HasIndex()) {
+        SetErrorString("BamRandomAccessController", "cannot jump if no index data available");
+        return false;
+    }
+
+    // split regions into single-reference intervals
+    const int openEnd = std::numeric_limits<int>::max();
+    std::vector<BamRegionInterval> intervals;
+    std::vector<BamRegion>::const_iterator regionIter = regions.begin();
+    std::vector<BamRegion>::const_iterator regionEnd = regions.end();
+    for (; regionIter != regionEnd; ++regionIter) {
+        const BamRegion& region = (*regionIter);
+
+        // validate left bound
+        if (region.LeftRefID < 0 || region.LeftRefID >= referenceCount || region.LeftPosition < 0) {
+            std::stringstream s;
+            s << "invalid region: (" << region.LeftRefID << ", " << region.LeftPosition << ")";
+            SetErrorString("BamRandomAccessController::SetRegions", s.str());
+            return false;
+        }
+
+        // region runs up to right bound, or to end of file
+        const bool hasRightBound = region.isRightBoundSpecified();
+        const int lastRefId =
+            (hasRightBound ? std::min(region.RightRefID, referenceCount - 1) : referenceCount - 1);
+        for (int refId = region.LeftRefID; refId <= lastRefId; ++refId) {
+            const int begin = (refId == region.LeftRefID ? region.LeftPosition : 0);
+            const int end =
+                (hasRightBound && refId == region.RightRefID ? region.RightPosition : openEnd);
+            if (begin < end) {
+                intervals.push_back(BamRegionInterval(refId, begin, end));
+            }
+        }
+    }
+
+    // sort & merge overlapping (or adjacent) intervals
+    std::sort(intervals.begin(), intervals.end(), IntervalLessThan());
+    for (std::size_t i = 0; i < intervals.size(); ++i) {
+        const BamRegionInterval& interval = intervals[i];
+        if (!m_intervals.empty() && m_intervals.back().RefID == interval.RefID &&
+            m_intervals.back().End >= interval.Begin) {
+            m_intervals.back().End = std::max(m_intervals.back().End, interval.End);
+        } else {
+            m_intervals.push_back(interval);
+        }
+    }
+    m_hasRegions = true;
+
+    // collect file offset ranges for intervals on references with data
+    //   * if index cannot provide these, fall back to reading on from first interval
+    bool hasChunks = true;
+    const BamRegionInterval* firstInterval = 0;
+    for (std::size_t i = 0; i < m_intervals.size(); ++i) {
+        const BamRegionInterval& interval = m_intervals[i];
+        if (!m_index->HasAlignments(interval.RefID)) {
+            continue;
+        }
+        if (firstInterval == 0) {
+            firstInterval = &interval;
+        }
+        const BamRegion region =
+            (interval.End == openEnd
+                 ? BamRegion(interval.RefID, interval.Begin)
+                 : BamRegion(interval.RefID, interval.Begin, interval.RefID, interval.End));
+        if (!m_index->GetChunks(region, m_chunks)) {
+            hasChunks = false;
+            m_chunks.clear();
+            break;
+        }
+    }
+
+    // if no data present, return true (see SetRegion() for rationale)
+    if (firstInterval == 0) {
+        m_hasAlignmentsInRegion = false;
+        return true;
+    }
+
+    // sort chunks & merge any that overlap or share a BGZF block, so no block is read twice
+    if (hasChunks) {
+        std::sort(m_chunks.begin(), m_chunks.end(), ChunkLessThan());
+        std::size_t numMerged = 0;
+        for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+            const BamIndex::Chunk& chunk = m_chunks[i];
+            if (numMerged > 0) {
+                BamIndex::Chunk& previous = m_chunks[numMerged - 1];
+                if (chunk.Start <= previous.Stop || (chunk.Start >> 16) <= (previous.Stop >> 16)) {
+                    previous.Stop = std::max(previous.Stop, chunk.Stop);
+                    continue;
+                }
+            }
+            m_chunks[numMerged++] = chunk;
+        }
+        m_chunks.resize(numMerged);
+
+        // if no data present, return true
+        m_hasAlignmentsInRegion = !m_chunks.empty();
+        if (!m_hasAlignmentsInRegion) {
+            return true;
+        }
+
+        // return success/failure of seeking to first chunk
+        assert(reader);
+        if (!reader->Seek(m_chunks.front().Start)) {
+            const std::string message =
+                std::string("could not set regions\n\t") + reader->GetErrorString();
+            SetErrorString("BamRandomAccessController::SetRegions", message);
+            return false;
+        }
+        return true;
+    }
+
+    // otherwise jump to first interval with data
+    const BamRegion firstRegion(firstInterval->RefID, firstInterval->Begin);
+    if (!m_index->Jump(firstRegion, &m_hasAlignmentsInRegion)) {
+        const std::string indexError = m_index->GetErrorString();
+        const std::string message = std::string("could not set regions\n\t") + indexError;
+        SetErrorString("BamRandomAccessController::SetRegions", message);
+        return false;
+    }
+    return true;
+}
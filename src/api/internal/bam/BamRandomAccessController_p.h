@@ -22,6 +22,8 @@
 //
 // We mean it.
 
+#include <cstddef>
+#include <vector>
 #include "api/BamAux.h"
 #include "api/BamIndex.h"
 
@@ -33,6 +35,23 @@ namespace Internal {
 
 class BamReaderPrivate;
 
+// half-open interval [Begin, End) on a single reference, one piece of a multi-region request
+struct API_NO_EXPORT BamRegionInterval
+{
+
+    // data members
+    int RefID;
+    int Begin;
+    int End;
+
+    // ctor
+    BamRegionInterval(const int& refId = -1, const int& begin = 0, const int& end = 0)
+        : RefID(refId)
+        , Begin(begin)
+        , End(end)
+    {}
+};
+
 class API_NO_EXPORT BamRandomAccessController
 {
 
@@ -64,9 +83,12 @@ public:
     // region methods
     void ClearRegion();
     bool HasRegion() const;
-    RegionState AlignmentState(const BamAlignment& alignment) const;
+    RegionState AlignmentState(const BamAlignment& alignment);
     bool RegionHasAlignments() const;
+    bool SeekToNextChunk(BamReaderPrivate* reader);
     bool SetRegion(const BamRegion& region, const int& referenceCount);
+    bool SetRegions(const std::vector<BamRegion>& regions, const int& referenceCount,
+                    BamReaderPrivate* reader);
 
     // general methods
     void Close();
@@ -76,6 +98,8 @@ public:
 private:
     // adjusts requested region if necessary (depending on where data actually begins)
     void AdjustRegion(const int& referenceCount);
+    // returns RegionState of alignment w.r.t. the multi-region intervals
+    RegionState IntervalState(const BamAlignment& alignment);
     // error-string handling
     void SetErrorString(const std::string& where, const std::string& what);
 
@@ -88,6 +112,15 @@ private:
     BamRegion m_region;
     bool m_hasAlignmentsInRegion;
 
+    // multi-region data: sorted, disjoint intervals & merged file offset ranges covering them
+    //   * if no chunks available (index can't provide them), reading proceeds sequentially
+    //     from the first interval
+    bool m_hasRegions;
+    std::vector<BamRegionInterval> m_intervals;
+    std::size_t m_intervalIndex;
+    std::vector<BamIndex::Chunk> m_chunks;
+    std::size_t m_chunkIndex;
+
     // general data
     std::string m_errorString;
 };
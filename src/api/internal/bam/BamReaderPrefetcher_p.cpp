@@ -0,0 +1,96 @@
+// ***************************************************************************
+// BamReaderPrefetcher_p.cpp (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Reads alignments ahead from a BamReader on worker threads
+// ***************************************************************************
+
+#include "api/internal/bam/BamReaderPrefetcher_p.h"
+#include "api/BamReader.h"
+#include "api/internal/utils/BamThreadPool_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <algorithm>
+#include <functional>
+
+// ctor
+BamReaderPrefetcher::BamReaderPrefetcher(BamReader* reader, BamThreadPool* threadPool)
+    : m_reader(reader)
+    , m_threadPool(threadPool)
+    , m_batchIndex(0)
+    , m_hasNextBatch(false)
+    , m_isStarted(false)
+    , m_isReaderDone(false)
+{}
+
+// dtor - reader must stay valid until any read-ahead is finished
+BamReaderPrefetcher::~BamReaderPrefetcher()
+{
+    Wait();
+}
+
+bool BamReaderPrefetcher::GetNextAlignmentCore(BamAlignment& alignment)
+{
+
+    // if current batch used up, switch to the one read ahead
+    while (m_batchIndex == m_batch.size()) {
+
+        Wait();
+        if (!m_hasNextBatch) {
+            return false;
+        }
+        m_batch.swap(m_nextBatch);
+        m_batchIndex = 0;
+        m_hasNextBatch = false;
+
+        // start reading the following batch, unless reader is done
+        if (!m_isReaderDone) {
+            QueueReadBatch();
+        }
+    }
+
+    // hand out alignment by swapping, so buffers are recycled into the batch
+    std::swap(alignment, m_batch[m_batchIndex]);
+    ++m_batchIndex;
+    return true;
+}
+
+void BamReaderPrefetcher::QueueReadBatch()
+{
+    m_nextBatchReady = m_threadPool->Submit(std::bind(&BamReaderPrefetcher::ReadBatch, this));
+}
+
+// runs on worker thread
+void BamReaderPrefetcher::ReadBatch()
+{
+    const std::size_t numAlignments = m_reader->GetNextAlignmentsCore(m_nextBatch, BatchSize);
+    m_isReaderDone = (numAlignments < BatchSize);
+}
+
+void BamReaderPrefetcher::Reset()
+{
+    Wait();
+    m_batchIndex = m_batch.size();
+    m_hasNextBatch = false;
+    m_isStarted = false;
+}
+
+void BamReaderPrefetcher::Start()
+{
+    if (m_isStarted) {
+        return;
+    }
+    m_isStarted = true;
+    m_isReaderDone = false;
+    QueueReadBatch();
+}
+
+void BamReaderPrefetcher::Wait()
+{
+    if (m_nextBatchReady.valid()) {
+        m_nextBatchReady.get();
+        m_hasNextBatch = true;
+    }
+}
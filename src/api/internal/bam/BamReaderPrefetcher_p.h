@@ -0,0 +1,84 @@
+// ***************************************************************************
+// BamReaderPrefetcher_p.h (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Reads alignments ahead from a BamReader on worker threads
+// ***************************************************************************
+
+#ifndef BAMREADERPREFETCHER_P_H
+#define BAMREADERPREFETCHER_P_H
+
+#include "api/api_global.h"
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include <cstddef>
+#include <future>
+#include <vector>
+#include "api/BamAlignment.h"
+
+namespace BamTools {
+
+class BamReader;
+
+namespace Internal {
+
+class BamThreadPool;
+
+// Decodes the next batch of (core-only) alignments from a reader on a thread pool, while
+// the previous batch is handed out. At most one batch is in flight per reader, so the
+// reader is only ever used by one thread at a time & memory use stays bounded.
+class API_NO_EXPORT BamReaderPrefetcher
+{
+
+    // ctor & dtor
+public:
+    BamReaderPrefetcher(BamReader* reader, BamThreadPool* threadPool);
+    ~BamReaderPrefetcher();
+
+    // BamReaderPrefetcher interface
+public:
+    // retrieves next alignment (without populating string data fields), returns false at end
+    bool GetNextAlignmentCore(BamAlignment& alignment);
+    // waits for read-ahead & discards buffered alignments; call before repositioning the reader
+    void Reset();
+    // starts reading ahead from the reader's current position, if not already doing so
+    void Start();
+    // waits for read-ahead in progress, keeping its alignments; call before other reader access
+    void Wait();
+
+    // internal methods
+private:
+    void QueueReadBatch();
+    void ReadBatch();
+
+    // data members
+private:
+    static const std::size_t BatchSize = 128;
+
+    BamReader* m_reader;
+    BamThreadPool* m_threadPool;
+
+    std::vector<BamAlignment> m_batch;  // alignments being handed out
+    std::size_t m_batchIndex;
+    std::vector<BamAlignment> m_nextBatch;  // alignments being read ahead
+    std::future<void> m_nextBatchReady;
+    bool m_hasNextBatch;
+
+    bool m_isStarted;
+    bool m_isReaderDone;  // set by last read-ahead if reader had no more alignments
+};
+
+}  // namespace Internal
+}  // namespace BamTools
+
+#endif  // BAMREADERPREFETCHER_P_H
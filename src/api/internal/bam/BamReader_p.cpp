@@ -149,7 +149,7 @@ bool BamReaderPrivate::GetNextAlignment(BamAlignment& alignment)
 
 // retrieves next available alignment core data (returns success/fail)
 // ** DOES NOT populate any character data fields (read name, bases, qualities, tag data, filename)
-//    these can be accessed, if necessary, from the supportData
+//    these are decoded on demand by BamAlignment's Get<Field>() & tag query methods
 // useful for operations requiring ONLY positional or other alignment-related information
 bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment)
 {
@@ -167,8 +167,8 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment)
             return false;
         }
 
-        // if can't read next alignment
-        if (!LoadNextAlignment(alignment)) {
+        // if can't read next alignment (from the regions' file chunks, if set)
+        if (!m_randomAccessController.SeekToNextChunk(this) || !LoadNextAlignment(alignment)) {
             return false;
         }
 
@@ -185,7 +185,7 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment)
         while (state != BamRandomAccessController::OverlapsRegion) {
 
             // if can't read next alignment
-            if (!LoadNextAlignment(alignment)) {
+            if (!m_randomAccessController.SeekToNextChunk(this) || !LoadNextAlignment(alignment)) {
                 return false;
             }
 
@@ -201,6 +201,18 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment)
         // if we get here, we found the next 'valid' alignment
         // (e.g. overlaps current region if one was set, simply the next alignment if not)
         alignment.SupportData.HasCoreOnly = true;
+        alignment.SupportData.HasRawCharData = true;
+        alignment.SupportData.DecodedFields = 0;
+        alignment.TagIndex.Clear();
+
+        // tags can only be queried in place when stored in system byte order,
+        // otherwise decode them up front
+        if (m_isBigEndian && !alignment.DecodeTagData()) {
+            const std::string alError = alignment.GetErrorString();
+            SetErrorString("BamReader::GetNextAlignmentCore",
+                           std::string("could not decode tag data: \n\t") + alError);
+            return false;
+        }
         return true;
 
     } catch (const BamException& e) {
@@ -212,6 +224,33 @@ bool BamReaderPrivate::GetNextAlignmentCore(BamAlignment& alignment)
     }
 }
 
+// retrieves up to maxCount next available alignments, returns number retrieved
+std::size_t BamReaderPrivate::GetNextAlignments(std::vector<BamAlignment>& alignments,
+                                                const std::size_t maxCount, const bool isCoreOnly)
+{
+
+    // re-use existing entries (& their buffers) where possible
+    if (alignments.size() < maxCount) {
+        alignments.resize(maxCount);
+    }
+
+    // fill with next alignments
+    std::size_t numAlignments = 0;
+    while (numAlignments < maxCount) {
+        BamAlignment& alignment = alignments[numAlignments];
+        const bool ok =
+            (isCoreOnly ? GetNextAlignmentCore(alignment) : GetNextAlignment(alignment));
+        if (!ok) {
+            break;
+        }
+        ++numAlignments;
+    }
+
+    // drop unused entries & return count
+    alignments.resize(numAlignments);
+    return numAlignments;
+}
+
 int BamReaderPrivate::GetReferenceCount() const
 {
     return m_references.size();
@@ -308,13 +347,13 @@ static int hts_reg2bin(int64_t beg, int64_t end, int min_shift, int n_lvls)
     return 0;
 }
 
-bool BamReaderPrivate::Tag2Cigar(BamAlignment& a, RaiiBuffer& buf)
+bool BamReaderPrivate::Tag2Cigar(BamAlignment& a, std::string& charData)
 {
     if (a.RefID < 0 || a.Position < 0 || a.SupportData.NumCigarOperations == 0) {
         return false;
     }
 
-    const unsigned char* data = (const unsigned char*)buf.Buffer;
+    const unsigned char* data = (const unsigned char*)charData.data();
     const unsigned data_len = a.SupportData.BlockLength - Constants::BAM_CORE_SIZE;
     const unsigned char* p = data + a.SupportData.QueryNameLength;  // the original CIGAR
     unsigned cigar1 =
@@ -367,7 +406,7 @@ bool BamReaderPrivate::Tag2Cigar(BamAlignment& a, RaiiBuffer& buf)
     // update member variables
     a.SupportData.NumCigarOperations = tag_cigar_len;
     a.SupportData.BlockLength -= 8 + fake_bytes;
-    std::memcpy(buf.Buffer, new_data.c_str(), buf.NumBytes - 8 - fake_bytes);
+    std::memcpy(&charData[0], new_data.c_str(), data_len - 8 - fake_bytes);
     return true;
 }
 
@@ -375,23 +414,60 @@ bool BamReaderPrivate::Tag2Cigar(BamAlignment& a, RaiiBuffer& buf)
 bool BamReaderPrivate::LoadNextAlignment(BamAlignment& alignment)
 {
 
-    // read in the 'block length' value, make sure it's not zero
-    char buffer[sizeof(uint32_t)];
-    std::fill_n(buffer, sizeof(uint32_t), 0);
-    m_stream.Read(buffer, sizeof(uint32_t));
-    alignment.SupportData.BlockLength = BamTools::UnpackUnsignedInt(buffer);
-    if (m_isBigEndian) {
-        BamTools::SwapEndian_32(alignment.SupportData.BlockLength);
+    char x[Constants::BAM_CORE_SIZE];
+    unsigned int dataLength = 0;
+    std::string& allCharData = alignment.SupportData.AllCharData;
+
+    // peek at 'block length' & core data in current BGZF block
+    const std::size_t headerLength = sizeof(uint32_t) + Constants::BAM_CORE_SIZE;
+    const char* recordData = m_stream.Peek(headerLength);
+    uint32_t blockLength = 0;
+    if (recordData) {
+        blockLength = BamTools::UnpackUnsignedInt(recordData);
+        if (m_isBigEndian) {
+            BamTools::SwapEndian_32(blockLength);
+        }
     }
-    if (alignment.SupportData.BlockLength == 0) {
-        return false;
+
+    // if whole record lies within current block, copy it straight from there
+    if (recordData && blockLength >= Constants::BAM_CORE_SIZE &&
+        m_stream.Peek(sizeof(uint32_t) + blockLength)) {
+        std::memcpy(x, recordData + sizeof(uint32_t), Constants::BAM_CORE_SIZE);
+        dataLength = blockLength - Constants::BAM_CORE_SIZE;
+        allCharData.resize(dataLength);
+        std::copy(recordData + headerLength, recordData + headerLength + dataLength,
+                  allCharData.begin());
+        m_stream.Skip(sizeof(uint32_t) + blockLength);
     }
 
-    // read in core alignment data, make sure the right size of data was read
-    char x[Constants::BAM_CORE_SIZE];
-    if (m_stream.Read(x, Constants::BAM_CORE_SIZE) != Constants::BAM_CORE_SIZE) {
-        return false;
+    // otherwise read it piece by piece, across block boundaries
+    else {
+
+        // read in the 'block length' value, make sure it's not zero
+        char buffer[sizeof(uint32_t)];
+        std::fill_n(buffer, sizeof(uint32_t), 0);
+        m_stream.Read(buffer, sizeof(uint32_t));
+        blockLength = BamTools::UnpackUnsignedInt(buffer);
+        if (m_isBigEndian) {
+            BamTools::SwapEndian_32(blockLength);
+        }
+        if (blockLength == 0) {
+            return false;
+        }
+
+        // read in core alignment data, make sure the right size of data was read
+        if (m_stream.Read(x, Constants::BAM_CORE_SIZE) != Constants::BAM_CORE_SIZE) {
+            return false;
+        }
+
+        // read character data straight into alignment's buffer, re-using its existing capacity
+        dataLength = blockLength - Constants::BAM_CORE_SIZE;
+        allCharData.resize(dataLength);
+        if (dataLength > 0 && m_stream.Read(&allCharData[0], dataLength) != dataLength) {
+            return false;
+        }
     }
+    alignment.SupportData.BlockLength = blockLength;
 
     // swap core endian-ness if necessary
     if (m_isBigEndian) {
@@ -421,53 +497,36 @@ bool BamReaderPrivate::LoadNextAlignment(BamAlignment& alignment)
     // set BamAlignment length
     alignment.Length = alignment.SupportData.QuerySequenceLength;
 
-    // read in character data - make sure proper data size was read
-    bool readCharDataOK = false;
-    unsigned int dataLength = alignment.SupportData.BlockLength - Constants::BAM_CORE_SIZE;
-    RaiiBuffer allCharData(dataLength);
-
-    if (m_stream.Read(allCharData.Buffer, dataLength) == dataLength) {
+    // if real CIGAR was stored in tag, move it into place
+    const unsigned int oldNumCigarOperations = alignment.SupportData.NumCigarOperations;
+    if (Tag2Cigar(alignment, allCharData)) {
+        dataLength -= 8 + oldNumCigarOperations * 4;
+        allCharData.resize(dataLength);
+    }
 
-        int OldNumCigarOperations = alignment.SupportData.NumCigarOperations;
-        if (Tag2Cigar(alignment, allCharData)) {
-            dataLength -= 8 + OldNumCigarOperations * 4;
+    // save CIGAR ops
+    // need to calculate this here so that  BamAlignment::GetEndPosition() performs correctly,
+    // even when GetNextAlignmentCore() is called
+    const unsigned int numCigarOperations = alignment.SupportData.NumCigarOperations;
+    const char* cigarDataPtr = allCharData.data() + alignment.SupportData.QueryNameLength;
+    alignment.CigarData.resize(numCigarOperations);
+    for (unsigned int i = 0; i < numCigarOperations; cigarDataPtr += sizeof(uint32_t), ++i) {
+        uint32_t cigarData;
+        std::memcpy(&cigarData, cigarDataPtr, sizeof(uint32_t));
+
+        // swap endian-ness if necessary
+        if (m_isBigEndian) {
+            BamTools::SwapEndian_32(cigarData);
         }
 
-        // store 'allCharData' in supportData structure
-        alignment.SupportData.AllCharData.assign((const char*)allCharData.Buffer, dataLength);
-
-        // set success flag
-        readCharDataOK = true;
-
-        // save CIGAR ops
-        // need to calculate this here so that  BamAlignment::GetEndPosition() performs correctly,
-        // even when GetNextAlignmentCore() is called
-        const unsigned int cigarDataOffset = alignment.SupportData.QueryNameLength;
-        const char* cigarDataPtr = allCharData.Buffer + cigarDataOffset;
-        CigarOp op;
-        alignment.CigarData.clear();
-        alignment.CigarData.reserve(alignment.SupportData.NumCigarOperations);
-        for (unsigned int i = 0; i < alignment.SupportData.NumCigarOperations;
-             cigarDataPtr += sizeof(uint32_t), ++i) {
-            uint32_t cigarData;
-            std::memcpy(&cigarData, cigarDataPtr, sizeof(uint32_t));
-
-            // swap endian-ness if necessary
-            if (m_isBigEndian) {
-                BamTools::SwapEndian_32(cigarData);
-            }
-
-            // build CigarOp structure
-            op.Length = (cigarData >> Constants::BAM_CIGAR_SHIFT);
-            op.Type = Constants::BAM_CIGAR_LOOKUP[(cigarData & Constants::BAM_CIGAR_MASK)];
-
-            // save CigarOp
-            alignment.CigarData.push_back(op);
-        }
+        // store CigarOp
+        CigarOp& op = alignment.CigarData[i];
+        op.Length = (cigarData >> Constants::BAM_CIGAR_SHIFT);
+        op.Type = Constants::BAM_CIGAR_LOOKUP[(cigarData & Constants::BAM_CIGAR_MASK)];
     }
 
-    // return success/failure
-    return readCharDataOK;
+    // return success
+    return true;
 }
 
 // loads reference data from BAM file
@@ -577,6 +636,7 @@ bool BamReaderPrivate::Rewind()
 
     // reset region
     m_randomAccessController.ClearRegion();
+    m_stream.SetRandomAccess(false);
 
     // return status of seeking back to first alignment
     if (Seek(m_alignmentsBeginOffset)) {
@@ -620,12 +680,22 @@ void BamReaderPrivate::SetIndex(BamIndex* index)
     m_randomAccessController.SetIndex(index);
 }
 
+// sets number of threads used for BGZF block decompression
+void BamReaderPrivate::SetNumThreads(int numThreads)
+{
+    // modifying decompression threads is not allowed if BAM file is open
+    if (!IsOpen()) {
+        m_stream.SetNumThreads(numThreads);
+    }
+}
+
 // sets current region & attempts to jump to it
 // returns success/failure
 bool BamReaderPrivate::SetRegion(const BamRegion& region)
 {
 
     if (m_randomAccessController.SetRegion(region, m_references.size())) {
+        m_stream.SetRandomAccess(m_randomAccessController.HasRegion());
         return true;
     } else {
         const std::string bracError = m_randomAccessController.GetErrorString();
@@ -635,6 +705,22 @@ bool BamReaderPrivate::SetRegion(const BamRegion& region)
     }
 }
 
+// sets multiple regions & jumps to the first one
+// returns success/failure
+bool BamReaderPrivate::SetRegions(const std::vector<BamRegion>& regions)
+{
+
+    if (m_randomAccessController.SetRegions(regions, m_references.size(), this)) {
+        m_stream.SetRandomAccess(true);
+        return true;
+    } else {
+        const std::string bracError = m_randomAccessController.GetErrorString();
+        const std::string message = std::string("could not set regions: \n\t") + bracError;
+        SetErrorString("BamReader::SetRegions", message);
+        return false;
+    }
+}
+
 int64_t BamReaderPrivate::Tell() const
 {
     return m_stream.Tell();
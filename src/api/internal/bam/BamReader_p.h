@@ -50,12 +50,16 @@ public:
     bool IsOpen() const;
     bool Open(const std::string& filename);
     bool Rewind();
+    void SetNumThreads(int numThreads);
     bool SetRegion(const BamRegion& region);
+    bool SetRegions(const std::vector<BamRegion>& regions);
 
     // access alignment data
     bool GetNextAlignment(BamAlignment& alignment);
     bool GetNextAlignmentCore(BamAlignment& alignment);
-    bool Tag2Cigar(BamAlignment& alignment, RaiiBuffer& buf);
+    std::size_t GetNextAlignments(std::vector<BamAlignment>& alignments, const std::size_t maxCount,
+                                  const bool isCoreOnly);
+    bool Tag2Cigar(BamAlignment& alignment, std::string& charData);
 
     // access auxiliary data
     std::string GetHeaderText() const;
@@ -0,0 +1,415 @@
+// ***************************************************************************
+// BamSequenceCodec_p.cpp (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides conversion between BAM-encoded & ASCII query sequences/qualities,
+// using SIMD kernels selected at runtime where the CPU supports them
+// ***************************************************************************
+
+#include "api/internal/bam/BamSequenceCodec_p.h"
+#include "api/BamConstants.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+// x86 kernels are compiled for their own instruction sets via target attributes,
+// so the library itself does not require any particular -m flags
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BT_X86_SEQUENCE_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace BamTools {
+namespace Internal {
+
+// offset between phred scores & FASTQ-style ASCII qualities
+static const char QUALITY_OFFSET = 33;
+
+// marks ASCII characters that are not valid bases
+static const uint8_t INVALID_BASECODE = 0xFF;
+
+// lookup tables shared by all kernels
+struct SequenceTables
+{
+    // packed byte -> its 2 ASCII bases
+    char BasePairs[256][2];
+    // ASCII base -> 4-bit code, or INVALID_BASECODE
+    uint8_t BaseCodes[256];
+    // (ASCII base & 0x1F) -> 4-bit code; the 16 valid bases are distinct in their low 5 bits
+    uint8_t BaseCodesByLowBits[32];
+
+    SequenceTables()
+    {
+        for (int i = 0; i < 256; ++i) {
+            BasePairs[i][0] = Constants::BAM_DNA_LOOKUP[i >> 4];
+            BasePairs[i][1] = Constants::BAM_DNA_LOOKUP[i & 0xF];
+            BaseCodes[i] = INVALID_BASECODE;
+        }
+        for (int i = 0; i < 32; ++i) {
+            BaseCodesByLowBits[i] = 0;
+        }
+        for (uint8_t code = 0; code < 16; ++code) {
+            const uint8_t base = Constants::BAM_DNA_LOOKUP[code];
+            BaseCodes[base] = code;
+            BaseCodesByLowBits[base & 0x1F] = code;
+        }
+    }
+};
+
+static const SequenceTables& Tables()
+{
+    static const SequenceTables tables;
+    return tables;
+}
+
+// ---------------------------
+// scalar kernels
+// ---------------------------
+
+static void DecodeBases_Scalar(const char* packed, const std::size_t numBases, char* bases)
+{
+    const SequenceTables& tables = Tables();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(packed);
+    const std::size_t numPairs = numBases / 2;
+    for (std::size_t i = 0; i < numPairs; ++i) {
+        bases[2 * i] = tables.BasePairs[data[i]][0];
+        bases[2 * i + 1] = tables.BasePairs[data[i]][1];
+    }
+    if (numBases % 2) {
+        bases[numBases - 1] = tables.BasePairs[data[numPairs]][0];
+    }
+}
+
+static std::size_t EncodeBases_Scalar(const char* bases, const std::size_t numBases, char* packed)
+{
+    const SequenceTables& tables = Tables();
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(bases);
+    std::size_t i = 0;
+    for (; i + 1 < numBases; i += 2) {
+        const uint8_t high = tables.BaseCodes[data[i]];
+        const uint8_t low = tables.BaseCodes[data[i + 1]];
+        if ((high | low) & 0xF0) {
+            return (high == INVALID_BASECODE ? i : i + 1);
+        }
+        packed[i / 2] = static_cast<char>((high << 4) | low);
+    }
+    if (i < numBases) {
+        const uint8_t high = tables.BaseCodes[data[i]];
+        if (high == INVALID_BASECODE) {
+            return i;
+        }
+        packed[i / 2] = static_cast<char>(high << 4);
+    }
+    return numBases;
+}
+
+static void OffsetQualities_Scalar(const char* in, const std::size_t length, char* out,
+                                   const char offset)
+{
+    for (std::size_t i = 0; i < length; ++i) {
+        out[i] = static_cast<char>(static_cast<uint8_t>(in[i]) + static_cast<uint8_t>(offset));
+    }
+}
+
+#ifdef BT_X86_SEQUENCE_KERNELS
+
+// ---------------------------
+// SSE2 kernels
+// ---------------------------
+
+__attribute__((target("sse2"))) static void OffsetQualities_Sse2(const char* in,
+                                                                 const std::size_t length,
+                                                                 char* out, const char offset)
+{
+    const __m128i offsets = _mm_set1_epi8(offset);
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi8(v, offsets));
+    }
+    OffsetQualities_Scalar(in + i, length - i, out + i, offset);
+}
+
+// ---------------------------
+// SSSE3 kernels
+// ---------------------------
+
+// nibble -> ASCII translation is a single byte shuffle through BAM_DNA_LOOKUP
+
+__attribute__((target("ssse3"))) static void DecodeBases_Ssse3(const char* packed,
+                                                               const std::size_t numBases,
+                                                               char* bases)
+{
+    const __m128i lookup =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(Constants::BAM_DNA_LOOKUP));
+    const __m128i lowMask = _mm_set1_epi8(0x0F);
+
+    // 32 bases (16 packed bytes) per iteration
+    std::size_t i = 0;
+    for (; i + 32 <= numBases; i += 32) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(packed + i / 2));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), lowMask);
+        const __m128i low = _mm_and_si128(v, lowMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bases + i),
+                         _mm_shuffle_epi8(lookup, _mm_unpacklo_epi8(high, low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bases + i + 16),
+                         _mm_shuffle_epi8(lookup, _mm_unpackhi_epi8(high, low)));
+    }
+
+    // then 16 bases (8 packed bytes), if available
+    if (i + 16 <= numBases) {
+        const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(packed + i / 2));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), lowMask);
+        const __m128i low = _mm_and_si128(v, lowMask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bases + i),
+                         _mm_shuffle_epi8(lookup, _mm_unpacklo_epi8(high, low)));
+        i += 16;
+    }
+
+    DecodeBases_Scalar(packed + i / 2, numBases - i, bases + i);
+}
+
+// maps 16 ASCII bases to 4-bit codes, accumulating any bytes that are not valid bases
+__attribute__((target("ssse3"))) static inline __m128i EncodeChars_Ssse3(const __m128i chars,
+                                                                         const __m128i codesLow,
+                                                                         const __m128i codesHigh,
+                                                                         const __m128i lookup,
+                                                                         __m128i& mismatches)
+{
+    const __m128i index = _mm_and_si128(chars, _mm_set1_epi8(0x1F));
+    const __m128i useHigh = _mm_cmpgt_epi8(index, _mm_set1_epi8(0x0F));
+    const __m128i codes = _mm_or_si128(_mm_andnot_si128(useHigh, _mm_shuffle_epi8(codesLow, index)),
+                                       _mm_and_si128(useHigh, _mm_shuffle_epi8(codesHigh, index)));
+
+    // a code is only valid if it maps back to the original character
+    mismatches = _mm_or_si128(mismatches, _mm_xor_si128(_mm_shuffle_epi8(lookup, codes), chars));
+    return codes;
+}
+
+__attribute__((target("ssse3"))) static std::size_t EncodeBases_Ssse3(const char* bases,
+                                                                      const std::size_t numBases,
+                                                                      char* packed)
+{
+    const SequenceTables& tables = Tables();
+    const __m128i codesLow =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.BaseCodesByLowBits));
+    const __m128i codesHigh =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.BaseCodesByLowBits + 16));
+    const __m128i lookup =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(Constants::BAM_DNA_LOOKUP));
+
+    // (high << 4) + low, for each pair of codes
+    const __m128i pairWeights = _mm_set1_epi16(0x0110);
+
+    // 32 bases per iteration, leaving the chunk holding an invalid base to the scalar kernel
+    std::size_t i = 0;
+    for (; i + 32 <= numBases; i += 32) {
+        __m128i mismatches = _mm_setzero_si128();
+        const __m128i first =
+            EncodeChars_Ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bases + i)),
+                              codesLow, codesHigh, lookup, mismatches);
+        const __m128i second =
+            EncodeChars_Ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bases + i + 16)),
+                              codesLow, codesHigh, lookup, mismatches);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(mismatches, _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+        const __m128i result = _mm_packus_epi16(_mm_maddubs_epi16(first, pairWeights),
+                                                _mm_maddubs_epi16(second, pairWeights));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(packed + i / 2), result);
+    }
+
+    return i + EncodeBases_Scalar(bases + i, numBases - i, packed + i / 2);
+}
+
+// ---------------------------
+// AVX2 kernels
+// ---------------------------
+
+__attribute__((target("avx2"))) static void DecodeBases_Avx2(const char* packed,
+                                                             const std::size_t numBases,
+                                                             char* bases)
+{
+    const __m256i lookup = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(Constants::BAM_DNA_LOOKUP)));
+    const __m256i lowMask = _mm256_set1_epi8(0x0F);
+
+    // 64 bases (32 packed bytes) per iteration
+    std::size_t i = 0;
+    for (; i + 64 <= numBases; i += 64) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(packed + i / 2));
+        const __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+        const __m256i low = _mm256_and_si256(v, lowMask);
+
+        // unpacking works within 128-bit lanes, so put the lanes back in order afterwards
+        const __m256i first = _mm256_unpacklo_epi8(high, low);
+        const __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(bases + i),
+            _mm256_shuffle_epi8(lookup, _mm256_permute2x128_si256(first, second, 0x20)));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(bases + i + 32),
+            _mm256_shuffle_epi8(lookup, _mm256_permute2x128_si256(first, second, 0x31)));
+    }
+
+    DecodeBases_Ssse3(packed + i / 2, numBases - i, bases + i);
+}
+
+// maps 32 ASCII bases to 4-bit codes, accumulating any bytes that are not valid bases
+__attribute__((target("avx2"))) static inline __m256i EncodeChars_Avx2(const __m256i chars,
+                                                                       const __m256i codesLow,
+                                                                       const __m256i codesHigh,
+                                                                       const __m256i lookup,
+                                                                       __m256i& mismatches)
+{
+    const __m256i index = _mm256_and_si256(chars, _mm256_set1_epi8(0x1F));
+    const __m256i useHigh = _mm256_cmpgt_epi8(index, _mm256_set1_epi8(0x0F));
+    const __m256i codes = _mm256_blendv_epi8(_mm256_shuffle_epi8(codesLow, index),
+                                             _mm256_shuffle_epi8(codesHigh, index), useHigh);
+
+    // a code is only valid if it maps back to the original character
+    mismatches =
+        _mm256_or_si256(mismatches, _mm256_xor_si256(_mm256_shuffle_epi8(lookup, codes), chars));
+    return codes;
+}
+
+__attribute__((target("avx2"))) static std::size_t EncodeBases_Avx2(const char* bases,
+                                                                    const std::size_t numBases,
+                                                                    char* packed)
+{
+    const SequenceTables& tables = Tables();
+    const __m256i codesLow = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.BaseCodesByLowBits)));
+    const __m256i codesHigh = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.BaseCodesByLowBits + 16)));
+    const __m256i lookup = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(Constants::BAM_DNA_LOOKUP)));
+    const __m256i pairWeights = _mm256_set1_epi16(0x0110);
+
+    // 64 bases per iteration, leaving the chunk holding an invalid base to the narrower kernels
+    std::size_t i = 0;
+    for (; i + 64 <= numBases; i += 64) {
+        __m256i mismatches = _mm256_setzero_si256();
+        const __m256i first =
+            EncodeChars_Avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bases + i)),
+                             codesLow, codesHigh, lookup, mismatches);
+        const __m256i second =
+            EncodeChars_Avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bases + i + 32)),
+                             codesLow, codesHigh, lookup, mismatches);
+        if (!_mm256_testz_si256(mismatches, mismatches)) {
+            break;
+        }
+
+        // packing works within 128-bit lanes, so put the 64-bit halves back in order afterwards
+        const __m256i result = _mm256_packus_epi16(_mm256_maddubs_epi16(first, pairWeights),
+                                                   _mm256_maddubs_epi16(second, pairWeights));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(packed + i / 2),
+                            _mm256_permute4x64_epi64(result, 0xD8));
+    }
+
+    return i + EncodeBases_Ssse3(bases + i, numBases - i, packed + i / 2);
+}
+
+__attribute__((target("avx2"))) static void OffsetQualities_Avx2(const char* in,
+                                                                 const std::size_t length,
+                                                                 char* out, const char offset)
+{
+    const __m256i offsets = _mm256_set1_epi8(offset);
+    std::size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi8(v, offsets));
+    }
+    OffsetQualities_Sse2(in + i, length - i, out + i, offset);
+}
+
+#endif  // BT_X86_SEQUENCE_KERNELS
+
+// ---------------------------
+// runtime dispatch
+// ---------------------------
+
+struct SequenceKernels
+{
+    const char* Name;
+    void (*DecodeBases)(const char*, const std::size_t, char*);
+    std::size_t (*EncodeBases)(const char*, const std::size_t, char*);
+    void (*OffsetQualities)(const char*, const std::size_t, char*, const char);
+};
+
+// picks the best kernels this CPU supports, or stops at the named set if given
+static SequenceKernels SelectKernels(const std::string& name = std::string())
+{
+    SequenceKernels kernels = {"scalar", &DecodeBases_Scalar, &EncodeBases_Scalar,
+                               &OffsetQualities_Scalar};
+#ifdef BT_X86_SEQUENCE_KERNELS
+    __builtin_cpu_init();
+    if (kernels.Name != name && __builtin_cpu_supports("sse2")) {
+        kernels.Name = "sse2";
+        kernels.OffsetQualities = &OffsetQualities_Sse2;
+    }
+    if (kernels.Name != name && __builtin_cpu_supports("sse2") && __builtin_cpu_supports("ssse3")) {
+        kernels.Name = "ssse3";
+        kernels.DecodeBases = &DecodeBases_Ssse3;
+        kernels.EncodeBases = &EncodeBases_Ssse3;
+    }
+    if (kernels.Name != name && __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("avx2")) {
+        kernels.Name = "avx2";
+        kernels.DecodeBases = &DecodeBases_Avx2;
+        kernels.EncodeBases = &EncodeBases_Avx2;
+        kernels.OffsetQualities = &OffsetQualities_Avx2;
+    }
+#endif
+    return kernels;
+}
+
+static SequenceKernels& Kernels()
+{
+    static SequenceKernels kernels = SelectKernels();
+    return kernels;
+}
+
+}  // namespace Internal
+}  // namespace BamTools
+
+// ---------------------------
+// BamSequenceCodec implementation
+// ---------------------------
+
+void BamSequenceCodec::DecodeBases(const char* packed, const std::size_t numBases, char* bases)
+{
+    Kernels().DecodeBases(packed, numBases, bases);
+}
+
+void BamSequenceCodec::DecodeQualities(const char* scores, const std::size_t numScores,
+                                       char* qualities)
+{
+    Kernels().OffsetQualities(scores, numScores, qualities, QUALITY_OFFSET);
+}
+
+std::size_t BamSequenceCodec::EncodeBases(const char* bases, const std::size_t numBases,
+                                          char* packed)
+{
+    return Kernels().EncodeBases(bases, numBases, packed);
+}
+
+void BamSequenceCodec::EncodeQualities(const char* qualities, const std::size_t numQualities,
+                                       char* scores)
+{
+    Kernels().OffsetQualities(qualities, numQualities, scores, -QUALITY_OFFSET);
+}
+
+const char* BamSequenceCodec::KernelName()
+{
+    return Kernels().Name;
+}
+
+bool BamSequenceCodec::UseKernels(const std::string& name)
+{
+    const SequenceKernels kernels = SelectKernels(name);
+    if (kernels.Name != name) {
+        return false;
+    }
+    Kernels() = kernels;
+    return true;
+}
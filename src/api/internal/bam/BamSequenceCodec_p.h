@@ -0,0 +1,56 @@
+// ***************************************************************************
+// BamSequenceCodec_p.h (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides conversion between BAM-encoded & ASCII query sequences/qualities,
+// using SIMD kernels selected at runtime where the CPU supports them
+// ***************************************************************************
+
+#ifndef BAMSEQUENCECODEC_P_H
+#define BAMSEQUENCECODEC_P_H
+
+#include "api/api_global.h"
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include <cstddef>
+#include <string>
+
+namespace BamTools {
+namespace Internal {
+
+class API_NO_EXPORT BamSequenceCodec
+{
+
+    // static 'utility' methods
+public:
+    // unpacks numBases 4-bit base codes (2 per byte, high nibble first) into ASCII bases
+    static void DecodeBases(const char* packed, const std::size_t numBases, char* bases);
+    // converts numScores phred scores into FASTQ-style ASCII qualities (+33)
+    static void DecodeQualities(const char* scores, const std::size_t numScores, char* qualities);
+    // packs numBases ASCII bases into 4-bit codes (packed needs (numBases+1)/2 bytes)
+    // returns position of the first base not in "=ACMGRSVTWYHKDBN", or numBases if all are valid
+    static std::size_t EncodeBases(const char* bases, const std::size_t numBases, char* packed);
+    // converts numQualities FASTQ-style ASCII qualities into phred scores (-33)
+    static void EncodeQualities(const char* qualities, const std::size_t numQualities,
+                                char* scores);
+    // returns name of the kernel set in use ("avx2", "ssse3", "sse2", or "scalar")
+    static const char* KernelName();
+    // switches to the named kernel set, for testing the kernels against each other (not
+    // thread-safe); returns false if this CPU does not support it
+    static bool UseKernels(const std::string& name);
+};
+
+}  // namespace Internal
+}  // namespace BamTools
+
+#endif  // BAMSEQUENCECODEC_P_H
@@ -11,6 +11,7 @@
 #include "api/BamAlignment.h"
 #include "api/BamConstants.h"
 #include "api/IBamIODevice.h"
+#include "api/internal/bam/BamSequenceCodec_p.h"
 #include "api/internal/utils/BamException_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
@@ -138,76 +139,12 @@ void BamWriterPrivate::EncodeQuerySequence(const std::string& query, std::string
     char* pEncodedQuery = (char*)encodedQuery.data();
     const char* pQuery = (const char*)query.data();
 
-    // walk through original query sequence, encoding its bases
-    unsigned char nucleotideCode;
-    bool useHighWord = true;
-    while (*pQuery) {
-        switch (*pQuery) {
-            case (Constants::BAM_DNA_EQUAL):
-                nucleotideCode = Constants::BAM_BASECODE_EQUAL;
-                break;
-            case (Constants::BAM_DNA_A):
-                nucleotideCode = Constants::BAM_BASECODE_A;
-                break;
-            case (Constants::BAM_DNA_C):
-                nucleotideCode = Constants::BAM_BASECODE_C;
-                break;
-            case (Constants::BAM_DNA_M):
-                nucleotideCode = Constants::BAM_BASECODE_M;
-                break;
-            case (Constants::BAM_DNA_G):
-                nucleotideCode = Constants::BAM_BASECODE_G;
-                break;
-            case (Constants::BAM_DNA_R):
-                nucleotideCode = Constants::BAM_BASECODE_R;
-                break;
-            case (Constants::BAM_DNA_S):
-                nucleotideCode = Constants::BAM_BASECODE_S;
-                break;
-            case (Constants::BAM_DNA_V):
-                nucleotideCode = Constants::BAM_BASECODE_V;
-                break;
-            case (Constants::BAM_DNA_T):
-                nucleotideCode = Constants::BAM_BASECODE_T;
-                break;
-            case (Constants::BAM_DNA_W):
-                nucleotideCode = Constants::BAM_BASECODE_W;
-                break;
-            case (Constants::BAM_DNA_Y):
-                nucleotideCode = Constants::BAM_BASECODE_Y;
-                break;
-            case (Constants::BAM_DNA_H):
-                nucleotideCode = Constants::BAM_BASECODE_H;
-                break;
-            case (Constants::BAM_DNA_K):
-                nucleotideCode = Constants::BAM_BASECODE_K;
-                break;
-            case (Constants::BAM_DNA_D):
-                nucleotideCode = Constants::BAM_BASECODE_D;
-                break;
-            case (Constants::BAM_DNA_B):
-                nucleotideCode = Constants::BAM_BASECODE_B;
-                break;
-            case (Constants::BAM_DNA_N):
-                nucleotideCode = Constants::BAM_BASECODE_N;
-                break;
-            default:
-                const std::string message = std::string("invalid base: ") + *pQuery;
-                throw BamException("BamWriter::EncodeQuerySequence", message);
-        }
-
-        // pack the nucleotide code
-        if (useHighWord) {
-            *pEncodedQuery = nucleotideCode << 4;
-            useHighWord = false;
-        } else {
-            *pEncodedQuery |= nucleotideCode;
-            ++pEncodedQuery;
-            useHighWord = true;
-        }
-
-        // increment the query position
-        ++pQuery;
+    // encode its bases, making sure each one is valid
+    const std::size_t invalidPosition =
+        BamSequenceCodec::EncodeBases(pQuery, queryLength, pEncodedQuery);
+    if (invalidPosition != queryLength) {
+        const std::string message = std::string("invalid base: ") + query[invalidPosition];
+        throw BamException("BamWriter::EncodeQuerySequence", message);
     }
 }
 
@@ -272,6 +209,68 @@ bool BamWriterPrivate::SaveAlignment(const BamAlignment& al)
     }
 }
 
+// saves alignment, copying raw char data when unmodified
+bool BamWriterPrivate::SaveRawAlignment(const BamAlignment& al)
+{
+
+    try {
+
+        // write the original char data if still valid, otherwise encode from alignment's fields
+        if (al.IsRawCharDataValid()) {
+            WriteCoreAlignment(al);
+        } else {
+            WriteAlignment(al);
+        }
+
+        // if we get here, everything OK
+        return true;
+
+    } catch (const BamException& e) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
+void BamWriterPrivate::SetCompressionLevel(int level)
+{
+    // modifying compression is not allowed if BAM file is open
+    if (!IsOpen()) {
+        m_stream.SetCompressionLevel(level);
+    }
+}
+
+void BamWriterPrivate::SetCompressionStrategy(const BamWriter::CompressionStrategy& strategy)
+{
+    // modifying compression is not allowed if BAM file is open
+    if (!IsOpen()) {
+        switch (strategy) {
+            case (BamWriter::Filtered):
+                m_stream.SetCompressionStrategy(BgzfStream::FilteredStrategy);
+                break;
+            case (BamWriter::HuffmanOnly):
+                m_stream.SetCompressionStrategy(BgzfStream::HuffmanOnlyStrategy);
+                break;
+            case (BamWriter::RunLength):
+                m_stream.SetCompressionStrategy(BgzfStream::RleStrategy);
+                break;
+            case (BamWriter::Fixed):
+                m_stream.SetCompressionStrategy(BgzfStream::FixedStrategy);
+                break;
+            default:
+                m_stream.SetCompressionStrategy(BgzfStream::DefaultStrategy);
+                break;
+        }
+    }
+}
+
+void BamWriterPrivate::SetNumThreads(int numThreads)
+{
+    // modifying compression threads is not allowed if BAM file is open
+    if (!IsOpen()) {
+        m_stream.SetNumThreads(numThreads);
+    }
+}
+
 void BamWriterPrivate::SetWriteCompressed(bool ok)
 {
     // modifying compression is not allowed if BAM file is open
@@ -381,10 +380,12 @@ void BamWriterPrivate::WriteAlignment(const BamAlignment& al)
             std::memset(pBaseQualities, 0xFF,
                         queryLength);  // if missing or '*', fill with invalid qual
         } else {
-            for (std::size_t i = 0; i < queryLength; ++i) {
-                pBaseQualities[i] =
-                    al.Qualities.at(i) - 33;  // FASTQ ASCII -> phred score conversion
+            if (al.Qualities.size() < queryLength) {
+                delete[] pBaseQualities;
+                throw BamException("BamWriter::WriteAlignment", "fewer qualities than query bases");
             }
+            // FASTQ ASCII -> phred score conversion
+            BamSequenceCodec::EncodeQualities(al.Qualities.data(), queryLength, pBaseQualities);
         }
         m_stream.Write(pBaseQualities, queryLength);
         delete[] pBaseQualities;
@@ -25,6 +25,7 @@
 #include <string>
 #include <vector>
 #include "api/BamAux.h"
+#include "api/BamWriter.h"
 #include "api/internal/io/BgzfStream_p.h"
 
 namespace BamTools {
@@ -49,6 +50,10 @@ public:
     bool Open(const std::string& filename, const std::string& samHeaderText,
               const BamTools::RefVector& referenceSequences);
     bool SaveAlignment(const BamAlignment& al);
+    bool SaveRawAlignment(const BamAlignment& al);
+    void SetCompressionLevel(int level);
+    void SetCompressionStrategy(const BamWriter::CompressionStrategy& strategy);
+    void SetNumThreads(int numThreads);
     void SetWriteCompressed(bool ok);
 
     // 'internal' methods
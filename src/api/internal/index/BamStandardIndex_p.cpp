@@ -11,6 +11,7 @@
 #include "api/BamAlignment.h"
 #include "api/internal/bam/BamReader_p.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
+#include "api/internal/io/BamMappedFile_p.h"
 #include "api/internal/utils/BamException_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
@@ -65,6 +66,7 @@ BamStandardIndex::RaiiWrapper::~RaiiWrapper()
 // ctor
 BamStandardIndex::BamStandardIndex(Internal::BamReaderPrivate* reader)
     : BamIndex(reader)
+    , m_mappedFile(0)
     , m_bufferLength(0)
 {
     m_isBigEndian = BamTools::SystemIsBigEndian();
@@ -102,110 +104,80 @@ void BamStandardIndex::AdjustRegion(const BamRegion& region, uint32_t& begin, ui
 }
 
 // [begin, end)
+// N.B. - bin ranges of successive levels don't overlap, so the IDs come out in ascending order
 void BamStandardIndex::CalculateCandidateBins(const uint32_t& begin, const uint32_t& end,
-                                              std::set<uint16_t>& candidateBins)
+                                              std::vector<uint16_t>& candidateBins)
 {
     // initialize list, bin '0' is always a valid bin
-    candidateBins.insert(0);
+    candidateBins.clear();
+    candidateBins.push_back(0);
 
     // get rest of bins that contain this region
     unsigned int k;
     for (k = 1 + (begin >> 26); k <= 1 + (end >> 26); ++k) {
-        candidateBins.insert(k);
+        candidateBins.push_back(k);
     }
     for (k = 9 + (begin >> 23); k <= 9 + (end >> 23); ++k) {
-        candidateBins.insert(k);
+        candidateBins.push_back(k);
     }
     for (k = 73 + (begin >> 20); k <= 73 + (end >> 20); ++k) {
-        candidateBins.insert(k);
+        candidateBins.push_back(k);
     }
     for (k = 585 + (begin >> 17); k <= 585 + (end >> 17); ++k) {
-        candidateBins.insert(k);
+        candidateBins.push_back(k);
     }
     for (k = 4681 + (begin >> 14); k <= 4681 + (end >> 14); ++k) {
-        candidateBins.insert(k);
+        candidateBins.push_back(k);
     }
 }
 
-void BamStandardIndex::CalculateCandidateOffsets(const BaiReferenceSummary& refSummary,
-                                                 const uint64_t& minOffset,
-                                                 std::set<uint16_t>& candidateBins,
-                                                 std::vector<int64_t>& offsets)
+void BamStandardIndex::CalculateCandidateChunks(const BaiReferenceCache& refCache,
+                                                const uint64_t& minOffset,
+                                                const std::vector<uint16_t>& candidateBins,
+                                                std::vector<BamIndex::Chunk>& chunks)
 {
-    // seek to first bin
-    Seek(refSummary.FirstBinFilePosition, SEEK_SET);
-
-    // iterate over reference bins
-    uint32_t binId;
-    int32_t numAlignmentChunks;
-    std::set<uint16_t>::iterator candidateBinIter;
-    for (int i = 0; i < refSummary.NumBins; ++i) {
-
-        // read bin contents (if successful, alignment chunks are now in m_buffer)
-        ReadBinIntoBuffer(binId, numAlignmentChunks);
-
-        // see if bin is a 'candidate bin'
-        candidateBinIter = candidateBins.find(binId);
-
-        // if not, move on to next bin
-        if (candidateBinIter == candidateBins.end()) {
+    // walk candidate bins & reference bins together, both are sorted by ID
+    std::vector<BaiCachedBin>::const_iterator binIter = refCache.Bins.begin();
+    const std::vector<BaiCachedBin>::const_iterator binEnd = refCache.Bins.end();
+    std::vector<uint16_t>::const_iterator candidateIter = candidateBins.begin();
+    const std::vector<uint16_t>::const_iterator candidateEnd = candidateBins.end();
+    for (; candidateIter != candidateEnd; ++candidateIter) {
+
+        // skip to candidate bin, if reference has it
+        binIter = std::lower_bound(binIter, binEnd, BaiCachedBin(*candidateIter));
+        if (binIter == binEnd) {
+            break;
+        }
+        if (binIter->ID != *candidateIter) {
             continue;
+        }
 
-            // otherwise, check bin's contents against for overlap
-        } else {
-
-            std::size_t offset = 0;
-            uint64_t chunkStart;
-            uint64_t chunkStop;
-
-            // iterate over alignment chunks
-            for (int j = 0; j < numAlignmentChunks; ++j) {
-
-                // read chunk start & stop from buffer
-                std::memcpy((char*)&chunkStart, m_resources.Buffer + offset, sizeof(uint64_t));
-                offset += sizeof(uint64_t);
-                std::memcpy((char*)&chunkStop, m_resources.Buffer + offset, sizeof(uint64_t));
-                offset += sizeof(uint64_t);
-
-                // swap endian-ness if necessary
-                if (m_isBigEndian) {
-                    SwapEndian_64(chunkStart);
-                    SwapEndian_64(chunkStop);
-                }
-
-                // store alignment chunk's start offset
-                // if its stop offset is larger than our 'minOffset'
-                if (chunkStop >= minOffset) {
-                    offsets.push_back(chunkStart);
-                }
-            }
-
-            // 'pop' bin ID from candidate bins set
-            candidateBins.erase(candidateBinIter);
-
-            // quit if no more candidates
-            if (candidateBins.empty()) {
-                break;
+        // store alignment chunk if its stop offset is larger than our 'minOffset'
+        const BaiAlignmentChunk* chunk = &refCache.Chunks[binIter->FirstChunk];
+        const BaiAlignmentChunk* chunkEnd = chunk + binIter->NumChunks;
+        for (; chunk != chunkEnd; ++chunk) {
+            if (chunk->Stop >= minOffset) {
+                chunks.push_back(BamIndex::Chunk(chunk->Start, chunk->Stop));
             }
         }
     }
 }
 
-uint64_t BamStandardIndex::CalculateMinOffset(const BaiReferenceSummary& refSummary,
+uint64_t BamStandardIndex::CalculateMinOffset(const BaiReferenceCache& refCache,
                                               const uint32_t& begin)
 {
     // if no linear offsets exist, return 0
-    if (refSummary.NumLinearOffsets == 0) {
+    if (refCache.LinearOffsets.empty()) {
         return 0;
     }
 
     // if 'begin' starts beyond last linear offset, use the last linear offset as minimum
     // else use the offset corresponding to the requested start position
-    const int shiftedBegin = begin >> BamStandardIndex::BAM_LIDX_SHIFT;
-    if (shiftedBegin >= refSummary.NumLinearOffsets) {
-        return LookupLinearOffset(refSummary, refSummary.NumLinearOffsets - 1);
+    const std::size_t shiftedBegin = begin >> BamStandardIndex::BAM_LIDX_SHIFT;
+    if (shiftedBegin >= refCache.LinearOffsets.size()) {
+        return refCache.LinearOffsets.back();
     } else {
-        return LookupLinearOffset(refSummary, shiftedBegin);
+        return refCache.LinearOffsets[shiftedBegin];
     }
 }
 
@@ -274,8 +246,10 @@ void BamStandardIndex::CloseFile()
         m_resources.Device = 0;
     }
 
-    // clear index file summary data
+    // clear index file summary & cached data
     m_indexFileSummary.clear();
+    m_indexFileCache.clear();
+    m_mappedFile = 0;
 
     // clean up I/O buffer
     delete[] m_resources.Buffer;
@@ -452,6 +426,43 @@ const std::string BamStandardIndex::Extension()
     return BamStandardIndex::BAI_EXTENSION;
 }
 
+// appends alignment chunks of all bins that may overlap @region
+bool BamStandardIndex::GetChunks(const BamRegion& region, std::vector<BamIndex::Chunk>& chunks)
+{
+
+    // cannot look up chunks if unknown/invalid reference ID requested
+    if (region.LeftRefID < 0 || region.LeftRefID >= (int)m_indexFileSummary.size()) {
+        SetErrorString("BamStandardIndex::GetChunks", "invalid reference ID requested");
+        return false;
+    }
+
+    try {
+
+        // retrieve index data for reference
+        const BaiReferenceCache& refCache = LoadReferenceCache(region.LeftRefID);
+
+        // bins cover [0, 2^29), so clip region to that
+        // (open-ended region still covers any alignments past reference end)
+        const int maxPosition = (1 << 29) - 1;
+        const uint32_t begin = std::min(std::max(region.LeftPosition, 0), maxPosition);
+        uint32_t end = maxPosition;
+        if (region.isRightBoundSpecified() && (region.LeftRefID == region.RightRefID)) {
+            end = std::max(std::min(region.RightPosition, maxPosition), (int)begin);
+        }
+
+        // collect chunks from candidate bins
+        std::vector<uint16_t> candidateBins;
+        CalculateCandidateBins(begin, end, candidateBins);
+        const uint64_t minOffset = CalculateMinOffset(refCache, begin);
+        CalculateCandidateChunks(refCache, minOffset, candidateBins, chunks);
+        return true;
+
+    } catch (const BamException& e) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
 void BamStandardIndex::GetOffset(const BamRegion& region, int64_t& offset,
                                  bool* hasAlignmentsInRegion)
 {
@@ -461,8 +472,8 @@ void BamStandardIndex::GetOffset(const BamRegion& region, int64_t& offset,
         throw BamException("BamStandardIndex::GetOffset", "invalid reference ID requested");
     }
 
-    // retrieve index summary for left bound reference
-    const BaiReferenceSummary& refSummary = m_indexFileSummary.at(region.LeftRefID);
+    // retrieve index data for left bound reference
+    const BaiReferenceCache& refCache = LoadReferenceCache(region.LeftRefID);
 
     // set up region boundaries based on actual BamReader data
     uint32_t begin;
@@ -470,20 +481,27 @@ void BamStandardIndex::GetOffset(const BamRegion& region, int64_t& offset,
     AdjustRegion(region, begin, end);
 
     // retrieve all candidate bin IDs for region
-    std::set<uint16_t> candidateBins;
+    std::vector<uint16_t> candidateBins;
     CalculateCandidateBins(begin, end, candidateBins);
 
     // use reference's linear offsets to calculate the minimum offset
     // that must be considered to find overlap
-    const uint64_t& minOffset = CalculateMinOffset(refSummary, begin);
+    const uint64_t& minOffset = CalculateMinOffset(refCache, begin);
 
-    // attempt to use reference summary, minOffset, & candidateBins to calculate offsets
+    // attempt to use reference data, minOffset, & candidateBins to calculate offsets
     // no data should not be error, just bail
-    std::vector<int64_t> offsets;
-    CalculateCandidateOffsets(refSummary, minOffset, candidateBins, offsets);
-    if (offsets.empty()) {
+    std::vector<BamIndex::Chunk> chunks;
+    CalculateCandidateChunks(refCache, minOffset, candidateBins, chunks);
+    if (chunks.empty()) {
         return;
     }
+    std::vector<int64_t> offsets;
+    offsets.reserve(chunks.size());
+    std::vector<BamIndex::Chunk>::const_iterator chunkIter = chunks.begin();
+    std::vector<BamIndex::Chunk>::const_iterator chunkEnd = chunks.end();
+    for (; chunkIter != chunkEnd; ++chunkIter) {
+        offsets.push_back((*chunkIter).Start);
+    }
 
     // ensure that offsets are sorted before processing
     sort(offsets.begin(), offsets.end());
@@ -591,6 +609,9 @@ bool BamStandardIndex::Load(const std::string& filename)
         // attempt to open file (read-only)
         OpenFile(filename, IBamIODevice::ReadOnly);
 
+        // local index files are memory-mapped, so their data can be parsed in place
+        m_mappedFile = dynamic_cast<BamMappedFile*>(m_resources.Device);
+
         // validate format
         CheckMagicNumber();
 
@@ -606,19 +627,63 @@ bool BamStandardIndex::Load(const std::string& filename)
     }
 }
 
-uint64_t BamStandardIndex::LookupLinearOffset(const BaiReferenceSummary& refSummary,
-                                              const int& index)
+// returns index data for reference, parsing it from the index file on first use
+//
+// Bins & linear offsets are kept in flat arrays, so repeated jumps into the same reference
+// need neither index file reads nor per-bin allocations.
+const BaiReferenceCache& BamStandardIndex::LoadReferenceCache(const int& refId)
 {
 
-    // attempt seek to proper index file position
-    const int64_t linearOffsetFilePosition = (int64_t)refSummary.FirstLinearOffsetFilePosition +
-                                             index * BamStandardIndex::SIZEOF_LINEAROFFSET;
-    Seek(linearOffsetFilePosition, SEEK_SET);
+    BaiReferenceCache& refCache = m_indexFileCache.at(refId);
+    if (refCache.IsLoaded) {
+        return refCache;
+    }
+    const BaiReferenceSummary& refSummary = m_indexFileSummary.at(refId);
+
+    // read all bins' alignment chunks into one array
+    Seek(refSummary.FirstBinFilePosition, SEEK_SET);
+    refCache.Bins.clear();
+    refCache.Chunks.clear();
+    refCache.Bins.reserve(refSummary.NumBins);
+    uint32_t binId;
+    int32_t numAlignmentChunks;
+    for (int i = 0; i < refSummary.NumBins; ++i) {
+        const char* chunkData = ReadBin(binId, numAlignmentChunks);
+        refCache.Bins.push_back(BaiCachedBin(binId, refCache.Chunks.size(), numAlignmentChunks));
+        for (int j = 0; j < numAlignmentChunks; ++j) {
+            BaiAlignmentChunk chunk;
+            std::memcpy((char*)&chunk.Start, chunkData, sizeof(uint64_t));
+            chunkData += sizeof(uint64_t);
+            std::memcpy((char*)&chunk.Stop, chunkData, sizeof(uint64_t));
+            chunkData += sizeof(uint64_t);
+            if (m_isBigEndian) {
+                SwapEndian_64(chunk.Start);
+                SwapEndian_64(chunk.Stop);
+            }
+            refCache.Chunks.push_back(chunk);
+        }
+    }
+
+    // bins are not necessarily stored in ID order (e.g. samtools writes them in hash order)
+    std::sort(refCache.Bins.begin(), refCache.Bins.end());
 
-    // read linear offset from BAI file
-    uint64_t linearOffset;
-    ReadLinearOffset(linearOffset);
-    return linearOffset;
+    // read linear offsets
+    Seek(refSummary.FirstLinearOffsetFilePosition, SEEK_SET);
+    const char* offsetData =
+        ReadData(refSummary.NumLinearOffsets * BamStandardIndex::SIZEOF_LINEAROFFSET);
+    refCache.LinearOffsets.resize(refSummary.NumLinearOffsets);
+    if (!refCache.LinearOffsets.empty()) {
+        std::memcpy((char*)&refCache.LinearOffsets[0], offsetData,
+                    refSummary.NumLinearOffsets * BamStandardIndex::SIZEOF_LINEAROFFSET);
+    }
+    if (m_isBigEndian) {
+        for (std::size_t i = 0; i < refCache.LinearOffsets.size(); ++i) {
+            SwapEndian_64(refCache.LinearOffsets[i]);
+        }
+    }
+
+    refCache.IsLoaded = true;
+    return refCache;
 }
 
 void BamStandardIndex::MergeAlignmentChunks(BaiAlignmentChunkVector& chunks)
@@ -670,14 +735,13 @@ void BamStandardIndex::OpenFile(const std::string& filename, IBamIODevice::OpenM
     // make sure any previous index file is closed
     CloseFile();
 
-    m_resources.Device = BamDeviceFactory::CreateDevice(filename);
+    BamDeviceFactory::OpenDevice(filename, mode, m_resources.Device);
     if (m_resources.Device == 0) {
         const std::string message = std::string("could not open file: ") + filename;
         throw BamException("BamStandardIndex::OpenFile", message);
     }
 
-    // attempt to open file
-    m_resources.Device->Open(mode);
+    // make sure file opened
     if (!IsDeviceOpen()) {
         const std::string message = std::string("could not open file: ") + filename;
         throw BamException("BamStandardIndex::OpenFile", message);
@@ -695,7 +759,8 @@ void BamStandardIndex::ReadBinID(uint32_t& binId)
     }
 }
 
-void BamStandardIndex::ReadBinIntoBuffer(uint32_t& binId, int32_t& numAlignmentChunks)
+// reads bin header, returns pointer to bin's (still encoded) alignment chunks
+const char* BamStandardIndex::ReadBin(uint32_t& binId, int32_t& numAlignmentChunks)
 {
 
     // read bin header
@@ -705,36 +770,36 @@ void BamStandardIndex::ReadBinIntoBuffer(uint32_t& binId, int32_t& numAlignmentC
     // read bin contents
     const unsigned int bytesRequested =
         numAlignmentChunks * BamStandardIndex::SIZEOF_ALIGNMENTCHUNK;
-    ReadIntoBuffer(bytesRequested);
+    return ReadData(bytesRequested);
 }
 
-void BamStandardIndex::ReadIntoBuffer(const unsigned int& bytesRequested)
+// returns pointer to the next bytesRequested bytes of index file
+// data is used in place if file is memory-mapped, otherwise read into our buffer
+// either way, it is only valid until the next read
+const char* BamStandardIndex::ReadData(const unsigned int& bytesRequested)
 {
 
-    // ensure that our buffer is big enough for request
-    BamStandardIndex::CheckBufferSize(m_resources.Buffer, m_bufferLength, bytesRequested);
-
     // read from BAI file stream
-    const int64_t bytesRead = m_resources.Device->Read(m_resources.Buffer, bytesRequested);
+    const char* data;
+    int64_t bytesRead;
+    if (m_mappedFile) {
+        unsigned int bytesAvailable = bytesRequested;
+        data = m_mappedFile->DirectRead(bytesAvailable);
+        bytesRead = bytesAvailable;
+    } else {
+        // ensure that our buffer is big enough for request
+        BamStandardIndex::CheckBufferSize(m_resources.Buffer, m_bufferLength, bytesRequested);
+        bytesRead = m_resources.Device->Read(m_resources.Buffer, bytesRequested);
+        data = m_resources.Buffer;
+    }
+
     if (bytesRead != static_cast<int64_t>(bytesRequested)) {
         std::stringstream s;
         s << "expected to read: " << bytesRequested << " bytes, "
           << "but instead read: " << bytesRead;
-        throw BamException("BamStandardIndex::ReadIntoBuffer", s.str());
-    }
-}
-
-void BamStandardIndex::ReadLinearOffset(uint64_t& linearOffset)
-{
-    const int64_t numBytesRead =
-        m_resources.Device->Read((char*)&linearOffset, sizeof(linearOffset));
-    if (m_isBigEndian) {
-        SwapEndian_64(linearOffset);
-    }
-    if (numBytesRead != sizeof(linearOffset)) {
-        throw BamException("BamStandardIndex::ReadLinearOffset",
-                           "could not read BAI linear offset");
+        throw BamException("BamStandardIndex::ReadData", s.str());
     }
+    return data;
 }
 
 void BamStandardIndex::ReadNumAlignmentChunks(int& numAlignmentChunks)
@@ -790,6 +855,8 @@ void BamStandardIndex::ReserveForSummary(const int& numReferences)
 {
     m_indexFileSummary.clear();
     m_indexFileSummary.assign(numReferences, BaiReferenceSummary());
+    m_indexFileCache.clear();
+    m_indexFileCache.resize(numReferences);
 }
 
 void BamStandardIndex::SaveAlignmentChunkToBin(BaiBinMap& binMap, const uint32_t& currentBin,
@@ -865,14 +932,14 @@ void BamStandardIndex::SkipBins(const int& numBins)
     uint32_t binId;
     int32_t numAlignmentChunks;
     for (int i = 0; i < numBins; ++i) {
-        ReadBinIntoBuffer(binId, numAlignmentChunks);  // results & buffer ignored
+        ReadBin(binId, numAlignmentChunks);  // results & data ignored
     }
 }
 
 void BamStandardIndex::SkipLinearOffsets(const int& numLinearOffsets)
 {
     const unsigned int bytesRequested = numLinearOffsets * BamStandardIndex::SIZEOF_LINEAROFFSET;
-    ReadIntoBuffer(bytesRequested);
+    ReadData(bytesRequested);
 }
 
 void BamStandardIndex::SortLinearOffsets(BaiLinearOffsetVector& linearOffsets)
@@ -23,7 +23,6 @@
 // We mean it.
 
 #include <map>
-#include <set>
 #include <string>
 #include <vector>
 #include "api/BamAux.h"
@@ -33,6 +32,8 @@
 namespace BamTools {
 namespace Internal {
 
+class BamMappedFile;
+
 // -----------------------------------------------------------------------------
 // BamStandardIndex data structures
 
@@ -104,6 +105,50 @@ struct API_NO_EXPORT BaiReferenceSummary
 // convenience typedef for describing a full BAI index file summary
 typedef std::vector<BaiReferenceSummary> BaiFileSummary;
 
+// locates a single bin's alignment chunks within BaiReferenceCache::Chunks
+struct API_NO_EXPORT BaiCachedBin
+{
+
+    // data members
+    uint32_t ID;
+    uint32_t FirstChunk;
+    uint32_t NumChunks;
+
+    // ctor
+    BaiCachedBin(const uint32_t& id = 0, const uint32_t& firstChunk = 0,
+                 const uint32_t& numChunks = 0)
+        : ID(id)
+        , FirstChunk(firstChunk)
+        , NumChunks(numChunks)
+    {}
+};
+
+// comparison operator (for sorting & searching by bin ID)
+inline bool operator<(const BaiCachedBin& lhs, const BaiCachedBin& rhs)
+{
+    return lhs.ID < rhs.ID;
+}
+
+// index data needed for random access into a single reference
+// parsed from the index file on first use, with bins in flat arrays sorted by ID
+struct API_NO_EXPORT BaiReferenceCache
+{
+
+    // data members
+    bool IsLoaded;
+    std::vector<BaiCachedBin> Bins;
+    BaiAlignmentChunkVector Chunks;
+    BaiLinearOffsetVector LinearOffsets;
+
+    // ctor
+    BaiReferenceCache()
+        : IsLoaded(false)
+    {}
+};
+
+// convenience typedef for all (loaded or not) reference caches of a BAI index file
+typedef std::vector<BaiReferenceCache> BaiFileCache;
+
 // end BamStandardIndex data structures
 // -----------------------------------------------------------------------------
 
@@ -119,6 +164,8 @@ public:
 public:
     // builds index from associated BAM file & writes out to index file
     bool Create();
+    // appends file offset ranges holding every alignment that may overlap @region
+    bool GetChunks(const BamTools::BamRegion& region, std::vector<BamIndex::Chunk>& chunks);
     // returns whether reference has alignments or no
     bool HasAlignments(const int& referenceID) const;
     // attempts to use index data to jump to @region, returns success/fail
@@ -157,13 +204,13 @@ private:
     // random-access methods
     void AdjustRegion(const BamRegion& region, uint32_t& begin, uint32_t& end);
     void CalculateCandidateBins(const uint32_t& begin, const uint32_t& end,
-                                std::set<uint16_t>& candidateBins);
-    void CalculateCandidateOffsets(const BaiReferenceSummary& refSummary, const uint64_t& minOffset,
-                                   std::set<uint16_t>& candidateBins,
-                                   std::vector<int64_t>& offsets);
-    uint64_t CalculateMinOffset(const BaiReferenceSummary& refSummary, const uint32_t& begin);
+                                std::vector<uint16_t>& candidateBins);
+    void CalculateCandidateChunks(const BaiReferenceCache& refCache, const uint64_t& minOffset,
+                                  const std::vector<uint16_t>& candidateBins,
+                                  std::vector<BamIndex::Chunk>& chunks);
+    uint64_t CalculateMinOffset(const BaiReferenceCache& refCache, const uint32_t& begin);
     void GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion);
-    uint64_t LookupLinearOffset(const BaiReferenceSummary& refSummary, const int& index);
+    const BaiReferenceCache& LoadReferenceCache(const int& refId);
 
     // BAI summary (create/load) methods
     void ReserveForSummary(const int& numReferences);
@@ -178,9 +225,8 @@ private:
 
     // BAI full index input methods
     void ReadBinID(uint32_t& binId);
-    void ReadBinIntoBuffer(uint32_t& binId, int32_t& numAlignmentChunks);
-    void ReadIntoBuffer(const unsigned int& bytesRequested);
-    void ReadLinearOffset(uint64_t& linearOffset);
+    const char* ReadBin(uint32_t& binId, int32_t& numAlignmentChunks);
+    const char* ReadData(const unsigned int& bytesRequested);
     void ReadNumAlignmentChunks(int& numAlignmentChunks);
     void ReadNumBins(int& numBins);
     void ReadNumLinearOffsets(int& numLinearOffsets);
@@ -201,6 +247,10 @@ private:
 private:
     bool m_isBigEndian;
     BaiFileSummary m_indexFileSummary;
+    BaiFileCache m_indexFileCache;
+
+    // set if index file is memory-mapped, so reads can use its data in place
+    BamMappedFile* m_mappedFile;
 
     // our input buffer
     unsigned int m_bufferLength;
@@ -22,6 +22,7 @@ using namespace BamTools::Internal;
 #include <cstring>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <map>
 
 // --------------------------------
@@ -60,6 +61,7 @@ BamToolsIndex::BamToolsIndex(Internal::BamReaderPrivate* reader)
     , m_blockSize(BamToolsIndex::DEFAULT_BLOCK_LENGTH)
     , m_inputVersion(0)
     , m_outputVersion(BTI_2_0)  // latest version - used for writing new index files
+    , m_chunkRefStopOffset(0)
 {
     m_isBigEndian = BamTools::SystemIsBigEndian();
 }
@@ -141,6 +143,7 @@ void BamToolsIndex::CloseFile()
         m_resources.Device = 0;
     }
     m_indexFileSummary.clear();
+    ClearReferenceEntry(m_chunkRefEntry);
 }
 
 // builds index from associated BAM file & writes out to index file
@@ -298,6 +301,52 @@ const std::string BamToolsIndex::Extension()
     return BamToolsIndex::BTI_EXTENSION;
 }
 
+// appends offset ranges of all blocks that may overlap @region
+// each block's data runs up to where the next block (on any reference) starts
+bool BamToolsIndex::GetChunks(const BamRegion& region, std::vector<BamIndex::Chunk>& chunks)
+{
+
+    // cannot look up chunks if unknown/invalid reference ID requested
+    if (region.LeftRefID < 0 || region.LeftRefID >= (int)m_indexFileSummary.size()) {
+        SetErrorString("BamToolsIndex::GetChunks", "invalid reference ID requested");
+        return false;
+    }
+
+    try {
+
+        // load reference's blocks, unless still loaded from last call
+        if (m_chunkRefEntry.ID != region.LeftRefID) {
+            ClearReferenceEntry(m_chunkRefEntry);
+            BtiReferenceEntry refEntry(region.LeftRefID);
+            ReadReferenceEntry(refEntry);
+            m_chunkRefStopOffset = GetReferenceStopOffset(region.LeftRefID);
+            m_chunkRefEntry = refEntry;
+        }
+
+        // blocks come sorted by start position
+        const bool hasRightBound =
+            (region.isRightBoundSpecified() && (region.LeftRefID == region.RightRefID));
+        const BtiBlockVector& blocks = m_chunkRefEntry.Blocks;
+        for (std::size_t i = 0; i < blocks.size(); ++i) {
+            const BtiBlock& block = blocks[i];
+            if (hasRightBound && block.StartPosition >= region.RightPosition) {
+                break;
+            }
+            if (block.MaxEndPosition < region.LeftPosition) {
+                continue;
+            }
+            const int64_t stopOffset =
+                ((i + 1 < blocks.size()) ? blocks[i + 1].StartOffset : m_chunkRefStopOffset);
+            chunks.push_back(BamIndex::Chunk(block.StartOffset, stopOffset));
+        }
+        return true;
+
+    } catch (const BamException& e) {
+        m_errorString = e.what();
+        return false;
+    }
+}
+
 void BamToolsIndex::GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion)
 {
 
@@ -366,6 +415,22 @@ void BamToolsIndex::GetOffset(const BamRegion& region, int64_t& offset, bool* ha
     *hasAlignmentsInRegion = found;
 }
 
+// returns offset where reference's alignment data ends, i.e. where next reference's first
+// block starts (or max offset, if no other reference follows)
+int64_t BamToolsIndex::GetReferenceStopOffset(const int& refId)
+{
+    for (std::size_t i = refId + 1; i < m_indexFileSummary.size(); ++i) {
+        const BtiReferenceSummary& refSummary = m_indexFileSummary.at(i);
+        if (refSummary.NumBlocks > 0) {
+            Seek(refSummary.FirstBlockFilePosition, SEEK_SET);
+            BtiBlock block;
+            ReadBlock(block);
+            return block.StartOffset;
+        }
+    }
+    return std::numeric_limits<int64_t>::max();
+}
+
 // returns whether reference has alignments or no
 bool BamToolsIndex::HasAlignments(const int& referenceID) const
 {
@@ -532,14 +597,13 @@ void BamToolsIndex::OpenFile(const std::string& filename, IBamIODevice::OpenMode
     // make sure any previous index file is closed
     CloseFile();
 
-    m_resources.Device = BamDeviceFactory::CreateDevice(filename);
+    BamDeviceFactory::OpenDevice(filename, mode, m_resources.Device);
     if (m_resources.Device == 0) {
         const std::string message = std::string("could not open file: ") + filename;
         throw BamException("BamStandardIndex::OpenFile", message);
     }
 
-    // attempt to open file
-    m_resources.Device->Open(mode);
+    // make sure file opened
     if (!IsDeviceOpen()) {
         const std::string message = std::string("could not open file: ") + filename;
         throw BamException("BamToolsIndex::OpenFile", message);
@@ -116,6 +116,8 @@ public:
 public:
     // builds index from associated BAM file & writes out to index file
     bool Create();
+    // appends file offset ranges holding every alignment that may overlap @region
+    bool GetChunks(const BamTools::BamRegion& region, std::vector<BamIndex::Chunk>& chunks);
     // returns whether reference has alignments or no
     bool HasAlignments(const int& referenceID) const;
     // attempts to use index data to jump to @region, returns success/fail
@@ -154,6 +156,7 @@ private:
 
     // random-access methods
     void GetOffset(const BamRegion& region, int64_t& offset, bool* hasAlignmentsInRegion);
+    int64_t GetReferenceStopOffset(const int& refId);
     void ReadBlock(BtiBlock& block);
     void ReadBlocks(const BtiReferenceSummary& refSummary, BtiBlockVector& blocks);
     void ReadReferenceEntry(BtiReferenceEntry& refEntry);
@@ -175,6 +178,10 @@ private:
     int32_t m_inputVersion;  // Version is serialized as int
     Version m_outputVersion;
 
+    // blocks of the reference last used by GetChunks(), & offset where its data ends
+    BtiReferenceEntry m_chunkRefEntry;
+    int64_t m_chunkRefStopOffset;
+
     struct RaiiWrapper
     {
         IBamIODevice* Device;
@@ -11,13 +11,15 @@
 #include "api/internal/io/BamFile_p.h"
 #include "api/internal/io/BamFtp_p.h"
 #include "api/internal/io/BamHttp_p.h"
+#include "api/internal/io/BamMappedFile_p.h"
 #include "api/internal/io/BamPipe_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
 #include <iostream>
 
-IBamIODevice* BamDeviceFactory::CreateDevice(const std::string& source)
+IBamIODevice* BamDeviceFactory::CreateDevice(const std::string& source,
+                                             const IBamIODevice::OpenMode mode)
 {
 
     // check for requested pipe
@@ -35,6 +37,33 @@ IBamIODevice* BamDeviceFactory::CreateDevice(const std::string& source)
         return new BamFtp(source);
     }
 
+    // read local files straight from memory-mapped pages, where possible
+    if (mode == IBamIODevice::ReadOnly && BamMappedFile::IsMappable(source)) {
+        return new BamMappedFile(source);
+    }
+
     // otherwise assume a "normal" file
     return new BamFile(source);
 }
+
+// creates device for source & opens it, returns true if opened
+// if a local file can't be memory-mapped, it is opened as a "normal" file instead
+bool BamDeviceFactory::OpenDevice(const std::string& source, const IBamIODevice::OpenMode mode,
+                                  IBamIODevice*& device)
+{
+    device = CreateDevice(source, mode);
+    if (device == 0) {
+        return false;
+    }
+    if (device->Open(mode)) {
+        return true;
+    }
+
+    // retry without mapping
+    if (dynamic_cast<BamMappedFile*>(device) == 0) {
+        return false;
+    }
+    delete device;
+    device = new BamFile(source);
+    return device->Open(mode);
+}
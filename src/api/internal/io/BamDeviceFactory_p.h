@@ -31,7 +31,9 @@ namespace Internal {
 class API_NO_EXPORT BamDeviceFactory
 {
 public:
-    static IBamIODevice* CreateDevice(const std::string& source);
+    static IBamIODevice* CreateDevice(const std::string& source, const IBamIODevice::OpenMode mode);
+    static bool OpenDevice(const std::string& source, const IBamIODevice::OpenMode mode,
+                           IBamIODevice*& device);
 };
 
 }  // namespace Internal
@@ -0,0 +1,216 @@
+// ***************************************************************************
+// BamMappedFile_p.cpp (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides read-only, memory-mapped BAM file IO behavior
+// ***************************************************************************
+
+#include "api/internal/io/BamMappedFile_p.h"
+#include "api/BamConstants.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+
+namespace BamTools {
+namespace Internal {
+
+// amount of data to prefetch after a seek, when access is random
+static const int64_t RANDOM_ACCESS_PREFETCH = 4 * Constants::BGZF_MAX_BLOCK_SIZE;
+
+}  // namespace Internal
+}  // namespace BamTools
+
+BamMappedFile::BamMappedFile(const std::string& filename)
+    : IBamIODevice()
+    , m_filename(filename)
+    , m_data(0)
+    , m_size(0)
+    , m_position(0)
+    , m_accessPattern(BamMappedFile::SequentialAccess)
+{}
+
+BamMappedFile::~BamMappedFile()
+{
+    Close();
+}
+
+void BamMappedFile::Advise(const int64_t& position, const int64_t& length, const int advice)
+{
+#ifndef _WIN32
+    // madvise() requires a page-aligned start address
+    static const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    const int64_t alignedPosition = position - (position % pageSize);
+    const int64_t end = std::min(position + length, m_size);
+    if (end > alignedPosition) {
+        madvise(m_data + alignedPosition, end - alignedPosition, advice);
+    }
+#else
+    (void)position;
+    (void)length;
+    (void)advice;
+#endif
+}
+
+void BamMappedFile::Close()
+{
+    if (!IsOpen()) {
+        return;
+    }
+
+#ifndef _WIN32
+    munmap(m_data, m_size);
+#endif
+    m_data = 0;
+    m_size = 0;
+    m_position = 0;
+    m_mode = IBamIODevice::NotOpen;
+}
+
+const char* BamMappedFile::DirectRead(unsigned int& numBytes)
+{
+    BT_ASSERT_X(m_data, "BamMappedFile::DirectRead: trying to read from unmapped file");
+    const int64_t available = std::max(m_size - m_position, static_cast<int64_t>(0));
+    numBytes = static_cast<unsigned int>(std::min(static_cast<int64_t>(numBytes), available));
+    const char* data = m_data + m_position;
+    m_position += numBytes;
+    return data;
+}
+
+bool BamMappedFile::IsMappable(const std::string& filename)
+{
+#ifndef _WIN32
+    struct stat fileStatus;
+    if (stat(filename.c_str(), &fileStatus) != 0) {
+        return false;
+    }
+    return (S_ISREG(fileStatus.st_mode) && fileStatus.st_size > 0);
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+bool BamMappedFile::IsRandomAccess() const
+{
+    return true;
+}
+
+bool BamMappedFile::Open(const IBamIODevice::OpenMode mode)
+{
+
+    // make sure we're starting with a fresh mapping
+    Close();
+
+    // mapped files are read-only
+    if (mode != IBamIODevice::ReadOnly) {
+        SetErrorString("BamMappedFile::Open", "only read-only access is supported");
+        return false;
+    }
+
+#ifndef _WIN32
+
+    // open file & determine its size
+    const int fd = open(m_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        const std::string message_base = std::string("could not open file handle for ");
+        const std::string message =
+            message_base + ((m_filename.empty()) ? "empty filename" : m_filename);
+        SetErrorString("BamMappedFile::Open", message);
+        return false;
+    }
+    struct stat fileStatus;
+    if (fstat(fd, &fileStatus) != 0 || fileStatus.st_size <= 0) {
+        close(fd);
+        SetErrorString("BamMappedFile::Open", "could not determine size of " + m_filename);
+        return false;
+    }
+
+    // map the whole file; the mapping stays valid after the descriptor is closed
+    void* data = mmap(0, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        SetErrorString("BamMappedFile::Open", "could not memory-map " + m_filename);
+        return false;
+    }
+
+    // store mapping & current IO mode, then return success
+    m_data = static_cast<char*>(data);
+    m_size = fileStatus.st_size;
+    m_position = 0;
+    m_mode = mode;
+    SetAccessPattern(m_accessPattern);
+    return true;
+
+#else
+    SetErrorString("BamMappedFile::Open", "memory-mapped files are not supported on this platform");
+    return false;
+#endif
+}
+
+int64_t BamMappedFile::Read(char* data, const unsigned int numBytes)
+{
+    unsigned int numBytesRead = numBytes;
+    const char* source = DirectRead(numBytesRead);
+    std::copy(source, source + numBytesRead, data);
+    return numBytesRead;
+}
+
+bool BamMappedFile::Seek(const int64_t& position, const int origin)
+{
+
+    BT_ASSERT_X(m_data, "BamMappedFile::Seek: trying to seek in unmapped file");
+
+    // determine new position
+    int64_t newPosition = position;
+    if (origin == SEEK_CUR) {
+        newPosition += m_position;
+    } else if (origin == SEEK_END) {
+        newPosition += m_size;
+    }
+    if (newPosition < 0 || newPosition > m_size) {
+        return false;
+    }
+    m_position = newPosition;
+
+#ifndef _WIN32
+    // without kernel read-ahead, fetch the data following the new position in one go
+    if (m_accessPattern == BamMappedFile::RandomAccess) {
+        Advise(m_position, RANDOM_ACCESS_PREFETCH, MADV_WILLNEED);
+    }
+#endif
+    return true;
+}
+
+void BamMappedFile::SetAccessPattern(const AccessPattern& pattern)
+{
+    m_accessPattern = pattern;
+#ifndef _WIN32
+    if (m_data) {
+        const int advice = (pattern == BamMappedFile::RandomAccess ? MADV_RANDOM : MADV_SEQUENTIAL);
+        Advise(0, m_size, advice);
+    }
+#endif
+}
+
+int64_t BamMappedFile::Tell() const
+{
+    return m_position;
+}
+
+int64_t BamMappedFile::Write(const char* data, const unsigned int numBytes)
+{
+    (void)data;
+    (void)numBytes;
+    BT_ASSERT_X(false, "BamMappedFile::Write: device not in write-able mode");
+    return -1;
+}
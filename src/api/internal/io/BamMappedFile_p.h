@@ -0,0 +1,86 @@
+// ***************************************************************************
+// BamMappedFile_p.h (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides read-only, memory-mapped BAM file IO behavior
+// ***************************************************************************
+
+#ifndef BAMMAPPEDFILE_P_H
+#define BAMMAPPEDFILE_P_H
+
+#include "api/api_global.h"
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include <string>
+#include "api/IBamIODevice.h"
+
+namespace BamTools {
+namespace Internal {
+
+// N.B. - the whole file is mapped at Open(), so it must not be truncated while open: reading
+//        pages past the new end of file, or pages the OS fails to read, raises SIGBUS instead
+//        of returning an error. Use BamDeviceFactory::OpenDevice(), which falls back to BamFile
+//        when mapping fails.
+class API_NO_EXPORT BamMappedFile : public IBamIODevice
+{
+
+    // enums
+public:
+    enum AccessPattern
+    {
+        SequentialAccess = 0,
+        RandomAccess
+    };
+
+    // ctor & dtor
+public:
+    BamMappedFile(const std::string& filename);
+    ~BamMappedFile();
+
+    // IBamIODevice implementation
+public:
+    void Close();
+    bool IsRandomAccess() const;
+    bool Open(const IBamIODevice::OpenMode mode);
+    int64_t Read(char* data, const unsigned int numBytes);
+    bool Seek(const int64_t& position, const int origin = SEEK_SET);
+    int64_t Tell() const;
+    int64_t Write(const char* data, const unsigned int numBytes);
+
+    // BamMappedFile interface
+public:
+    // returns pointer to mapped data at current position & moves past it, without copying
+    // numBytes is reduced to the number of bytes actually available
+    const char* DirectRead(unsigned int& numBytes);
+    // returns true if file can be memory-mapped (a non-empty regular file)
+    static bool IsMappable(const std::string& filename);
+    // hints to the OS how the mapped data will be traversed
+    void SetAccessPattern(const AccessPattern& pattern);
+
+    // internal methods
+private:
+    void Advise(const int64_t& position, const int64_t& length, const int advice);
+
+    // data members
+private:
+    std::string m_filename;
+    char* m_data;
+    int64_t m_size;
+    int64_t m_position;
+    AccessPattern m_accessPattern;
+};
+
+}  // namespace Internal
+}  // namespace BamTools
+
+#endif  // BAMMAPPEDFILE_P_H
@@ -0,0 +1,285 @@
+// ***************************************************************************
+// BgzfCodec_p.cpp (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides whole-block DEFLATE compression & decompression for BGZF blocks,
+// using libdeflate when available (HAVE_LIBDEFLATE) and zlib otherwise
+// ***************************************************************************
+
+#include "api/internal/io/BgzfCodec_p.h"
+#include "api/BamConstants.h"
+#include "api/internal/utils/BamException_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <zlib.h>
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#include <cstddef>
+
+// ---------------------------
+// BgzfCodec implementation
+// ---------------------------
+
+// ctor
+BgzfCodec::BgzfCodec()
+    : m_deflateStream(0)
+    , m_deflateLevel(Z_DEFAULT_COMPRESSION)
+    , m_deflateStrategy(Z_DEFAULT_STRATEGY)
+    , m_inflateStream(0)
+    , m_maxInputBufferSize(0)
+    , m_maxInputLevel(Z_DEFAULT_COMPRESSION)
+    , m_maxInputStrategy(Z_DEFAULT_STRATEGY)
+    , m_maxInputLength(0)
+#ifdef HAVE_LIBDEFLATE
+    , m_compressor(0)
+    , m_compressorLevel(0)
+    , m_decompressor(0)
+#endif
+{}
+
+// dtor
+BgzfCodec::~BgzfCodec()
+{
+    if (m_deflateStream) {
+        deflateEnd(m_deflateStream);
+        delete m_deflateStream;
+    }
+    if (m_inflateStream) {
+        inflateEnd(m_inflateStream);
+        delete m_inflateStream;
+    }
+#ifdef HAVE_LIBDEFLATE
+    if (m_compressor) {
+        libdeflate_free_compressor(m_compressor);
+    }
+    if (m_decompressor) {
+        libdeflate_free_decompressor(m_decompressor);
+    }
+#endif
+}
+
+// returns CRC32 checksum of data
+uint32_t BgzfCodec::Crc32(const char* data, const std::size_t dataLength)
+{
+#ifdef HAVE_LIBDEFLATE
+    return libdeflate_crc32(0, data, dataLength);
+#else
+    const uint32_t crc = crc32(0, NULL, 0);
+    return crc32(crc, (const Bytef*)data, dataLength);
+#endif
+}
+
+// compresses data into buffer as a raw DEFLATE stream
+std::size_t BgzfCodec::Deflate(const char* data, const std::size_t dataLength, char* buffer,
+                               const std::size_t bufferSize, const int compressionLevel,
+                               const int compressionStrategy)
+{
+
+    PrepareDeflate(compressionLevel, compressionStrategy);
+
+#ifdef HAVE_LIBDEFLATE
+    // libdeflate returns 0 if output does not fit, just like our contract
+    if (IsLibDeflateCompression(compressionLevel, compressionStrategy)) {
+        return libdeflate_deflate_compress(m_compressor, data, dataLength, buffer, bufferSize);
+    }
+#endif
+
+    // set up zlib stream for this block
+    z_stream* zs = m_deflateStream;
+    zs->next_in = (Bytef*)data;
+    zs->avail_in = dataLength;
+    zs->next_out = (Bytef*)buffer;
+    zs->avail_out = bufferSize;
+
+    // compress the data, then reset stream for next block
+    const int status = deflate(zs, Z_FINISH);
+    const std::size_t compressedLength = zs->total_out;
+    if (deflateReset(zs) != Z_OK) {
+        throw BamException("BgzfStream::DeflateBlock", "zlib deflateReset failed");
+    }
+
+    // if not at stream end
+    if (status != Z_STREAM_END) {
+
+        // there was not enough space available in buffer
+        if (status == Z_OK || status == Z_BUF_ERROR) {
+            return 0;
+        }
+
+        throw BamException("BgzfStream::DeflateBlock", "zlib deflate failed");
+    }
+
+    // return result
+    return compressedLength;
+}
+
+// decompresses raw DEFLATE stream in data into buffer
+std::size_t BgzfCodec::Inflate(const char* data, const std::size_t dataLength, char* buffer,
+                               const std::size_t bufferSize)
+{
+#ifdef HAVE_LIBDEFLATE
+    if (m_decompressor == 0) {
+        m_decompressor = libdeflate_alloc_decompressor();
+        if (m_decompressor == 0) {
+            throw BamException("BgzfStream::InflateBlock",
+                               "libdeflate could not allocate decompressor");
+        }
+    }
+
+    std::size_t numBytesOut = 0;
+    const libdeflate_result result = libdeflate_deflate_decompress(
+        m_decompressor, data, dataLength, buffer, bufferSize, &numBytesOut);
+    if (result != LIBDEFLATE_SUCCESS) {
+        throw BamException("BgzfStream::InflateBlock", "libdeflate decompression failed");
+    }
+    return numBytesOut;
+#else
+
+    // initialize zlib stream on first use
+    if (m_inflateStream == 0) {
+        m_inflateStream = new z_stream;
+        m_inflateStream->zalloc = Z_NULL;
+        m_inflateStream->zfree = Z_NULL;
+        m_inflateStream->opaque = Z_NULL;
+        m_inflateStream->next_in = Z_NULL;
+        m_inflateStream->avail_in = 0;
+        if (inflateInit2(m_inflateStream, Constants::GZIP_WINDOW_BITS) != Z_OK) {
+            delete m_inflateStream;
+            m_inflateStream = 0;
+            throw BamException("BgzfStream::InflateBlock", "zlib inflateInit failed");
+        }
+    }
+
+    // set up zlib stream for this block
+    z_stream* zs = m_inflateStream;
+    zs->next_in = (Bytef*)data;
+    zs->avail_in = dataLength;
+    zs->next_out = (Bytef*)buffer;
+    zs->avail_out = bufferSize;
+
+    // decompress, then reset stream for next block
+    const int status = inflate(zs, Z_FINISH);
+    const std::size_t uncompressedLength = zs->total_out;
+    if (inflateReset(zs) != Z_OK) {
+        throw BamException("BgzfStream::InflateBlock", "zlib inflateReset failed");
+    }
+    if (status != Z_STREAM_END) {
+        throw BamException("BgzfStream::InflateBlock", "zlib inflate failed");
+    }
+
+    // return result
+    return uncompressedLength;
+#endif
+}
+
+// returns true if libdeflate should handle these settings
+bool BgzfCodec::IsLibDeflateCompression(const int compressionLevel,
+                                        const int compressionStrategy) const
+{
+#ifdef HAVE_LIBDEFLATE
+    // libdeflate has no strategy setting, and stored-only blocks gain nothing from it,
+    // so leave those cases to zlib
+    return (compressionLevel != Z_NO_COMPRESSION && compressionStrategy == Z_DEFAULT_STRATEGY);
+#else
+    (void)compressionLevel;
+    (void)compressionStrategy;
+    return false;
+#endif
+}
+
+// returns the largest input length whose compressed size is guaranteed to fit in bufferSize
+std::size_t BgzfCodec::MaxInputLength(const std::size_t bufferSize, const int compressionLevel,
+                                      const int compressionStrategy)
+{
+
+    // reuse last result if settings are unchanged (the usual case, once per block)
+    if (bufferSize == m_maxInputBufferSize && compressionLevel == m_maxInputLevel &&
+        compressionStrategy == m_maxInputStrategy) {
+        return m_maxInputLength;
+    }
+
+    PrepareDeflate(compressionLevel, compressionStrategy);
+
+    // worst-case compressed size only grows with input size,
+    // so binary search for the largest input that fits
+    std::size_t low = 0;
+    std::size_t high = bufferSize;
+    while (low < high) {
+        const std::size_t length = low + (high - low + 1) / 2;
+        std::size_t bound = 0;
+#ifdef HAVE_LIBDEFLATE
+        if (IsLibDeflateCompression(compressionLevel, compressionStrategy)) {
+            bound = libdeflate_deflate_compress_bound(m_compressor, length);
+        } else
+#endif
+        {
+            bound = deflateBound(m_deflateStream, length);
+        }
+
+        if (bound <= bufferSize) {
+            low = length;
+        } else {
+            high = length - 1;
+        }
+    }
+
+    // store result for next call
+    m_maxInputBufferSize = bufferSize;
+    m_maxInputLevel = compressionLevel;
+    m_maxInputStrategy = compressionStrategy;
+    m_maxInputLength = low;
+    return low;
+}
+
+// ensures compressor state exists for these settings, ready for new input
+void BgzfCodec::PrepareDeflate(const int compressionLevel, const int compressionStrategy)
+{
+#ifdef HAVE_LIBDEFLATE
+    // (re-)create libdeflate compressor if level has changed
+    if (IsLibDeflateCompression(compressionLevel, compressionStrategy)) {
+        const int level = (compressionLevel < 0 ? 6 : compressionLevel);
+        if (m_compressor == 0 || m_compressorLevel != level) {
+            if (m_compressor) {
+                libdeflate_free_compressor(m_compressor);
+            }
+            m_compressor = libdeflate_alloc_compressor(level);
+            if (m_compressor == 0) {
+                throw BamException("BgzfStream::DeflateBlock",
+                                   "libdeflate could not allocate compressor");
+            }
+            m_compressorLevel = level;
+        }
+        return;
+    }
+#endif
+
+    // reuse zlib stream as long as settings are unchanged
+    if (m_deflateStream && m_deflateLevel == compressionLevel &&
+        m_deflateStrategy == compressionStrategy) {
+        return;
+    }
+
+    // otherwise (re-)initialize it
+    if (m_deflateStream) {
+        deflateEnd(m_deflateStream);
+    } else {
+        m_deflateStream = new z_stream;
+    }
+    m_deflateStream->zalloc = Z_NULL;
+    m_deflateStream->zfree = Z_NULL;
+    m_deflateStream->opaque = Z_NULL;
+    const int status =
+        deflateInit2(m_deflateStream, compressionLevel, Z_DEFLATED, Constants::GZIP_WINDOW_BITS,
+                     Constants::Z_DEFAULT_MEM_LEVEL, compressionStrategy);
+    if (status != Z_OK) {
+        delete m_deflateStream;
+        m_deflateStream = 0;
+        throw BamException("BgzfStream::DeflateBlock", "zlib deflateInit2 failed");
+    }
+    m_deflateLevel = compressionLevel;
+    m_deflateStrategy = compressionStrategy;
+}
@@ -0,0 +1,97 @@
+// ***************************************************************************
+// BgzfCodec_p.h (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides whole-block DEFLATE compression & decompression for BGZF blocks,
+// using libdeflate when available (HAVE_LIBDEFLATE) and zlib otherwise
+// ***************************************************************************
+
+#ifndef BGZFCODEC_P_H
+#define BGZFCODEC_P_H
+
+#include "api/api_global.h"
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include <cstddef>
+
+struct z_stream_s;
+#ifdef HAVE_LIBDEFLATE
+struct libdeflate_compressor;
+struct libdeflate_decompressor;
+#endif
+
+namespace BamTools {
+namespace Internal {
+
+// holds (de)compressor state for one thread of use; not thread-safe
+class API_NO_EXPORT BgzfCodec
+{
+
+    // ctor & dtor
+public:
+    BgzfCodec();
+    ~BgzfCodec();
+
+    // BgzfCodec interface
+public:
+    // compresses data into buffer as a raw DEFLATE stream
+    // returns compressed size, or 0 if the result does not fit in bufferSize
+    std::size_t Deflate(const char* data, const std::size_t dataLength, char* buffer,
+                        const std::size_t bufferSize, const int compressionLevel,
+                        const int compressionStrategy);
+    // decompresses raw DEFLATE stream in data into buffer & returns decompressed size
+    std::size_t Inflate(const char* data, const std::size_t dataLength, char* buffer,
+                        const std::size_t bufferSize);
+    // returns the largest input length whose compressed size is guaranteed to fit in bufferSize
+    // (computed once for each combination of settings, then cached)
+    std::size_t MaxInputLength(const std::size_t bufferSize, const int compressionLevel,
+                               const int compressionStrategy);
+
+    // static 'utility' methods
+public:
+    // returns CRC32 checksum of data
+    static uint32_t Crc32(const char* data, const std::size_t dataLength);
+
+    // not copyable
+private:
+    BgzfCodec(const BgzfCodec& other);
+    BgzfCodec& operator=(const BgzfCodec& other);
+
+    // internal methods
+private:
+    // returns true if libdeflate should handle these settings
+    bool IsLibDeflateCompression(const int compressionLevel, const int compressionStrategy) const;
+    // ensures compressor state exists for these settings, ready for new input
+    void PrepareDeflate(const int compressionLevel, const int compressionStrategy);
+
+    // data members
+private:
+    z_stream_s* m_deflateStream;
+    int m_deflateLevel;
+    int m_deflateStrategy;
+    z_stream_s* m_inflateStream;
+    std::size_t m_maxInputBufferSize;  // settings & result of last MaxInputLength() search
+    int m_maxInputLevel;
+    int m_maxInputStrategy;
+    std::size_t m_maxInputLength;
+#ifdef HAVE_LIBDEFLATE
+    libdeflate_compressor* m_compressor;
+    int m_compressorLevel;
+    libdeflate_decompressor* m_decompressor;
+#endif
+};
+
+}  // namespace Internal
+}  // namespace BamTools
+
+#endif  // BGZFCODEC_P_H
@@ -13,7 +13,9 @@
 #include "api/BamAux.h"
 #include "api/BamConstants.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
+#include "api/internal/io/BamMappedFile_p.h"
 #include "api/internal/utils/BamException_p.h"
+#include "api/internal/utils/BamThreadPool_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
 
@@ -22,8 +24,87 @@ using namespace BamTools::Internal;
 #include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <vector>
+
+// each worker thread keeps its own codec state
+static BgzfCodec& WorkerCodec()
+{
+    static thread_local BgzfCodec codec;
+    return codec;
+}
+
+// ---------------------------
+// DeflateJob implementation
+// ---------------------------
+
+// one block's worth of uncompressed data, handed off to a compression worker
+struct BgzfStream::DeflateJob
+{
+
+    // data members
+    std::vector<char> Input;
+    std::vector<char> Output;
+    std::future<void> Result;
+
+    // compresses all of Input into one or more BGZF blocks in Output
+    static void Run(DeflateJob* job, const int compressionLevel, const int compressionStrategy)
+    {
+        const char* input = job->Input.data();
+        int32_t remaining = static_cast<int32_t>(job->Input.size());
+        std::size_t outputLength = 0;
+        while (remaining > 0) {
+            int32_t inputLength = remaining;
+            job->Output.resize(outputLength + Constants::BGZF_MAX_BLOCK_SIZE);
+            outputLength += BgzfStream::DeflateData(WorkerCodec(), input, inputLength,
+                                                    &job->Output[outputLength], compressionLevel,
+                                                    compressionStrategy);
+            input += inputLength;
+            remaining -= inputLength;
+        }
+        job->Output.resize(outputLength);
+    }
+};
+
+// ---------------------------
+// InflateJob implementation
+// ---------------------------
+
+// one compressed block, read ahead from the device & handed off to a decompression worker
+struct BgzfStream::InflateJob
+{
+
+    // data members
+    int64_t BlockAddress;
+    const char* BlockData;
+    std::size_t BlockLength;
+    std::size_t OutputLength;
+    std::vector<char> Input;
+    std::vector<char> Output;
+    std::exception_ptr ReadError;
+    std::future<void> Result;
+
+    // ctor
+    InflateJob()
+        : BlockAddress(0)
+        , BlockData(0)
+        , BlockLength(0)
+        , OutputLength(0)
+        , Output(Constants::BGZF_DEFAULT_BLOCK_SIZE)
+    {}
+
+    // decompresses BlockData (held in Input, or in mapped file data) into Output
+    static void Run(InflateJob* job)
+    {
+        job->OutputLength = BgzfStream::InflateData(WorkerCodec(), job->BlockData, job->BlockLength,
+                                                    job->Output.data(), job->Output.size());
+    }
+};
 
 // ---------------------------
 // BgzfStream implementation
@@ -34,10 +115,16 @@ BgzfStream::BgzfStream()
     : m_blockLength(0)
     , m_blockOffset(0)
     , m_blockAddress(0)
-    , m_isWriteCompressed(true)
+    , m_nextBlockAddress(0)
+    , m_compressionLevel(Z_DEFAULT_COMPRESSION)
+    , m_compressionStrategy(Z_DEFAULT_STRATEGY)
     , m_device(0)
+    , m_mappedFile(0)
     , m_uncompressedBlock(Constants::BGZF_DEFAULT_BLOCK_SIZE)
     , m_compressedBlock(Constants::BGZF_MAX_BLOCK_SIZE)
+    , m_numThreads(1)
+    , m_threadPool(0)
+    , m_isReadAheadDone(false)
 {}
 
 // destructor
@@ -47,7 +134,7 @@ BgzfStream::~BgzfStream()
 }
 
 // checks BGZF block header
-bool BgzfStream::CheckBlockHeader(char* header)
+bool BgzfStream::CheckBlockHeader(const char* header)
 {
     return (header[0] == Constants::GZIP_ID1 && header[1] == Constants::GZIP_ID2 &&
             header[2] == Z_DEFLATED && (header[3] & Constants::FLG_FEXTRA) != 0 &&
@@ -56,6 +143,31 @@ bool BgzfStream::CheckBlockHeader(char* header)
             BamTools::UnpackUnsignedShort(&header[14]) == Constants::BGZF_LEN);
 }
 
+// waits for, and discards, all queued compression jobs
+void BgzfStream::ClearDeflateJobs()
+{
+    while (!m_deflateJobs.empty()) {
+        DeflateJob* job = m_deflateJobs.front();
+        m_deflateJobs.pop_front();
+        job->Result.wait();
+        delete job;
+    }
+}
+
+// waits for, and discards, all queued decompression jobs
+void BgzfStream::ClearInflateJobs()
+{
+    while (!m_inflateJobs.empty()) {
+        InflateJob* job = m_inflateJobs.front();
+        m_inflateJobs.pop_front();
+        if (job->Result.valid()) {
+            job->Result.wait();
+        }
+        delete job;
+    }
+    m_isReadAheadDone = false;
+}
+
 // closes BGZF file
 void BgzfStream::Close()
 {
@@ -65,18 +177,31 @@ void BgzfStream::Close()
         return;
     }
 
-    // if writing to file, flush the current BGZF block,
+    // if writing to file, flush the current BGZF block (and any queued blocks),
     // then write an empty block (as EOF marker)
     if (m_device->IsOpen() && (m_device->Mode() == IBamIODevice::WriteOnly)) {
-        FlushBlock();
+        try {
+            FlushBlock();
+            WriteDeflateJobs(0);
+        } catch (...) {
+            ClearDeflateJobs();
+            throw;
+        }
         const std::size_t blockLength = DeflateBlock(0);
         m_device->Write(m_compressedBlock.Buffer, blockLength);
     }
 
+    // shut down (de)compression workers
+    ClearDeflateJobs();
+    ClearInflateJobs();
+    delete m_threadPool;
+    m_threadPool = 0;
+
     // close device
     m_device->Close();
     delete m_device;
     m_device = 0;
+    m_mappedFile = 0;
 
     // ensure our buffers are cleared out
     m_uncompressedBlock.Clear();
@@ -86,15 +211,45 @@ void BgzfStream::Close()
     m_blockLength = 0;
     m_blockOffset = 0;
     m_blockAddress = 0;
-    m_isWriteCompressed = true;
+    m_nextBlockAddress = 0;
+    m_compressionLevel = Z_DEFAULT_COMPRESSION;
+    m_compressionStrategy = Z_DEFAULT_STRATEGY;
 }
 
 // compresses the current block
 std::size_t BgzfStream::DeflateBlock(int32_t blockLength)
 {
 
+    // compress as much of the block as will fit
+    int32_t inputLength = blockLength;
+    const std::size_t compressedLength =
+        DeflateData(m_codec, m_uncompressedBlock.Buffer, inputLength, m_compressedBlock.Buffer,
+                    m_compressionLevel, m_compressionStrategy);
+
+    // ensure that we have less than a block of data left
+    int remaining = blockLength - inputLength;
+    if (remaining > 0) {
+        if (remaining > inputLength) {
+            throw BamException("BgzfStream::DeflateBlock", "after deflate, remainder too large");
+        }
+        std::memcpy(m_uncompressedBlock.Buffer, m_uncompressedBlock.Buffer + inputLength,
+                    remaining);
+    }
+
+    // update block data
+    m_blockOffset = remaining;
+
+    // return result
+    return compressedLength;
+}
+
+// compresses up to inputLength bytes of data into a single BGZF block
+std::size_t BgzfStream::DeflateData(BgzfCodec& codec, const char* data, int32_t& inputLength,
+                                    char* buffer, const int compressionLevel,
+                                    const int compressionStrategy)
+{
+
     // initialize the gzip header
-    char* buffer = m_compressedBlock.Buffer;
     std::memset(buffer, 0, 18);
     buffer[0] = Constants::GZIP_ID1;
     buffer[1] = Constants::GZIP_ID2;
@@ -106,93 +261,44 @@ std::size_t BgzfStream::DeflateBlock(int32_t blockLength)
     buffer[13] = Constants::BGZF_ID2;
     buffer[14] = Constants::BGZF_LEN;
 
-    // set compression level
-    const int compressionLevel = (m_isWriteCompressed ? Z_DEFAULT_COMPRESSION : 0);
-
-    // loop to retry for blocks that do not compress enough
-    int inputLength = blockLength;
-    std::size_t compressedLength = 0;
-    const unsigned int bufferSize = Constants::BGZF_MAX_BLOCK_SIZE;
-
-    while (true) {
-
-        // initialize zstream values
-        z_stream zs;
-        zs.zalloc = NULL;
-        zs.zfree = NULL;
-        zs.next_in = (Bytef*)m_uncompressedBlock.Buffer;
-        zs.avail_in = inputLength;
-        zs.next_out = (Bytef*)&buffer[Constants::BGZF_BLOCK_HEADER_LENGTH];
-        zs.avail_out =
-            bufferSize - Constants::BGZF_BLOCK_HEADER_LENGTH - Constants::BGZF_BLOCK_FOOTER_LENGTH;
-
-        // initialize the zlib compression algorithm
-        int status = deflateInit2(&zs, compressionLevel, Z_DEFLATED, Constants::GZIP_WINDOW_BITS,
-                                  Constants::Z_DEFAULT_MEM_LEVEL, Z_DEFAULT_STRATEGY);
-        if (status != Z_OK) {
-            throw BamException("BgzfStream::DeflateBlock", "zlib deflateInit2 failed");
-        }
-
-        // compress the data
-        status = deflate(&zs, Z_FINISH);
-
-        // if not at stream end
-        if (status != Z_STREAM_END) {
-
-            deflateEnd(&zs);
-
-            // there was not enough space available in buffer
-            // try to reduce the input length & re-start loop
-            if (status == Z_OK) {
-                inputLength -= 1024;
-                if (inputLength < 0) {
-                    throw BamException("BgzfStream::DeflateBlock", "input reduction failed");
-                }
-                continue;
-            }
-
-            throw BamException("BgzfStream::DeflateBlock", "zlib deflate failed");
-        }
-
-        // finalize the compression routine
-        status = deflateEnd(&zs);
-        if (status != Z_OK) {
-            throw BamException("BgzfStream::DeflateBlock", "zlib deflateEnd failed");
-        }
-
-        // update compressedLength
-        compressedLength = zs.total_out + Constants::BGZF_BLOCK_HEADER_LENGTH +
-                           Constants::BGZF_BLOCK_FOOTER_LENGTH;
-        if (compressedLength > Constants::BGZF_MAX_BLOCK_SIZE) {
-            throw BamException("BgzfStream::DeflateBlock", "deflate overflow");
-        }
+    // determine how much input is guaranteed to fit, given worst-case compressed size
+    const std::size_t bufferSize = Constants::BGZF_MAX_BLOCK_SIZE -
+                                   Constants::BGZF_BLOCK_HEADER_LENGTH -
+                                   Constants::BGZF_BLOCK_FOOTER_LENGTH;
+    const int32_t safeLength = static_cast<int32_t>(
+        codec.MaxInputLength(bufferSize, compressionLevel, compressionStrategy));
+    char* deflateBuffer = &buffer[Constants::BGZF_BLOCK_HEADER_LENGTH];
+
+    // compress the data - full input is only attempted when it might compress enough
+    std::size_t deflatedLength = 0;
+    if (inputLength <= safeLength || compressionLevel != Z_NO_COMPRESSION) {
+        deflatedLength = codec.Deflate(data, inputLength, deflateBuffer, bufferSize,
+                                       compressionLevel, compressionStrategy);
+    }
 
-        // quit while loop
-        break;
+    // there was not enough space available in buffer
+    // reduce input to the length that always fits & compress again
+    if (deflatedLength == 0 && inputLength > safeLength) {
+        inputLength = safeLength;
+        deflatedLength = codec.Deflate(data, inputLength, deflateBuffer, bufferSize,
+                                       compressionLevel, compressionStrategy);
     }
+    if (deflatedLength == 0) {
+        throw BamException("BgzfStream::DeflateBlock", "deflate overflow");
+    }
+
+    // update compressedLength
+    const std::size_t compressedLength =
+        deflatedLength + Constants::BGZF_BLOCK_HEADER_LENGTH + Constants::BGZF_BLOCK_FOOTER_LENGTH;
 
     // store the compressed length
     BamTools::PackUnsignedShort(&buffer[16], static_cast<uint16_t>(compressedLength - 1));
 
     // store the CRC32 checksum
-    uint32_t crc = crc32(0, NULL, 0);
-    crc = crc32(crc, (Bytef*)m_uncompressedBlock.Buffer, inputLength);
+    const uint32_t crc = BgzfCodec::Crc32(data, inputLength);
     BamTools::PackUnsignedInt(&buffer[compressedLength - 8], crc);
     BamTools::PackUnsignedInt(&buffer[compressedLength - 4], inputLength);
 
-    // ensure that we have less than a block of data left
-    int remaining = blockLength - inputLength;
-    if (remaining > 0) {
-        if (remaining > inputLength) {
-            throw BamException("BgzfStream::DeflateBlock", "after deflate, remainder too large");
-        }
-        std::memcpy(m_uncompressedBlock.Buffer, m_uncompressedBlock.Buffer + inputLength,
-                    remaining);
-    }
-
-    // update block data
-    m_blockOffset = remaining;
-
     // return result
     return compressedLength;
 }
@@ -203,6 +309,14 @@ void BgzfStream::FlushBlock()
 
     BT_ASSERT_X(m_device, "BgzfStream::FlushBlock() - attempting to flush to null device");
 
+    // if multi-threaded, let the workers compress the block
+    if (m_numThreads > 1) {
+        if (m_blockOffset > 0) {
+            QueueDeflateJob();
+        }
+        return;
+    }
+
     // flush all of the remaining blocks
     while (m_blockOffset > 0) {
 
@@ -210,62 +324,33 @@ void BgzfStream::FlushBlock()
         const std::size_t blockLength = DeflateBlock(m_blockOffset);
 
         // flush the data to our output device
-        const int64_t numBytesWritten = m_device->Write(m_compressedBlock.Buffer, blockLength);
-
-        // check for device error
-        if (numBytesWritten < 0) {
-            const std::string message = std::string("device error: ") + m_device->GetErrorString();
-            throw BamException("BgzfStream::FlushBlock", message);
-        }
-
-        // check that we wrote expected numBytes
-        if (numBytesWritten != static_cast<int64_t>(blockLength)) {
-            std::stringstream s;
-            s << "expected to write " << blockLength << " bytes during flushing, but wrote "
-              << numBytesWritten;
-            throw BamException("BgzfStream::FlushBlock", s.str());
-        }
-
-        // update block data
-        m_blockAddress += blockLength;
+        WriteCompressedData(m_compressedBlock.Buffer, blockLength);
     }
 }
 
 // decompresses the current block
-std::size_t BgzfStream::InflateBlock(const std::size_t& blockLength)
+std::size_t BgzfStream::InflateBlock(const char* blockData, const std::size_t& blockLength)
 {
+    return InflateData(m_codec, blockData, blockLength, m_uncompressedBlock.Buffer,
+                       Constants::BGZF_DEFAULT_BLOCK_SIZE);
+}
 
-    // setup zlib stream object
-    z_stream zs;
-    zs.zalloc = NULL;
-    zs.zfree = NULL;
-    zs.next_in = (Bytef*)m_compressedBlock.Buffer + 18;
-    zs.avail_in = blockLength - 16;
-    zs.next_out = (Bytef*)m_uncompressedBlock.Buffer;
-    zs.avail_out = Constants::BGZF_DEFAULT_BLOCK_SIZE;
-
-    // initialize
-    int status = inflateInit2(&zs, Constants::GZIP_WINDOW_BITS);
-    if (status != Z_OK) {
-        throw BamException("BgzfStream::InflateBlock", "zlib inflateInit failed");
-    }
-
-    // decompress
-    status = inflate(&zs, Z_FINISH);
-    if (status != Z_STREAM_END) {
-        inflateEnd(&zs);
-        throw BamException("BgzfStream::InflateBlock", "zlib inflate failed");
-    }
+// decompresses the BGZF block in data into buffer
+std::size_t BgzfStream::InflateData(BgzfCodec& codec, const char* data,
+                                    const std::size_t blockLength, char* buffer,
+                                    const std::size_t bufferSize)
+{
 
-    // finalize
-    status = inflateEnd(&zs);
-    if (status != Z_OK) {
-        inflateEnd(&zs);
-        throw BamException("BgzfStream::InflateBlock", "zlib inflateEnd failed");
+    // block must at least hold its header & footer
+    const std::size_t overhead =
+        Constants::BGZF_BLOCK_HEADER_LENGTH + Constants::BGZF_BLOCK_FOOTER_LENGTH;
+    if (blockLength < overhead) {
+        throw BamException("BgzfStream::InflateBlock", "invalid BSIZE");
     }
 
-    // return result
-    return zs.total_out;
+    // decompress the DEFLATE data between header & footer
+    return codec.Inflate(data + Constants::BGZF_BLOCK_HEADER_LENGTH, blockLength - overhead, buffer,
+                         bufferSize);
 }
 
 bool BgzfStream::IsOpen() const
@@ -285,15 +370,38 @@ void BgzfStream::Open(const std::string& filename, const IBamIODevice::OpenMode
                 "BgzfStream::Open() - unable to properly close previous IO device");
 
     // retrieve new IO device depending on filename
-    m_device = BamDeviceFactory::CreateDevice(filename);
+    const bool deviceOpened = BamDeviceFactory::OpenDevice(filename, mode, m_device);
     BT_ASSERT_X(m_device, "BgzfStream::Open() - unable to create IO device from filename");
 
     // if device fails to open
-    if (!m_device->Open(mode)) {
+    if (!deviceOpened) {
         const std::string deviceError = m_device->GetErrorString();
         const std::string message = std::string("could not open BGZF stream: \n\t") + deviceError;
         throw BamException("BgzfStream::Open", message);
     }
+
+    // memory-mapped files let us inflate blocks straight from the mapped data
+    m_mappedFile = dynamic_cast<BamMappedFile*>(m_device);
+}
+
+// returns pointer to the next dataLength bytes, if all within the current uncompressed block
+const char* BgzfStream::Peek(const std::size_t dataLength)
+{
+
+    // load next block if current one is used up
+    if (m_blockOffset >= m_blockLength) {
+        if (m_device == 0 || !m_device->IsOpen() || (m_device->Mode() != IBamIODevice::ReadOnly)) {
+            return 0;
+        }
+        ReadBlock();
+    }
+
+    // return data only if it doesn't straddle a block boundary
+    const int32_t bytesAvailable = m_blockLength - m_blockOffset;
+    if (bytesAvailable <= 0 || static_cast<std::size_t>(bytesAvailable) < dataLength) {
+        return 0;
+    }
+    return m_uncompressedBlock.Buffer + m_blockOffset;
 }
 
 // reads BGZF data into a byte buffer
@@ -340,7 +448,7 @@ std::size_t BgzfStream::Read(char* data, const std::size_t dataLength)
 
     // update block data
     if (m_blockOffset == m_blockLength) {
-        m_blockAddress = m_device->Tell();
+        m_blockAddress = m_nextBlockAddress;
         m_blockOffset = 0;
         m_blockLength = 0;
     }
@@ -349,29 +457,153 @@ std::size_t BgzfStream::Read(char* data, const std::size_t dataLength)
     return numBytesRead;
 }
 
+// hands the current block off to the compression workers
+void BgzfStream::QueueDeflateJob()
+{
+
+    // start workers on first use
+    if (m_threadPool == 0) {
+        m_threadPool = new BamThreadPool(m_numThreads);
+    }
+
+    // keep a bounded number of blocks in flight
+    WriteDeflateJobs(2 * m_numThreads - 1);
+
+    // copy block data into new job & submit
+    DeflateJob* job = new DeflateJob;
+    job->Input.assign(m_uncompressedBlock.Buffer, m_uncompressedBlock.Buffer + m_blockOffset);
+    job->Result = m_threadPool->Submit(
+        std::bind(&DeflateJob::Run, job, m_compressionLevel, m_compressionStrategy));
+    m_deflateJobs.push_back(job);
+
+    // block buffer is free for new data
+    m_blockOffset = 0;
+}
+
+// reads ahead compressed blocks & hands them off to the decompression workers
+void BgzfStream::QueueInflateJobs()
+{
+
+    // start workers on first use
+    if (m_threadPool == 0) {
+        m_threadPool = new BamThreadPool(m_numThreads);
+    }
+
+    // keep a bounded number of blocks in flight
+    const std::size_t maxPending = 2 * m_numThreads;
+    while (!m_isReadAheadDone && m_inflateJobs.size() < maxPending) {
+
+        // mapped file data can be handed to workers as-is, otherwise need a buffer to read into
+        InflateJob* job = new InflateJob;
+        if (m_mappedFile == 0) {
+            job->Input.resize(Constants::BGZF_MAX_BLOCK_SIZE);
+        }
+
+        // read compressed block from device; any error is deferred until
+        // the consumer actually reaches this block
+        try {
+            job->BlockData =
+                ReadCompressedBlock(job->Input.data(), job->BlockAddress, job->BlockLength);
+        } catch (...) {
+            job->ReadError = std::current_exception();
+            m_inflateJobs.push_back(job);
+            m_isReadAheadDone = true;
+            break;
+        }
+
+        // stop at end of data
+        if (job->BlockLength == 0) {
+            delete job;
+            m_isReadAheadDone = true;
+            break;
+        }
+
+        // submit job
+        job->Result = m_threadPool->Submit(std::bind(&InflateJob::Run, job));
+        m_inflateJobs.push_back(job);
+    }
+}
+
 // reads a BGZF block
 void BgzfStream::ReadBlock()
 {
 
     BT_ASSERT_X(m_device, "BgzfStream::ReadBlock() - trying to read from null IO device");
 
-    // store block's starting address
-    const int64_t blockAddress = m_device->Tell();
+    int64_t blockAddress = 0;
+    std::size_t newBlockLength = 0;
 
-    // read block header from file
-    char header[Constants::BGZF_BLOCK_HEADER_LENGTH];
-    int64_t numBytesRead = m_device->Read(header, Constants::BGZF_BLOCK_HEADER_LENGTH);
+    // if multi-threaded, take the next block from the read-ahead queue
+    if (m_numThreads > 1) {
 
-    // check for device error
-    if (numBytesRead < 0) {
-        const std::string message = std::string("device error: ") + m_device->GetErrorString();
-        throw BamException("BgzfStream::ReadBlock", message);
+        // make sure read-ahead is running
+        QueueInflateJobs();
+        if (m_inflateJobs.empty()) {
+            m_blockLength = 0;
+            m_nextBlockAddress = m_device->Tell();
+            return;
+        }
+
+        // take ownership of next job & refill the queue behind it
+        std::unique_ptr<InflateJob> job(m_inflateJobs.front());
+        m_inflateJobs.pop_front();
+        if (job->ReadError) {
+            std::rethrow_exception(job->ReadError);
+        }
+        QueueInflateJobs();
+
+        // wait for its result (re-throws any worker exception)
+        job->Result.get();
+        std::memcpy(m_uncompressedBlock.Buffer, job->Output.data(), job->OutputLength);
+        blockAddress = job->BlockAddress;
+        newBlockLength = job->OutputLength;
+        m_nextBlockAddress = blockAddress + job->BlockLength;
     }
 
+    // otherwise read & decompress block here
+    else {
+
+        // read compressed block
+        std::size_t blockLength = 0;
+        const char* blockData =
+            ReadCompressedBlock(m_compressedBlock.Buffer, blockAddress, blockLength);
+
+        // if block header empty
+        if (blockLength == 0) {
+            m_blockLength = 0;
+            m_nextBlockAddress = blockAddress;
+            return;
+        }
+
+        // decompress block data
+        newBlockLength = InflateBlock(blockData, blockLength);
+        m_nextBlockAddress = blockAddress + blockLength;
+    }
+
+    // update block data
+    if (m_blockLength != 0) {
+        m_blockOffset = 0;
+    }
+    m_blockAddress = blockAddress;
+    m_blockLength = newBlockLength;
+}
+
+// reads the next compressed BGZF block from the IO device
+const char* BgzfStream::ReadCompressedBlock(char* buffer, int64_t& blockAddress,
+                                            std::size_t& blockLength)
+{
+
+    // store block's starting address
+    blockAddress = m_device->Tell();
+    blockLength = 0;
+
+    // read block header from file
+    int64_t numBytesRead = 0;
+    const char* block = ReadDeviceData(buffer, Constants::BGZF_BLOCK_HEADER_LENGTH, numBytesRead);
+
     // if block header empty
     if (numBytesRead == 0) {
-        m_blockLength = 0;
-        return;
+        return 0;
     }
 
     // if block header invalid size
@@ -380,43 +612,52 @@ void BgzfStream::ReadBlock()
     }
 
     // validate block header contents
-    if (!BgzfStream::CheckBlockHeader(header)) {
+    if (!BgzfStream::CheckBlockHeader(block)) {
         throw BamException("BgzfStream::ReadBlock", "invalid block header contents");
     }
 
-    // copy header contents to compressed buffer
-    const std::size_t blockLength = BamTools::UnpackUnsignedShort(&header[16]) + 1;
-    std::memcpy(m_compressedBlock.Buffer, header, Constants::BGZF_BLOCK_HEADER_LENGTH);
-
     // read remainder of block
-    if (blockLength < Constants::BGZF_BLOCK_HEADER_LENGTH) {
+    const std::size_t length = BamTools::UnpackUnsignedShort(&block[16]) + 1;
+    if (length < Constants::BGZF_BLOCK_HEADER_LENGTH) {
         throw BamException("BgzfStream::ReadBlock", "invalid BSIZE");
     }
 
-    const std::size_t remaining = blockLength - Constants::BGZF_BLOCK_HEADER_LENGTH;
-    numBytesRead =
-        m_device->Read(&m_compressedBlock.Buffer[Constants::BGZF_BLOCK_HEADER_LENGTH], remaining);
-
-    // check for device error
-    if (numBytesRead < 0) {
-        const std::string message = std::string("device error: ") + m_device->GetErrorString();
-        throw BamException("BgzfStream::ReadBlock", message);
-    }
+    const std::size_t remaining = length - Constants::BGZF_BLOCK_HEADER_LENGTH;
+    char* remainder = (m_mappedFile ? 0 : &buffer[Constants::BGZF_BLOCK_HEADER_LENGTH]);
+    ReadDeviceData(remainder, remaining, numBytesRead);
 
     // check that we read in expected numBytes
     if (numBytesRead != static_cast<int64_t>(remaining)) {
         throw BamException("BgzfStream::ReadBlock", "could not read data from block");
     }
 
-    // decompress block data
-    const std::size_t newBlockLength = InflateBlock(blockLength);
+    // return compressed block
+    blockLength = length;
+    return block;
+}
 
-    // update block data
-    if (m_blockLength != 0) {
-        m_blockOffset = 0;
+// reads numBytes from the IO device
+const char* BgzfStream::ReadDeviceData(char* buffer, const std::size_t numBytes,
+                                       int64_t& numBytesRead)
+{
+
+    // point directly into mapped file data, if available
+    if (m_mappedFile) {
+        unsigned int numBytesAvailable = numBytes;
+        const char* data = m_mappedFile->DirectRead(numBytesAvailable);
+        numBytesRead = numBytesAvailable;
+        return data;
     }
-    m_blockAddress = blockAddress;
-    m_blockLength = newBlockLength;
+
+    // otherwise read into buffer
+    numBytesRead = m_device->Read(buffer, numBytes);
+
+    // check for device error
+    if (numBytesRead < 0) {
+        const std::string message = std::string("device error: ") + m_device->GetErrorString();
+        throw BamException("BgzfStream::ReadBlock", message);
+    }
+    return buffer;
 }
 
 // seek to position in BGZF file
@@ -434,6 +675,31 @@ void BgzfStream::Seek(const int64_t& position)
     int blockOffset = (position & 0xFFFF);
     int64_t blockAddress = (position >> 16) & 0xFFFFFFFFFFFFLL;
 
+    // if target block is already in the read-ahead queue, keep it & everything after it
+    // otherwise, discard all in-flight blocks
+    bool isBlockQueued = false;
+    std::deque<InflateJob*>::const_iterator jobIter = m_inflateJobs.begin();
+    std::deque<InflateJob*>::const_iterator jobEnd = m_inflateJobs.end();
+    for (; jobIter != jobEnd; ++jobIter) {
+        if ((*jobIter)->BlockAddress == blockAddress && !(*jobIter)->ReadError) {
+            isBlockQueued = true;
+            break;
+        }
+    }
+    if (isBlockQueued) {
+        while (m_inflateJobs.front()->BlockAddress != blockAddress) {
+            InflateJob* job = m_inflateJobs.front();
+            m_inflateJobs.pop_front();
+            job->Result.wait();
+            delete job;
+        }
+        m_blockLength = 0;
+        m_blockAddress = blockAddress;
+        m_blockOffset = blockOffset;
+        return;
+    }
+    ClearInflateJobs();
+
     // attempt seek in file
     if (m_device->IsRandomAccess() && m_device->Seek(blockAddress)) {
 
@@ -448,9 +714,72 @@ void BgzfStream::Seek(const int64_t& position)
     }
 }
 
+// sets compression level
+void BgzfStream::SetCompressionLevel(int level)
+{
+    if (level < 0) {
+        m_compressionLevel = Z_DEFAULT_COMPRESSION;
+    } else {
+        m_compressionLevel = std::min(level, static_cast<int>(Z_BEST_COMPRESSION));
+    }
+}
+
+// sets compression strategy
+void BgzfStream::SetCompressionStrategy(const CompressionStrategy& strategy)
+{
+    switch (strategy) {
+        case (BgzfStream::FilteredStrategy):
+            m_compressionStrategy = Z_FILTERED;
+            break;
+        case (BgzfStream::HuffmanOnlyStrategy):
+            m_compressionStrategy = Z_HUFFMAN_ONLY;
+            break;
+        case (BgzfStream::RleStrategy):
+            m_compressionStrategy = Z_RLE;
+            break;
+        case (BgzfStream::FixedStrategy):
+            m_compressionStrategy = Z_FIXED;
+            break;
+        default:
+            m_compressionStrategy = Z_DEFAULT_STRATEGY;
+            break;
+    }
+}
+
+// sets number of threads used for block (de)compression
+void BgzfStream::SetNumThreads(int numThreads)
+{
+    // changing worker count is not allowed while blocks are in flight
+    if (m_threadPool == 0) {
+        m_numThreads = (numThreads > 1 ? numThreads : 1);
+    }
+}
+
+// hints that reads will jump around the file, rather than stream through it
+void BgzfStream::SetRandomAccess(bool ok)
+{
+    if (m_mappedFile) {
+        m_mappedFile->SetAccessPattern(ok ? BamMappedFile::RandomAccess
+                                          : BamMappedFile::SequentialAccess);
+    }
+}
+
 void BgzfStream::SetWriteCompressed(bool ok)
 {
-    m_isWriteCompressed = ok;
+    m_compressionLevel = (ok ? Z_DEFAULT_COMPRESSION : Z_NO_COMPRESSION);
+}
+
+// advances past dataLength bytes previously returned by Peek()
+void BgzfStream::Skip(const std::size_t dataLength)
+{
+
+    // update block data
+    m_blockOffset += dataLength;
+    if (m_blockOffset == m_blockLength) {
+        m_blockAddress = m_nextBlockAddress;
+        m_blockOffset = 0;
+        m_blockLength = 0;
+    }
 }
 
 // get file position in BGZF file
@@ -501,3 +830,45 @@ std::size_t BgzfStream::Write(const char* data, const std::size_t dataLength)
     // return actual number of bytes written
     return numBytesWritten;
 }
+
+// writes compressed data to the IO device
+void BgzfStream::WriteCompressedData(const char* data, const std::size_t dataLength)
+{
+
+    // flush the data to our output device
+    const int64_t numBytesWritten = m_device->Write(data, dataLength);
+
+    // check for device error
+    if (numBytesWritten < 0) {
+        const std::string message = std::string("device error: ") + m_device->GetErrorString();
+        throw BamException("BgzfStream::FlushBlock", message);
+    }
+
+    // check that we wrote expected numBytes
+    if (numBytesWritten != static_cast<int64_t>(dataLength)) {
+        std::stringstream s;
+        s << "expected to write " << dataLength << " bytes during flushing, but wrote "
+          << numBytesWritten;
+        throw BamException("BgzfStream::FlushBlock", s.str());
+    }
+
+    // update block data
+    m_blockAddress += dataLength;
+}
+
+// writes finished compression jobs, in order, until no more than maxPending remain queued
+void BgzfStream::WriteDeflateJobs(const std::size_t maxPending)
+{
+    while (m_deflateJobs.size() > maxPending) {
+
+        // take ownership of oldest job, wait for its result (re-throws any worker exception)
+        std::unique_ptr<DeflateJob> job(m_deflateJobs.front());
+        m_deflateJobs.pop_front();
+        job->Result.get();
+
+        // write its compressed block(s)
+        if (!job->Output.empty()) {
+            WriteCompressedData(job->Output.data(), job->Output.size());
+        }
+    }
+}
@@ -25,16 +25,32 @@
 // We mean it.
 
 #include <cstddef>
+#include <deque>
 #include <string>
 #include "api/BamAux.h"
 #include "api/IBamIODevice.h"
+#include "api/internal/io/BgzfCodec_p.h"
 
 namespace BamTools {
 namespace Internal {
 
+class BamMappedFile;
+class BamThreadPool;
+
 class API_NO_EXPORT BgzfStream
 {
 
+    // enums
+public:
+    enum CompressionStrategy
+    {
+        DefaultStrategy = 0,
+        FilteredStrategy,
+        HuffmanOnlyStrategy,
+        RleStrategy,
+        FixedStrategy
+    };
+
     // constructor & destructor
 public:
     BgzfStream();
@@ -50,10 +66,23 @@ public:
     void Open(const std::string& filename, const IBamIODevice::OpenMode mode);
     // reads BGZF data into a byte buffer
     std::size_t Read(char* data, const std::size_t dataLength);
+    // returns pointer to the next dataLength bytes, if all within the current uncompressed block
+    // (does not advance; returns 0 if data would straddle a block boundary)
+    const char* Peek(const std::size_t dataLength);
     // seek to position in BGZF file
     void Seek(const int64_t& position);
+    // advances past dataLength bytes previously returned by Peek()
+    void Skip(const std::size_t dataLength);
+    // sets compression level (0-9, negative for zlib default)
+    void SetCompressionLevel(int level);
+    // sets compression strategy
+    void SetCompressionStrategy(const CompressionStrategy& strategy);
     // sets IO device (closes previous, if any, but does not attempt to open)
     void SetIODevice(IBamIODevice* device);
+    // sets number of threads used for block (de)compression (<= 1 works on caller's thread)
+    void SetNumThreads(int numThreads);
+    // hints that reads will jump around the file (e.g. region queries), rather than stream through it
+    void SetRandomAccess(bool ok);
     // enable/disable compressed output
     void SetWriteCompressed(bool ok);
     // get file position in BGZF file
@@ -63,31 +92,70 @@ public:
 
     // internal methods
 private:
+    struct DeflateJob;
+    struct InflateJob;
+
+    // waits for, and discards, all queued compression jobs
+    void ClearDeflateJobs();
+    // waits for, and discards, all queued decompression jobs
+    void ClearInflateJobs();
     // compresses the current block
     std::size_t DeflateBlock(int32_t blockLength);
     // flushes the data in the BGZF block
     void FlushBlock();
     // de-compresses the current block
-    std::size_t InflateBlock(const std::size_t& blockLength);
+    std::size_t InflateBlock(const char* blockData, const std::size_t& blockLength);
+    // hands the current block off to the compression workers
+    void QueueDeflateJob();
+    // reads ahead compressed blocks & hands them off to the decompression workers
+    void QueueInflateJobs();
     // reads a BGZF block
     void ReadBlock();
+    // reads the next compressed BGZF block from the IO device, returns pointer to block data
+    // (either buffer, or mapped file data) & sets blockLength, which is 0 at end of data
+    const char* ReadCompressedBlock(char* buffer, int64_t& blockAddress, std::size_t& blockLength);
+    // reads numBytes from the IO device, returns pointer to data (either buffer, or mapped file data)
+    const char* ReadDeviceData(char* buffer, const std::size_t numBytes, int64_t& numBytesRead);
+    // writes compressed data to the IO device
+    void WriteCompressedData(const char* data, const std::size_t dataLength);
+    // writes finished compression jobs, in order, until no more than maxPending remain queued
+    void WriteDeflateJobs(const std::size_t maxPending);
 
     // static 'utility' methods
 public:
     // checks BGZF block header
-    static bool CheckBlockHeader(char* header);
+    static bool CheckBlockHeader(const char* header);
+    // compresses up to inputLength bytes of data into a single BGZF block in buffer,
+    // updates inputLength with the number of bytes consumed & returns the block size
+    static std::size_t DeflateData(BgzfCodec& codec, const char* data, int32_t& inputLength,
+                                   char* buffer, const int compressionLevel,
+                                   const int compressionStrategy);
+    // decompresses the BGZF block in data into buffer & returns the uncompressed size
+    static std::size_t InflateData(BgzfCodec& codec, const char* data,
+                                   const std::size_t blockLength, char* buffer,
+                                   const std::size_t bufferSize);
 
     // data members
 public:
     int32_t m_blockLength;
     int32_t m_blockOffset;
     int64_t m_blockAddress;
+    int64_t m_nextBlockAddress;
 
-    bool m_isWriteCompressed;
+    int m_compressionLevel;
+    int m_compressionStrategy;
     IBamIODevice* m_device;
+    BamMappedFile* m_mappedFile;
 
     RaiiBuffer m_uncompressedBlock;
     RaiiBuffer m_compressedBlock;
+    BgzfCodec m_codec;
+
+    int m_numThreads;
+    BamThreadPool* m_threadPool;
+    std::deque<DeflateJob*> m_deflateJobs;
+    std::deque<InflateJob*> m_inflateJobs;
+    bool m_isReadAheadDone;
 };
 
 }  // namespace Internal
@@ -0,0 +1,82 @@
+// ***************************************************************************
+// BamThreadPool_p.cpp (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides a fixed-size pool of worker threads for BamTools internals
+// ***************************************************************************
+
+#include "api/internal/utils/BamThreadPool_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+#include <utility>
+
+// ctor
+BamThreadPool::BamThreadPool(const int numThreads)
+    : m_isStopping(false)
+{
+    const int count = (numThreads > 0 ? numThreads : 1);
+    m_workers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        m_workers.push_back(std::thread(&BamThreadPool::RunWorker, this));
+    }
+}
+
+// dtor - finishes any queued tasks, then joins workers
+BamThreadPool::~BamThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_taskAvailable.notify_all();
+
+    std::vector<std::thread>::iterator workerIter = m_workers.begin();
+    std::vector<std::thread>::iterator workerEnd = m_workers.end();
+    for (; workerIter != workerEnd; ++workerIter) {
+        if (workerIter->joinable()) {
+            workerIter->join();
+        }
+    }
+}
+
+int BamThreadPool::NumThreads() const
+{
+    return static_cast<int>(m_workers.size());
+}
+
+// worker loop: pops & runs tasks until pool is stopped and queue is drained
+void BamThreadPool::RunWorker()
+{
+    while (true) {
+
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_isStopping && m_tasks.empty()) {
+                m_taskAvailable.wait(lock);
+            }
+            if (m_tasks.empty()) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        // packaged_task stores any exception in its shared state
+        task();
+    }
+}
+
+std::future<void> BamThreadPool::Submit(const std::function<void()>& task)
+{
+    std::packaged_task<void()> packagedTask(task);
+    std::future<void> result = packagedTask.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(packagedTask));
+    }
+    m_taskAvailable.notify_one();
+    return result;
+}
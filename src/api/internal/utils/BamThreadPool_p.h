@@ -0,0 +1,66 @@
+// ***************************************************************************
+// BamThreadPool_p.h (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 16 October 2026
+// ---------------------------------------------------------------------------
+// Provides a fixed-size pool of worker threads for BamTools internals
+// ***************************************************************************
+
+#ifndef BAMTHREADPOOL_P_H
+#define BAMTHREADPOOL_P_H
+
+#include "api/api_global.h"
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BamTools {
+namespace Internal {
+
+class API_NO_EXPORT BamThreadPool
+{
+
+    // ctor & dtor
+public:
+    explicit BamThreadPool(const int numThreads);
+    ~BamThreadPool();
+
+    // BamThreadPool interface
+public:
+    // returns number of worker threads
+    int NumThreads() const;
+    // queues task for execution; any exception thrown by the task is re-thrown from future.get()
+    std::future<void> Submit(const std::function<void()>& task);
+
+    // internal methods
+private:
+    void RunWorker();
+
+    // data members
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::packaged_task<void()> > m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    bool m_isStopping;
+};
+
+}  // namespace Internal
+}  // namespace BamTools
+
+#endif  // BAMTHREADPOOL_P_H
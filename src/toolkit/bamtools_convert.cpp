@@ -77,6 +77,7 @@ struct ConvertTool::ConvertSettings
 {
 
     // flag
+    bool HasBed;
     bool HasInput;
     bool HasInputFilelist;
     bool HasOutput;
@@ -89,6 +90,7 @@ struct ConvertTool::ConvertSettings
     bool IsPrintingPileupMapQualities;
 
     // options
+    std::string BedFilename;
     std::vector<std::string> InputFiles;
     std::string InputFilelist;
     std::string OutputFilename;
@@ -100,7 +102,8 @@ struct ConvertTool::ConvertSettings
 
     // constructor
     ConvertSettings()
-        : HasInput(false)
+        : HasBed(false)
+        , HasInput(false)
         , HasInputFilelist(false)
         , HasOutput(false)
         , HasFormat(false)
@@ -192,6 +195,14 @@ bool ConvertTool::ConvertToolPrivate::Run()
         }
     }
 
+    // -region & -bed are mutually exclusive
+    if (m_settings->HasRegion && m_settings->HasBed) {
+        std::cerr << "bamtools convert ERROR: -region and -bed cannot be used together... "
+                     "Aborting."
+                  << std::endl;
+        return false;
+    }
+
     // open input files
     BamMultiReader reader;
     if (!reader.Open(m_settings->InputFiles)) {
@@ -238,6 +249,34 @@ bool ConvertTool::ConvertToolPrivate::Run()
         }
     }
 
+    // set BED file regions if specified, these always require index data
+    if (m_settings->HasBed) {
+
+        std::vector<BamRegion> regions;
+        if (!Utilities::ParseBedFile(m_settings->BedFilename, m_references, regions)) {
+            std::cerr << "bamtools convert ERROR: could not parse BED file: "
+                      << m_settings->BedFilename << std::endl;
+            reader.Close();
+            return false;
+        }
+
+        if (!reader.LocateIndexes() || !reader.HasIndexes()) {
+            std::cerr << "bamtools convert ERROR: -bed requires index data for all input BAM "
+                         "files"
+                      << std::endl;
+            reader.Close();
+            return false;
+        }
+
+        if (!reader.SetRegions(regions)) {
+            std::cerr << "bamtools convert ERROR: set regions failed. Check that BED file "
+                         "describes valid ranges"
+                      << std::endl;
+            reader.Close();
+            return false;
+        }
+    }
+
     // if output file given
     std::ofstream outFile;
     if (m_settings->HasOutput) {
@@ -988,8 +1027,8 @@ ConvertTool::ConvertTool()
     // set program details
     Options::SetProgramInfo("bamtools convert", "converts BAM to a number of other formats",
                             "-format <FORMAT> [-in <filename> -in <filename> ... | -list "
-                            "<filelist>] [-out <filename>] [-region <REGION>] [format-specific "
-                            "options]");
+                            "<filelist>] [-out <filename>] [-region <REGION> | -bed <filename>] "
+                            "[format-specific options]");
 
     // set up options
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
@@ -1009,6 +1048,10 @@ ConvertTool::ConvertTool()
                             "is used automatically if it exists. See \'bamtools help index\' for "
                             "more details on creating one",
                             "", m_settings->HasRegion, m_settings->Region, IO_Opts);
+    Options::AddValueOption("-bed", "filename",
+                            "BED file of genomic regions, converts alignments overlapping any of "
+                            "them. Requires index file",
+                            "", m_settings->HasBed, m_settings->BedFilename, IO_Opts);
 
     OptionGroup* PileupOpts = Options::CreateOptionGroup("Pileup Options");
     Options::AddValueOption("-fasta", "FASTA filename", "FASTA reference file", "",
@@ -27,18 +27,21 @@ struct CountTool::CountSettings
 {
 
     // flags
+    bool HasBed;
     bool HasInput;
     bool HasInputFilelist;
     bool HasRegion;
 
     // filenames
+    std::string BedFilename;
     std::vector<std::string> InputFiles;
     std::string InputFilelist;
     std::string Region;
 
     // constructor
     CountSettings()
-        : HasInput(false)
+        : HasBed(false)
+        , HasInput(false)
         , HasInputFilelist(false)
         , HasRegion(false)
     {}
@@ -89,6 +92,13 @@ bool CountTool::CountToolPrivate::Run()
         }
     }
 
+    // -region & -bed are mutually exclusive
+    if (m_settings->HasRegion && m_settings->HasBed) {
+        std::cerr << "bamtools count ERROR: -region and -bed cannot be used together... Aborting."
+                  << std::endl;
+        return false;
+    }
+
     // open reader without index
     BamMultiReader reader;
     if (!reader.Open(m_settings->InputFiles)) {
@@ -102,7 +112,39 @@ bool CountTool::CountToolPrivate::Run()
     int alignmentCount(0);
 
     // if no region specified, count entire file
-    if (!m_settings->HasRegion) {
+    if (!m_settings->HasRegion && !m_settings->HasBed) {
+        while (reader.GetNextAlignmentCore(al)) {
+            ++alignmentCount;
+        }
+    }
+
+    // if BED file specified, count alignments overlapping any of its regions
+    else if (m_settings->HasBed) {
+
+        std::vector<BamRegion> regions;
+        if (!Utilities::ParseBedFile(m_settings->BedFilename, reader.GetReferenceData(), regions)) {
+            std::cerr << "bamtools count ERROR: could not parse BED file: "
+                      << m_settings->BedFilename << std::endl;
+            reader.Close();
+            return false;
+        }
+
+        // index data required for all BAM files
+        if (!reader.LocateIndexes() || !reader.HasIndexes()) {
+            std::cerr << "bamtools count ERROR: -bed requires index data for all input BAM files"
+                      << std::endl;
+            reader.Close();
+            return false;
+        }
+
+        // set regions & count
+        if (!reader.SetRegions(regions)) {
+            std::cerr << "bamtools count ERROR: set regions failed. Check that BED file "
+                         "describes valid ranges"
+                      << std::endl;
+            reader.Close();
+            return false;
+        }
         while (reader.GetNextAlignmentCore(al)) {
             ++alignmentCount;
         }
@@ -181,7 +223,8 @@ CountTool::CountTool()
     // set program details
     Options::SetProgramInfo(
         "bamtools count", "prints number of alignments in BAM file(s)",
-        "[-in <filename> -in <filename> ... | -list <filelist>] [-region <REGION>]");
+        "[-in <filename> -in <filename> ... | -list <filelist>] [-region <REGION> | -bed "
+        "<filename>]");
 
     // set up options
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
@@ -195,6 +238,10 @@ CountTool::CountTool()
                             "is used automatically if it exists. See \'bamtools help index\' for "
                             "more details on creating one",
                             "", m_settings->HasRegion, m_settings->Region, IO_Opts);
+    Options::AddValueOption("-bed", "filename",
+                            "BED file of genomic regions, counts alignments overlapping any of "
+                            "them. Requires index file",
+                            "", m_settings->HasBed, m_settings->BedFilename, IO_Opts);
 }
 
 CountTool::~CountTool()
@@ -19,15 +19,24 @@ using namespace BamTools;
 #include <json/json.h>
 using namespace Json;
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <cstdio>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace BamTools {
 
+// alignments read per batch when checking filters on multiple threads
+const std::size_t FILTER_BATCH_SIZE = 16384;
+
 // -------------------------------
 // string literal constants
 
@@ -63,223 +72,785 @@ const std::string FALSE_STR = "false";
 
 RefVector filterToolReferences;
 
+// TAG:VALUE filter, with VALUE pre-parsed for each tag type it may be compared against
+struct AlignmentTagPredicate
+{
+
+    template <typename T>
+    struct ParsedValue
+    {
+        bool IsValid;
+        T Value;
+        PropertyFilterValue::ValueCompareType Type;
+
+        ParsedValue()
+            : IsValid(false)
+            , Value()
+            , Type(PropertyFilterValue::EXACT)
+        {}
+        void parse(const std::string& token);
+        bool check(const T& query) const
+        {
+            return IsValid && PropertyFilterValue::compare(query, Value, Type);
+        }
+    };
+
+    // data members
+    std::string TagName;  // empty if filter string is invalid, nothing matches then
+    ParsedValue<int8_t> AsciiValue;
+    ParsedValue<int32_t> IntValue;
+    ParsedValue<uint32_t> UIntValue;
+    ParsedValue<float> RealValue;
+    ParsedValue<std::string> StringValue;
+
+    // methods
+    bool check(const BamAlignment& al) const;
+    void parse(const Variant& entireTagFilter);
+};
+
+// references & start positions of the alignments that may pass a filter
+//
+// Unless IsBounded, any alignment may pass. Otherwise, Positions holds the range of start
+// positions per RefID (empty if first > second), and HasUnplaced whether alignments without
+// a reference (RefID -1, Position -1) may pass too.
+struct AlignmentBounds
+{
+
+    typedef std::pair<int64_t, int64_t> PositionRange;
+
+    // data members
+    bool IsBounded;
+    bool HasUnplaced;
+    std::vector<PositionRange> Positions;
+
+    // ctor
+    AlignmentBounds()
+        : IsBounded(false)
+        , HasUnplaced(true)
+    {}
+
+    // methods
+    void intersect(const AlignmentBounds& other);
+    void setRange(const PositionRange& range);
+    void unite(const AlignmentBounds& other);
+
+    static PositionRange allPositions()
+    {
+        return PositionRange(std::numeric_limits<int32_t>::min(),
+                             std::numeric_limits<int32_t>::max());
+    }
+    static PositionRange noPositions()
+    {
+        return PositionRange(0, -1);
+    }
+};
+
+// a single property filter value, compiled for checking against alignments
+//
+// The property is identified by an enum & its filter value is held already converted to
+// the type it is compared with, so checks need no property name or Variant lookups.
+struct AlignmentPredicate
+{
+
+    enum Field
+    {
+        ALIGNMENTFLAG = 0,
+        CIGAR,
+        INSERTSIZE,
+        ISDUPLICATE,
+        ISFAILEDQC,
+        ISFIRSTMATE,
+        ISMAPPED,
+        ISMATEMAPPED,
+        ISMATEREVERSESTRAND,
+        ISPAIRED,
+        ISPRIMARYALIGNMENT,
+        ISPROPERPAIR,
+        ISREVERSESTRAND,
+        ISSECONDMATE,
+        ISSINGLETON,
+        LENGTH,
+        MAPQUALITY,
+        MATEPOSITION,
+        MATEREFERENCE,
+        NAME,
+        POSITION,
+        QUERYBASES,
+        REFERENCE,
+        TAG
+    };
+
+    // data members
+    Field FieldId;
+    PropertyFilterValue::ValueCompareType Type;
+    bool IsValid;                        // false if filter value has wrong type, nothing matches
+    int64_t IntValue;                    // numeric & boolean properties
+    std::string StringValue;             // string properties
+    std::vector<char> ReferenceMatches;  // (mate)reference properties, result per RefID
+    AlignmentTagPredicate Tag;           // tag property
+    double Cost;                         // relative cost of a check, cheaper ones run first
+    std::string Description;             // "property:value", for profile report
+
+    // profile counters, only updated by checkProfiled()
+    mutable uint64_t NumChecked;
+    mutable uint64_t NumPassed;
+    mutable double Seconds;
+
+    // ctor
+    AlignmentPredicate()
+        : FieldId(ALIGNMENTFLAG)
+        , Type(PropertyFilterValue::EXACT)
+        , IsValid(false)
+        , IntValue(0)
+        , Cost(0.0)
+        , NumChecked(0)
+        , NumPassed(0)
+        , Seconds(0.0)
+    {}
+
+    // methods
+    void bound(AlignmentBounds& bounds) const;
+    bool check(BamAlignment& al) const;
+    bool checkProfiled(BamAlignment& al) const;
+    bool compile(const std::string& propertyName, const PropertyFilterValue& valueFilter);
+
+private:
+    static double fieldCost(const Field& field);
+    void describe(const std::string& propertyName, const Variant& value);
+    template <typename T>
+    bool compileInt(const Variant& value);
+    bool compileReferenceMatches(const Variant& value);
+    bool compileString(const Variant& value);
+};
+
+struct AlignmentPredicateCostLess
+{
+    bool operator()(const AlignmentPredicate& lhs, const AlignmentPredicate& rhs) const
+    {
+        return lhs.Cost < rhs.Cost;
+    }
+};
+
 struct BamAlignmentChecker
 {
-    bool check(const PropertyFilter& filter, const BamAlignment& al)
+    // filter set, compiled to the list of its property checks (all must pass), cheapest first
+    struct CompiledFilter
     {
+        std::vector<AlignmentPredicate> Predicates;
+        double Cost;
 
-        bool keepAlignment = true;
-        const PropertyMap& properties = filter.Properties;
-        PropertyMap::const_iterator propertyIter = properties.begin();
-        PropertyMap::const_iterator propertyEnd = properties.end();
-        for (; propertyIter != propertyEnd; ++propertyIter) {
+        // profile counters, only updated while profiling
+        mutable uint64_t NumChecked;
+        mutable uint64_t NumPassed;
 
-            // check alignment data field depending on propertyName
-            const std::string& propertyName = (*propertyIter).first;
-            const PropertyFilterValue& valueFilter = (*propertyIter).second;
-
-            if (propertyName == ALIGNMENTFLAG_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.AlignmentFlag);
-            } else if (propertyName == CIGAR_PROPERTY) {
-                std::stringstream cigarSs;
-                const std::vector<CigarOp>& cigarData = al.CigarData;
-                if (!cigarData.empty()) {
-                    std::vector<CigarOp>::const_iterator cigarBegin = cigarData.begin();
-                    std::vector<CigarOp>::const_iterator cigarIter = cigarBegin;
-                    std::vector<CigarOp>::const_iterator cigarEnd = cigarData.end();
-                    for (; cigarIter != cigarEnd; ++cigarIter) {
-                        const CigarOp& op = (*cigarIter);
-                        cigarSs << op.Length << op.Type;
-                    }
-                    keepAlignment &= valueFilter.check(cigarSs.str());
-                }
-            } else if (propertyName == INSERTSIZE_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.InsertSize);
-            } else if (propertyName == ISDUPLICATE_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsDuplicate());
-            } else if (propertyName == ISFAILEDQC_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsFailedQC());
-            } else if (propertyName == ISFIRSTMATE_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsFirstMate());
-            } else if (propertyName == ISMAPPED_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsMapped());
-            } else if (propertyName == ISMATEMAPPED_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsMateMapped());
-            } else if (propertyName == ISMATEREVERSESTRAND_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsMateReverseStrand());
-            } else if (propertyName == ISPAIRED_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsPaired());
-            } else if (propertyName == ISPRIMARYALIGNMENT_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsPrimaryAlignment());
-            } else if (propertyName == ISPROPERPAIR_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsProperPair());
-            } else if (propertyName == ISREVERSESTRAND_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsReverseStrand());
-            } else if (propertyName == ISSECONDMATE_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.IsSecondMate());
-            } else if (propertyName == ISSINGLETON_PROPERTY) {
-                const bool isSingleton = al.IsPaired() && al.IsMapped() && !al.IsMateMapped();
-                keepAlignment &= valueFilter.check(isSingleton);
-            } else if (propertyName == LENGTH_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.Length);
-            } else if (propertyName == MAPQUALITY_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.MapQuality);
-            } else if (propertyName == MATEPOSITION_PROPERTY) {
-                keepAlignment &=
-                    (al.IsPaired() && al.IsMateMapped() && valueFilter.check(al.MateRefID));
-            } else if (propertyName == MATEREFERENCE_PROPERTY) {
-                if (!al.IsPaired() || !al.IsMateMapped()) {
-                    return false;
-                }
-                BAMTOOLS_ASSERT_MESSAGE(
-                    (al.MateRefID >= 0 && (al.MateRefID < (int)filterToolReferences.size())),
-                    "Invalid MateRefID");
-                const std::string& refName = filterToolReferences.at(al.MateRefID).RefName;
-                keepAlignment &= valueFilter.check(refName);
-            } else if (propertyName == NAME_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.Name);
-            } else if (propertyName == POSITION_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.Position);
-            } else if (propertyName == QUERYBASES_PROPERTY) {
-                keepAlignment &= valueFilter.check(al.QueryBases);
-            } else if (propertyName == REFERENCE_PROPERTY) {
-                BAMTOOLS_ASSERT_MESSAGE(
-                    (al.RefID >= 0 && (al.RefID < (int)filterToolReferences.size())),
-                    "Invalid RefID");
-                const std::string& refName = filterToolReferences.at(al.RefID).RefName;
-                keepAlignment &= valueFilter.check(refName);
-            } else if (propertyName == TAG_PROPERTY) {
-                keepAlignment &= checkAlignmentTag(valueFilter, al);
+        CompiledFilter()
+            : Cost(0.0)
+            , NumChecked(0)
+            , NumPassed(0)
+        {}
+    };
+
+    // if set, checks count & time each predicate
+    bool IsProfiling;
+
+    BamAlignmentChecker()
+        : IsProfiling(false)
+    {}
+
+    CompiledFilter compile(const PropertyFilter& filter)
+    {
+        CompiledFilter compiled;
+        compiled.Predicates.reserve(filter.Properties.size());
+        PropertyMap::const_iterator propertyIter = filter.Properties.begin();
+        PropertyMap::const_iterator propertyEnd = filter.Properties.end();
+        for (; propertyIter != propertyEnd; ++propertyIter) {
+            AlignmentPredicate predicate;
+            if (predicate.compile((*propertyIter).first, (*propertyIter).second)) {
+                compiled.Predicates.push_back(predicate);
+                compiled.Cost += predicate.Cost;
             } else {
                 BAMTOOLS_ASSERT_UNREACHABLE;
             }
+        }
 
-            // if alignment fails at ANY point, just quit and return false
-            if (!keepAlignment) {
-                return false;
-            }
+        // stable, so equal-cost predicates keep property name order
+        std::stable_sort(compiled.Predicates.begin(), compiled.Predicates.end(),
+                         AlignmentPredicateCostLess());
+        return compiled;
+    }
+
+    void bound(const CompiledFilter& filter, AlignmentBounds& bounds)
+    {
+        // alignment must pass ALL predicates
+        std::vector<AlignmentPredicate>::const_iterator predicateIter = filter.Predicates.begin();
+        std::vector<AlignmentPredicate>::const_iterator predicateEnd = filter.Predicates.end();
+        for (; predicateIter != predicateEnd; ++predicateIter) {
+            AlignmentBounds predicateBounds;
+            (*predicateIter).bound(predicateBounds);
+            bounds.intersect(predicateBounds);
         }
+    }
 
-        BAMTOOLS_ASSERT_MESSAGE(
-            keepAlignment, "Error in BamAlignmentChecker... keepAlignment should be true here");
-        return keepAlignment;
+    double cost(const CompiledFilter& filter)
+    {
+        return filter.Cost;
     }
 
-    bool checkAlignmentTag(const PropertyFilterValue& valueFilter, const BamAlignment& al)
+    bool check(const CompiledFilter& filter, BamAlignment& al)
     {
+        if (IsProfiling) {
+            return checkProfiled(filter, al);
+        }
 
-        // ensure filter contains string data
-        Variant entireTagFilter = valueFilter.Value;
-        if (!entireTagFilter.is_type<std::string>()) {
-            return false;
+        // if alignment fails at ANY point, just quit and return false
+        std::vector<AlignmentPredicate>::const_iterator predicateIter = filter.Predicates.begin();
+        std::vector<AlignmentPredicate>::const_iterator predicateEnd = filter.Predicates.end();
+        for (; predicateIter != predicateEnd; ++predicateIter) {
+            if (!(*predicateIter).check(al)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    bool checkProfiled(const CompiledFilter& filter, BamAlignment& al)
+    {
+        ++filter.NumChecked;
+        std::vector<AlignmentPredicate>::const_iterator predicateIter = filter.Predicates.begin();
+        std::vector<AlignmentPredicate>::const_iterator predicateEnd = filter.Predicates.end();
+        for (; predicateIter != predicateEnd; ++predicateIter) {
+            if (!(*predicateIter).checkProfiled(al)) {
+                return false;
+            }
         }
+        ++filter.NumPassed;
+        return true;
+    }
+};
 
-        // localize string from variant
-        const std::string& entireTagFilterString = entireTagFilter.get<std::string>();
+// -------------------------------
+// AlignmentBounds implementation
 
-        // ensure we have at least "XX:x"
-        if (entireTagFilterString.length() < 4) {
-            return false;
+void AlignmentBounds::intersect(const AlignmentBounds& other)
+{
+
+    if (!other.IsBounded) {
+        return;
+    }
+    if (!IsBounded) {
+        (*this) = other;
+        return;
+    }
+
+    HasUnplaced = HasUnplaced && other.HasUnplaced;
+    for (std::size_t i = 0; i < Positions.size(); ++i) {
+        PositionRange& range = Positions[i];
+        range.first = std::max(range.first, other.Positions[i].first);
+        range.second = std::min(range.second, other.Positions[i].second);
+    }
+}
+
+// bounds all references to the same range of start positions
+// N.B. - requires filterToolReferences to be loaded
+void AlignmentBounds::setRange(const PositionRange& range)
+{
+    IsBounded = true;
+    HasUnplaced = (range.first <= -1 && range.second >= -1);
+    Positions.assign(filterToolReferences.size(), range);
+}
+
+void AlignmentBounds::unite(const AlignmentBounds& other)
+{
+
+    if (!IsBounded) {
+        return;
+    }
+    if (!other.IsBounded) {
+        (*this) = other;
+        return;
+    }
+
+    // keeps one range per reference, so union of ranges becomes the range spanning both
+    HasUnplaced = HasUnplaced || other.HasUnplaced;
+    for (std::size_t i = 0; i < Positions.size(); ++i) {
+        PositionRange& range = Positions[i];
+        const PositionRange& otherRange = other.Positions[i];
+        if (otherRange.first > otherRange.second) {
+            continue;
+        }
+        if (range.first > range.second) {
+            range = otherRange;
+        } else {
+            range.first = std::min(range.first, otherRange.first);
+            range.second = std::max(range.second, otherRange.second);
         }
+    }
+}
 
-        // get tagName & lookup in alignment
-        // if found, set tagType to tag type character
-        // if not found, return false
-        const std::string& tagName = entireTagFilterString.substr(0, 2);
-        char tagType = '\0';
-        if (!al.GetTagType(tagName, tagType)) {
+// -------------------------------
+// AlignmentTagPredicate implementation
+
+template <typename T>
+void AlignmentTagPredicate::ParsedValue<T>::parse(const std::string& token)
+{
+    IsValid = FilterEngine<BamAlignmentChecker>::parseToken(token, Value, Type);
+}
+
+bool AlignmentTagPredicate::check(const BamAlignment& al) const
+{
+
+    // lookup tagName in alignment
+    // if found, set tagType to tag type character
+    // if not found, return false
+    char tagType = '\0';
+    if (TagName.empty() || !al.GetTagType(TagName, tagType)) {
+        return false;
+    }
+
+    // switch on tag type to get tag query value & compare to filter value of that type
+    int8_t asciiQueryValue;
+    int32_t intQueryValue;
+    uint32_t uintQueryValue;
+    float realQueryValue;
+    std::string stringQueryValue;
+    switch (tagType) {
+
+        // ASCII tag type
+        case 'A':
+            return al.GetTag(TagName, asciiQueryValue) && AsciiValue.check(asciiQueryValue);
+
+        // signed int tag type
+        case 'c':
+        case 's':
+        case 'i':
+            return al.GetTag(TagName, intQueryValue) && IntValue.check(intQueryValue);
+
+        // unsigned int tag type
+        case 'C':
+        case 'S':
+        case 'I':
+            return al.GetTag(TagName, uintQueryValue) && UIntValue.check(uintQueryValue);
+
+        // 'real' tag type
+        case 'f':
+            return al.GetTag(TagName, realQueryValue) && RealValue.check(realQueryValue);
+
+        // string tag type
+        case 'Z':
+        case 'H':
+            return al.GetTag(TagName, stringQueryValue) && StringValue.check(stringQueryValue);
+
+        // unknown tag type
+        default:
             return false;
-        }
+    }
+}
 
-        // remove tagName & ':' from beginning tagFilter
-        std::string tagFilterString = entireTagFilterString.substr(3);
-
-        // switch on tag type to set tag query value & parse filter token
-        int8_t asciiFilterValue, asciiQueryValue;
-        int32_t intFilterValue, intQueryValue;
-        uint32_t uintFilterValue, uintQueryValue;
-        float realFilterValue, realQueryValue;
-        std::string stringFilterValue, stringQueryValue;
-
-        PropertyFilterValue tagFilter;
-        PropertyFilterValue::ValueCompareType compareType;
-        bool keepAlignment = false;
-        switch (tagType) {
-
-            // ASCII tag type
-            case 'A':
-                if (al.GetTag(tagName, asciiQueryValue)) {
-                    if (FilterEngine<BamAlignmentChecker>::parseToken(
-                            tagFilterString, asciiFilterValue, compareType)) {
-                        tagFilter.Value = asciiFilterValue;
-                        tagFilter.Type = compareType;
-                        keepAlignment = tagFilter.check(asciiQueryValue);
-                    }
-                }
-                break;
-
-            // signed int tag type
-            case 'c':
-            case 's':
-            case 'i':
-                if (al.GetTag(tagName, intQueryValue)) {
-                    if (FilterEngine<BamAlignmentChecker>::parseToken(
-                            tagFilterString, intFilterValue, compareType)) {
-                        tagFilter.Value = intFilterValue;
-                        tagFilter.Type = compareType;
-                        keepAlignment = tagFilter.check(intQueryValue);
-                    }
-                }
-                break;
-
-            // unsigned int tag type
-            case 'C':
-            case 'S':
-            case 'I':
-                if (al.GetTag(tagName, uintQueryValue)) {
-                    if (FilterEngine<BamAlignmentChecker>::parseToken(
-                            tagFilterString, uintFilterValue, compareType)) {
-                        tagFilter.Value = uintFilterValue;
-                        tagFilter.Type = compareType;
-                        keepAlignment = tagFilter.check(uintQueryValue);
-                    }
-                }
-                break;
-
-            // 'real' tag type
-            case 'f':
-                if (al.GetTag(tagName, realQueryValue)) {
-                    if (FilterEngine<BamAlignmentChecker>::parseToken(
-                            tagFilterString, realFilterValue, compareType)) {
-                        tagFilter.Value = realFilterValue;
-                        tagFilter.Type = compareType;
-                        keepAlignment = tagFilter.check(realQueryValue);
-                    }
-                }
-                break;
-
-                // string tag type
-
-            case 'Z':
-            case 'H':
-                if (al.GetTag(tagName, stringQueryValue)) {
-                    if (FilterEngine<BamAlignmentChecker>::parseToken(
-                            tagFilterString, stringFilterValue, compareType)) {
-                        tagFilter.Value = stringFilterValue;
-                        tagFilter.Type = compareType;
-                        keepAlignment = tagFilter.check(stringQueryValue);
-                    }
+void AlignmentTagPredicate::parse(const Variant& entireTagFilter)
+{
+
+    // ensure filter contains string data, with at least "XX:x"
+    TagName.clear();
+    if (!entireTagFilter.is_type<std::string>()) {
+        return;
+    }
+    const std::string& entireTagFilterString = entireTagFilter.get<std::string>();
+    if (entireTagFilterString.length() < 4) {
+        return;
+    }
+
+    // remove tagName & ':' from beginning of tagFilter, then parse remainder for each type
+    TagName = entireTagFilterString.substr(0, 2);
+    const std::string tagFilterString = entireTagFilterString.substr(3);
+    AsciiValue.parse(tagFilterString);
+    IntValue.parse(tagFilterString);
+    UIntValue.parse(tagFilterString);
+    RealValue.parse(tagFilterString);
+    StringValue.parse(tagFilterString);
+}
+
+// -------------------------------
+// AlignmentPredicate implementation
+
+// sets bounds to the alignments this predicate may pass
+// only reference & position predicates are bounded, others may pass anything
+void AlignmentPredicate::bound(AlignmentBounds& bounds) const
+{
+
+    // nothing passes an invalid filter value
+    if (!IsValid) {
+        bounds.setRange(AlignmentBounds::noPositions());
+        return;
+    }
+
+    const int64_t value = IntValue;
+    switch (FieldId) {
+        case (POSITION):
+            switch (Type) {
+                case (PropertyFilterValue::EXACT):
+                    bounds.setRange(AlignmentBounds::PositionRange(value, value));
+                    break;
+                case (PropertyFilterValue::GREATER_THAN):
+                    bounds.setRange(AlignmentBounds::PositionRange(
+                        value + 1, AlignmentBounds::allPositions().second));
+                    break;
+                case (PropertyFilterValue::GREATER_THAN_EQUAL):
+                    bounds.setRange(AlignmentBounds::PositionRange(
+                        value, AlignmentBounds::allPositions().second));
+                    break;
+                case (PropertyFilterValue::LESS_THAN):
+                    bounds.setRange(AlignmentBounds::PositionRange(
+                        AlignmentBounds::allPositions().first, value - 1));
+                    break;
+                case (PropertyFilterValue::LESS_THAN_EQUAL):
+                    bounds.setRange(AlignmentBounds::PositionRange(
+                        AlignmentBounds::allPositions().first, value));
+                    break;
+                default:
+                    break;
+            }
+            break;
+
+        // unplaced alignments never match a reference name
+        case (REFERENCE):
+            bounds.setRange(AlignmentBounds::allPositions());
+            bounds.HasUnplaced = false;
+            for (std::size_t i = 0; i < ReferenceMatches.size(); ++i) {
+                if (!ReferenceMatches[i]) {
+                    bounds.Positions[i] = AlignmentBounds::noPositions();
                 }
-                break;
+            }
+            break;
 
-            // unknown tag type
-            default:
-                keepAlignment = false;
+        default:
+            break;
+    }
+}
+
+// N.B. - alignment may be core-only, name & query bases are decoded here if needed
+bool AlignmentPredicate::check(BamAlignment& al) const
+{
+
+    if (!IsValid) {
+        return false;
+    }
+
+    switch (FieldId) {
+        case (ALIGNMENTFLAG):
+            return PropertyFilterValue::compare<int64_t>(al.AlignmentFlag, IntValue, Type);
+        case (CIGAR): {
+            // reads without CIGAR data always pass
+            const std::vector<CigarOp>& cigarData = al.CigarData;
+            if (cigarData.empty()) {
+                return true;
+            }
+            std::string cigar;
+            cigar.reserve(cigarData.size() * 4);
+            char digits[10];
+            std::vector<CigarOp>::const_iterator cigarIter = cigarData.begin();
+            std::vector<CigarOp>::const_iterator cigarEnd = cigarData.end();
+            for (; cigarIter != cigarEnd; ++cigarIter) {
+                const CigarOp& op = (*cigarIter);
+                uint32_t length = op.Length;
+                int numDigits = 0;
+                do {
+                    digits[numDigits++] = '0' + (length % 10);
+                    length /= 10;
+                } while (length != 0);
+                while (numDigits > 0) {
+                    cigar.push_back(digits[--numDigits]);
+                }
+                cigar.push_back(op.Type);
+            }
+            return PropertyFilterValue::compare(cigar, StringValue, Type);
         }
+        case (INSERTSIZE):
+            return PropertyFilterValue::compare<int64_t>(al.InsertSize, IntValue, Type);
+        case (ISDUPLICATE):
+            return PropertyFilterValue::compare<int64_t>(al.IsDuplicate(), IntValue, Type);
+        case (ISFAILEDQC):
+            return PropertyFilterValue::compare<int64_t>(al.IsFailedQC(), IntValue, Type);
+        case (ISFIRSTMATE):
+            return PropertyFilterValue::compare<int64_t>(al.IsFirstMate(), IntValue, Type);
+        case (ISMAPPED):
+            return PropertyFilterValue::compare<int64_t>(al.IsMapped(), IntValue, Type);
+        case (ISMATEMAPPED):
+            return PropertyFilterValue::compare<int64_t>(al.IsMateMapped(), IntValue, Type);
+        case (ISMATEREVERSESTRAND):
+            return PropertyFilterValue::compare<int64_t>(al.IsMateReverseStrand(), IntValue, Type);
+        case (ISPAIRED):
+            return PropertyFilterValue::compare<int64_t>(al.IsPaired(), IntValue, Type);
+        case (ISPRIMARYALIGNMENT):
+            return PropertyFilterValue::compare<int64_t>(al.IsPrimaryAlignment(), IntValue, Type);
+        case (ISPROPERPAIR):
+            return PropertyFilterValue::compare<int64_t>(al.IsProperPair(), IntValue, Type);
+        case (ISREVERSESTRAND):
+            return PropertyFilterValue::compare<int64_t>(al.IsReverseStrand(), IntValue, Type);
+        case (ISSECONDMATE):
+            return PropertyFilterValue::compare<int64_t>(al.IsSecondMate(), IntValue, Type);
+        case (ISSINGLETON): {
+            const bool isSingleton = al.IsPaired() && al.IsMapped() && !al.IsMateMapped();
+            return PropertyFilterValue::compare<int64_t>(isSingleton, IntValue, Type);
+        }
+        case (LENGTH):
+            return PropertyFilterValue::compare<int64_t>(al.Length, IntValue, Type);
+        case (MAPQUALITY):
+            return PropertyFilterValue::compare<int64_t>(al.MapQuality, IntValue, Type);
+        case (MATEPOSITION):
+            // N.B. - compares MateRefID, as this property always has
+            return (al.IsPaired() && al.IsMateMapped() &&
+                    PropertyFilterValue::compare<int64_t>(al.MateRefID, IntValue, Type));
+        case (MATEREFERENCE):
+            if (!al.IsPaired() || !al.IsMateMapped()) {
+                return false;
+            }
+            BAMTOOLS_ASSERT_MESSAGE(
+                (al.MateRefID >= 0 && (al.MateRefID < (int)filterToolReferences.size())),
+                "Invalid MateRefID");
+            return ReferenceMatches.at(al.MateRefID);
+        case (NAME):
+            return PropertyFilterValue::compare(al.GetName(), StringValue, Type);
+        case (POSITION):
+            return PropertyFilterValue::compare<int64_t>(al.Position, IntValue, Type);
+        case (QUERYBASES):
+            return PropertyFilterValue::compare(al.GetQueryBases(), StringValue, Type);
+        case (REFERENCE):
+            BAMTOOLS_ASSERT_MESSAGE(
+                (al.RefID >= 0 && (al.RefID < (int)filterToolReferences.size())), "Invalid RefID");
+            return ReferenceMatches.at(al.RefID);
+        case (TAG):
+            return Tag.check(al);
+        default:
+            BAMTOOLS_ASSERT_UNREACHABLE;
+    }
+    return false;
+}
+
+// same as check(), also counting & timing the check
+bool AlignmentPredicate::checkProfiled(BamAlignment& al) const
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const bool isPassed = check(al);
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    Seconds += std::chrono::duration<double>(end - start).count();
+    ++NumChecked;
+    if (isPassed) {
+        ++NumPassed;
+    }
+    return isPassed;
+}
+
+// returns false if propertyName is unknown
+bool AlignmentPredicate::compile(const std::string& propertyName,
+                                 const PropertyFilterValue& valueFilter)
+{
 
-        return keepAlignment;
+    Type = valueFilter.Type;
+    IntValue = 0;
+    StringValue.clear();
+    ReferenceMatches.clear();
+
+    const Variant& value = valueFilter.Value;
+    if (propertyName == ALIGNMENTFLAG_PROPERTY) {
+        FieldId = ALIGNMENTFLAG;
+        IsValid = compileInt<uint32_t>(value);
+    } else if (propertyName == CIGAR_PROPERTY) {
+        FieldId = CIGAR;
+        IsValid = compileString(value);
+    } else if (propertyName == INSERTSIZE_PROPERTY) {
+        FieldId = INSERTSIZE;
+        IsValid = compileInt<int32_t>(value);
+    } else if (propertyName == ISDUPLICATE_PROPERTY) {
+        FieldId = ISDUPLICATE;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISFAILEDQC_PROPERTY) {
+        FieldId = ISFAILEDQC;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISFIRSTMATE_PROPERTY) {
+        FieldId = ISFIRSTMATE;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISMAPPED_PROPERTY) {
+        FieldId = ISMAPPED;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISMATEMAPPED_PROPERTY) {
+        FieldId = ISMATEMAPPED;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISMATEREVERSESTRAND_PROPERTY) {
+        FieldId = ISMATEREVERSESTRAND;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISPAIRED_PROPERTY) {
+        FieldId = ISPAIRED;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISPRIMARYALIGNMENT_PROPERTY) {
+        FieldId = ISPRIMARYALIGNMENT;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISPROPERPAIR_PROPERTY) {
+        FieldId = ISPROPERPAIR;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISREVERSESTRAND_PROPERTY) {
+        FieldId = ISREVERSESTRAND;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISSECONDMATE_PROPERTY) {
+        FieldId = ISSECONDMATE;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == ISSINGLETON_PROPERTY) {
+        FieldId = ISSINGLETON;
+        IsValid = compileInt<bool>(value);
+    } else if (propertyName == LENGTH_PROPERTY) {
+        FieldId = LENGTH;
+        IsValid = compileInt<int32_t>(value);
+    } else if (propertyName == MAPQUALITY_PROPERTY) {
+        FieldId = MAPQUALITY;
+        IsValid = compileInt<uint16_t>(value);
+    } else if (propertyName == MATEPOSITION_PROPERTY) {
+        FieldId = MATEPOSITION;
+        IsValid = compileInt<int32_t>(value);
+    } else if (propertyName == MATEREFERENCE_PROPERTY) {
+        FieldId = MATEREFERENCE;
+        IsValid = compileReferenceMatches(value);
+    } else if (propertyName == NAME_PROPERTY) {
+        FieldId = NAME;
+        IsValid = compileString(value);
+    } else if (propertyName == POSITION_PROPERTY) {
+        FieldId = POSITION;
+        IsValid = compileInt<int32_t>(value);
+    } else if (propertyName == QUERYBASES_PROPERTY) {
+        FieldId = QUERYBASES;
+        IsValid = compileString(value);
+    } else if (propertyName == REFERENCE_PROPERTY) {
+        FieldId = REFERENCE;
+        IsValid = compileReferenceMatches(value);
+    } else if (propertyName == TAG_PROPERTY) {
+        FieldId = TAG;
+        Tag.parse(value);
+        IsValid = true;
+    } else {
+        return false;
     }
-};
+
+    Cost = fieldCost(FieldId);
+    describe(propertyName, value);
+    return true;
+}
+
+// rough relative cost of checking each field, from what its check has to touch or build
+double AlignmentPredicate::fieldCost(const Field& field)
+{
+    switch (field) {
+        // reads name or query bases, decoding them from the raw record first
+        case (NAME):
+            return 4.0;
+        case (QUERYBASES):
+            return 8.0;
+
+        // scans the tag data for the tag, then converts its value
+        case (TAG):
+            return 8.0;
+
+        // builds the CIGAR string
+        case (CIGAR):
+            return 16.0;
+
+        // table lookup by (mate) RefID
+        case (MATEREFERENCE):
+        case (REFERENCE):
+            return 2.0;
+
+        // reads a core field or flag
+        default:
+            return 1.0;
+    }
+}
+
+// rebuilds the filter token this predicate was parsed from, e.g. "mapQuality:>=20"
+void AlignmentPredicate::describe(const std::string& propertyName, const Variant& value)
+{
+
+    std::stringstream valueStream;
+    if (value.is_type<bool>()) {
+        valueStream << (value.get<bool>() ? TRUE_STR : FALSE_STR);
+    } else if (value.is_type<int32_t>()) {
+        valueStream << value.get<int32_t>();
+    } else if (value.is_type<uint16_t>()) {
+        valueStream << value.get<uint16_t>();
+    } else if (value.is_type<uint32_t>()) {
+        valueStream << value.get<uint32_t>();
+    } else if (value.is_type<std::string>()) {
+        valueStream << value.get<std::string>();
+    }
+    const std::string valueString = valueStream.str();
+
+    Description = propertyName + ':';
+    switch (Type) {
+        case (PropertyFilterValue::CONTAINS):
+            Description += '*' + valueString + '*';
+            break;
+        case (PropertyFilterValue::ENDS_WITH):
+            Description += '*' + valueString;
+            break;
+        case (PropertyFilterValue::GREATER_THAN):
+            Description += '>' + valueString;
+            break;
+        case (PropertyFilterValue::GREATER_THAN_EQUAL):
+            Description += ">=" + valueString;
+            break;
+        case (PropertyFilterValue::LESS_THAN):
+            Description += '<' + valueString;
+            break;
+        case (PropertyFilterValue::LESS_THAN_EQUAL):
+            Description += "<=" + valueString;
+            break;
+        case (PropertyFilterValue::NOT):
+            Description += '!' + valueString;
+            break;
+        case (PropertyFilterValue::STARTS_WITH):
+            Description += valueString + '*';
+            break;
+        default:
+            Description += valueString;
+            break;
+    }
+}
+
+// N.B. - T must be the type the property's value was parsed as (& queries are compared in)
+template <typename T>
+bool AlignmentPredicate::compileInt(const Variant& value)
+{
+    if (!value.is_type<T>()) {
+        std::cerr << "Cannot compare different types!" << std::endl;
+        return false;
+    }
+    IntValue = value.get<T>();
+    return true;
+}
+
+// checks filter value against each reference name up front
+// N.B. - requires filterToolReferences to be loaded
+bool AlignmentPredicate::compileReferenceMatches(const Variant& value)
+{
+    if (!compileString(value)) {
+        return false;
+    }
+    ReferenceMatches.reserve(filterToolReferences.size());
+    RefVector::const_iterator refIter = filterToolReferences.begin();
+    RefVector::const_iterator refEnd = filterToolReferences.end();
+    for (; refIter != refEnd; ++refIter) {
+        const bool isMatch = PropertyFilterValue::compare((*refIter).RefName, StringValue, Type);
+        ReferenceMatches.push_back(isMatch);
+    }
+    return true;
+}
+
+bool AlignmentPredicate::compileString(const Variant& value)
+{
+    if (!value.is_type<std::string>()) {
+        std::cerr << "Cannot compare different types!" << std::endl;
+        return false;
+    }
+    StringValue = value.get<std::string>();
+    return true;
+}
 
 }  // namespace BamTools
 
@@ -293,20 +864,29 @@ struct FilterTool::FilterSettings
     // IO opts
 
     // flags
+    bool HasBed;
     bool HasInput;
     bool HasInputFilelist;
     bool HasOutput;
     bool HasRegion;
     bool HasScript;
     bool IsForceCompression;
+    bool HasCompressionLevel;
+    bool HasNumThreads;
+    bool IsProfiling;
 
     // filenames
+    std::string BedFilename;
     std::vector<std::string> InputFiles;
     std::string InputFilelist;
     std::string OutputFilename;
     std::string Region;
     std::string ScriptFilename;
 
+    // other parameters
+    unsigned int CompressionLevel;
+    unsigned int NumThreads;
+
     // -----------------------------------
     // General filter opts
 
@@ -363,13 +943,19 @@ struct FilterTool::FilterSettings
     // constructor
 
     FilterSettings()
-        : HasInput(false)
+        : HasBed(false)
+        , HasInput(false)
         , HasInputFilelist(false)
         , HasOutput(false)
         , HasRegion(false)
         , HasScript(false)
         , IsForceCompression(false)
+        , HasCompressionLevel(false)
+        , HasNumThreads(false)
+        , IsProfiling(false)
         , OutputFilename(Options::StandardOut())
+        , CompressionLevel(6)
+        , NumThreads(1)
         , HasAlignmentFlagFilter(false)
         , HasInsertSizeFilter(false)
         , HasLengthFilter(false)
@@ -420,14 +1006,26 @@ public:
 
     // internal methods
 private:
+    void AddProfileCounters(FilterEngine<BamAlignmentChecker>& engine);
     bool AddPropertyTokensToFilter(const std::string& filterName,
                                    const std::map<std::string, std::string>& propertyTokens);
-    bool CheckAlignment(const BamAlignment& al);
+    bool CheckAlignment(BamAlignment& al);
+    uint64_t CheckBatch(FilterEngine<BamAlignmentChecker>* engine, std::vector<BamAlignment>* batch,
+                        std::size_t begin, std::size_t end, const BamRegion* scanRegion,
+                        std::vector<char>* isKept);
+    void FilterAlignments(BamMultiReader& reader, BamWriter& writer,
+                          const BamRegion* scanRegion = 0);
+    void FilterAlignmentsParallel(BamMultiReader& reader, BamWriter& writer,
+                                  const BamRegion* scanRegion);
+    bool GetFilterRegions(std::vector<BamRegion>& regions);
     const std::string GetScriptContents();
     void InitProperties();
+    bool IsIndexingTags();
+    static bool IsInRegion(const BamAlignment& al, const BamRegion& region);
     bool ParseCommandLine();
     bool ParseFilterObject(const std::string& filterName, const Json::Value& filterObject);
     bool ParseScript();
+    void PrintProfile();
     bool SetupFilters();
 
     // data members
@@ -435,6 +1033,9 @@ private:
     std::vector<std::string> m_propertyNames;
     FilterTool::FilterSettings* m_settings;
     FilterEngine<BamAlignmentChecker> m_filterEngine;
+    bool m_isIndexingTags;  // true if filters query enough tags to make a tag index pay
+    uint64_t m_numChecked;
+    uint64_t m_numKept;
 };
 
 // ---------------------------------------------
@@ -443,8 +1044,33 @@ private:
 // constructor
 FilterTool::FilterToolPrivate::FilterToolPrivate(FilterTool::FilterSettings* settings)
     : m_settings(settings)
+    , m_isIndexingTags(false)
+    , m_numChecked(0)
+    , m_numKept(0)
 {}
 
+// adds profile counters of a worker's copy of the filter engine to our own
+void FilterTool::FilterToolPrivate::AddProfileCounters(FilterEngine<BamAlignmentChecker>& engine)
+{
+    const std::vector<BamAlignmentChecker::CompiledFilter>& filters =
+        m_filterEngine.compiledFilters();
+    const std::vector<BamAlignmentChecker::CompiledFilter>& workerFilters =
+        engine.compiledFilters();
+    for (std::size_t i = 0; i < filters.size() && i < workerFilters.size(); ++i) {
+        const BamAlignmentChecker::CompiledFilter& filter = filters.at(i);
+        const BamAlignmentChecker::CompiledFilter& workerFilter = workerFilters.at(i);
+        filter.NumChecked += workerFilter.NumChecked;
+        filter.NumPassed += workerFilter.NumPassed;
+        for (std::size_t j = 0; j < filter.Predicates.size(); ++j) {
+            const AlignmentPredicate& predicate = filter.Predicates.at(j);
+            const AlignmentPredicate& workerPredicate = workerFilter.Predicates.at(j);
+            predicate.NumChecked += workerPredicate.NumChecked;
+            predicate.NumPassed += workerPredicate.NumPassed;
+            predicate.Seconds += workerPredicate.Seconds;
+        }
+    }
+}
+
 bool FilterTool::FilterToolPrivate::AddPropertyTokensToFilter(
     const std::string& filterName, const std::map<std::string, std::string>& propertyTokens)
 {
@@ -521,9 +1147,160 @@ bool FilterTool::FilterToolPrivate::AddPropertyTokensToFilter(
     return true;
 }
 
-bool FilterTool::FilterToolPrivate::CheckAlignment(const BamAlignment& al)
+bool FilterTool::FilterToolPrivate::CheckAlignment(BamAlignment& al)
 {
-    return m_filterEngine.check(al);
+    ++m_numChecked;
+    if (m_isIndexingTags) {
+        al.BuildTagIndex();
+    }
+    if (m_filterEngine.check(al)) {
+        ++m_numKept;
+        return true;
+    }
+    return false;
+}
+
+// checks alignments [begin, end) of batch against engine, flagging those that pass in isKept
+// alignments outside scanRegion (if given) are skipped, returns number actually checked
+// runs on worker thread, engine must not be shared with other threads
+uint64_t FilterTool::FilterToolPrivate::CheckBatch(FilterEngine<BamAlignmentChecker>* engine,
+                                                   std::vector<BamAlignment>* batch,
+                                                   std::size_t begin, std::size_t end,
+                                                   const BamRegion* scanRegion,
+                                                   std::vector<char>* isKept)
+{
+    uint64_t numChecked = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+        BamAlignment& al = batch->at(i);
+        if (scanRegion && !IsInRegion(al, *scanRegion)) {
+            continue;
+        }
+        ++numChecked;
+        if (m_isIndexingTags) {
+            al.BuildTagIndex();
+        }
+        isKept->at(i) = engine->check(al);
+    }
+    return numChecked;
+}
+
+// reads all (remaining) alignments, writing out those that pass the filters
+// alignments outside scanRegion (if given) are skipped without being checked
+void FilterTool::FilterToolPrivate::FilterAlignments(BamMultiReader& reader, BamWriter& writer,
+                                                     const BamRegion* scanRegion)
+{
+
+    if (m_settings->HasNumThreads && m_settings->NumThreads > 1) {
+        FilterAlignmentsParallel(reader, writer, scanRegion);
+        return;
+    }
+
+    // only core data is read, checks decode the rest as needed & output is written raw
+    BamAlignment al;
+    while (reader.GetNextAlignmentCore(al)) {
+        if (scanRegion && !IsInRegion(al, *scanRegion)) {
+            continue;
+        }
+        if (CheckAlignment(al)) {
+            writer.SaveRawAlignment(al);
+        }
+    }
+}
+
+// same as FilterAlignments(), checking batches of alignments on worker threads
+//
+// Each batch is split evenly between the threads, while the next batch is read. Passing
+// alignments are then written in their original order, so output matches a single-threaded
+// run. Each thread checks with its own copy of the (compiled) filter engine, so no state is
+// shared between checks, profile counters are added up afterwards.
+void FilterTool::FilterToolPrivate::FilterAlignmentsParallel(BamMultiReader& reader,
+                                                             BamWriter& writer,
+                                                             const BamRegion* scanRegion)
+{
+
+    const std::size_t numThreads = m_settings->NumThreads;
+    m_filterEngine.compiledFilters();
+    std::vector<FilterEngine<BamAlignmentChecker> > engines(numThreads, m_filterEngine);
+
+    std::vector<BamAlignment> batch;
+    std::vector<BamAlignment> nextBatch;
+    std::vector<char> isKept;
+    std::vector<std::future<uint64_t> > checks;
+
+    reader.GetNextAlignmentsCore(batch, FILTER_BATCH_SIZE);
+    while (!batch.empty()) {
+
+        // check current batch
+        const std::size_t batchSize = batch.size();
+        isKept.assign(batchSize, 0);
+        checks.clear();
+        for (std::size_t i = 0; i < numThreads; ++i) {
+            const std::size_t begin = batchSize * i / numThreads;
+            const std::size_t end = batchSize * (i + 1) / numThreads;
+            checks.push_back(std::async(std::launch::async, &FilterToolPrivate::CheckBatch, this,
+                                        &engines[i], &batch, begin, end, scanRegion, &isKept));
+        }
+
+        // meanwhile, read the next one
+        reader.GetNextAlignmentsCore(nextBatch, FILTER_BATCH_SIZE);
+
+        // write out passing alignments in order
+        for (std::size_t i = 0; i < checks.size(); ++i) {
+            m_numChecked += checks[i].get();
+        }
+        for (std::size_t i = 0; i < batchSize; ++i) {
+            if (isKept[i]) {
+                ++m_numKept;
+                writer.SaveRawAlignment(batch[i]);
+            }
+        }
+        batch.swap(nextBatch);
+    }
+
+    if (m_settings->IsProfiling) {
+        for (std::size_t i = 0; i < numThreads; ++i) {
+            AddProfileCounters(engines[i]);
+        }
+    }
+}
+
+// derives regions that contain every alignment the filters may pass, from their reference
+// & position properties (one region per reference, in reference order)
+// returns false if filters are not bounded that way, the whole input must be read then
+bool FilterTool::FilterToolPrivate::GetFilterRegions(std::vector<BamRegion>& regions)
+{
+
+    const AlignmentBounds bounds = m_filterEngine.bounds<AlignmentBounds>();
+    if (!bounds.IsBounded || bounds.HasUnplaced) {
+        return false;
+    }
+
+    regions.clear();
+    for (std::size_t refId = 0; refId < bounds.Positions.size(); ++refId) {
+        const AlignmentBounds::PositionRange& range = bounds.Positions.at(refId);
+        if (range.first > range.second) {
+            continue;
+        }
+
+        // index lookups need region to start within reference
+        const int64_t refLength = filterToolReferences.at(refId).RefLength;
+        if (refLength <= 0) {
+            return false;
+        }
+        const int left = std::min<int64_t>(std::max<int64_t>(range.first, 0), refLength - 1);
+
+        // region is [left, right) if that ends within reference
+        // otherwise it runs to the reference's end, in case alignments start past it
+        const int64_t right = range.second + 1;
+        if (right <= 0) {
+            continue;
+        } else if (right <= refLength) {
+            regions.push_back(BamRegion(refId, left, refId, right));
+        } else {
+            regions.push_back(BamRegion(refId, left, refId, std::numeric_limits<int>::max()));
+        }
+    }
+    return true;
 }
 
 const std::string FilterTool::FilterToolPrivate::GetScriptContents()
@@ -598,6 +1375,33 @@ void FilterTool::FilterToolPrivate::InitProperties()
     }
 }
 
+// returns true if filters have several tag properties
+//
+// Each tag check looks its tag up twice (type, then value). Indexing an alignment's tags costs
+// about one full scan of them, which pays off once more than one tag is checked.
+bool FilterTool::FilterToolPrivate::IsIndexingTags()
+{
+    std::size_t numTagPredicates = 0;
+    const std::vector<BamAlignmentChecker::CompiledFilter>& filters =
+        m_filterEngine.compiledFilters();
+    for (std::size_t i = 0; i < filters.size(); ++i) {
+        const std::vector<AlignmentPredicate>& predicates = filters.at(i).Predicates;
+        for (std::size_t j = 0; j < predicates.size(); ++j) {
+            if (predicates.at(j).FieldId == AlignmentPredicate::TAG) {
+                ++numTagPredicates;
+            }
+        }
+    }
+    return (numTagPredicates > 1);
+}
+
+// returns true if alignment overlaps region (as checked when no index data is available)
+bool FilterTool::FilterToolPrivate::IsInRegion(const BamAlignment& al, const BamRegion& region)
+{
+    return ((al.RefID >= region.LeftRefID) && ((al.Position + al.Length) >= region.LeftPosition) &&
+            (al.RefID <= region.RightRefID) && (al.Position <= region.RightPosition));
+}
+
 bool FilterTool::FilterToolPrivate::ParseCommandLine()
 {
 
@@ -782,6 +1586,12 @@ bool FilterTool::FilterToolPrivate::ParseScript()
 bool FilterTool::FilterToolPrivate::Run()
 {
 
+    // check compression level (BamWriter would quietly treat levels above 9 as 9)
+    if (m_settings->HasCompressionLevel && m_settings->CompressionLevel > 9) {
+        std::cerr << "bamtools filter ERROR: -level must be from 0 to 9... Aborting." << std::endl;
+        return false;
+    }
+
     // set to default input if none provided
     if (!m_settings->HasInput && !m_settings->HasInputFilelist) {
         m_settings->InputFiles.push_back(Options::StandardIn());
@@ -809,8 +1619,19 @@ bool FilterTool::FilterToolPrivate::Run()
         return false;
     }
 
+    // -region & -bed are mutually exclusive
+    if (m_settings->HasRegion && m_settings->HasBed) {
+        std::cerr << "bamtools filter ERROR: -region and -bed cannot be used together... "
+                     "Aborting."
+                  << std::endl;
+        return false;
+    }
+
     // open reader without index
     BamMultiReader reader;
+    if (m_settings->HasNumThreads) {
+        reader.SetNumThreads(m_settings->NumThreads);
+    }
     if (!reader.Open(m_settings->InputFiles)) {
         std::cerr << "bamtools filter ERROR: could not open input files for reading." << std::endl;
         return false;
@@ -831,6 +1652,12 @@ bool FilterTool::FilterToolPrivate::Run()
     // open BamWriter
     BamWriter writer;
     writer.SetCompressionMode(compressionMode);
+    if (m_settings->HasCompressionLevel && !writeUncompressed) {
+        writer.SetCompressionLevel(m_settings->CompressionLevel);
+    }
+    if (m_settings->HasNumThreads) {
+        writer.SetNumThreads(m_settings->NumThreads);
+    }
     if (!writer.Open(m_settings->OutputFilename, headerText, filterToolReferences)) {
         std::cerr << "bamtools filter ERROR: could not open " << m_settings->OutputFilename
                   << " for writing." << std::endl;
@@ -838,14 +1665,53 @@ bool FilterTool::FilterToolPrivate::Run()
         return false;
     }
 
+    // enable per-filter & per-property counters, if requested
+    m_filterEngine.checker().IsProfiling = m_settings->IsProfiling;
+    m_isIndexingTags = IsIndexingTags();
+
     // if no region specified, filter entire file
-    BamAlignment al;
     if (!m_settings->HasRegion) {
-        while (reader.GetNextAlignment(al)) {
-            if (CheckAlignment(al)) {
-                writer.SaveAlignment(al);
+
+        // if BED file given, only read alignments overlapping its regions (requires index data)
+        if (m_settings->HasBed) {
+            std::vector<BamRegion> bedRegions;
+            if (!Utilities::ParseBedFile(m_settings->BedFilename, filterToolReferences,
+                                         bedRegions)) {
+                std::cerr << "bamtools filter ERROR: could not parse BED file: "
+                          << m_settings->BedFilename << std::endl;
+                reader.Close();
+                return false;
+            }
+            if (!reader.LocateIndexes() || !reader.HasIndexes()) {
+                std::cerr << "bamtools filter ERROR: -bed requires index data for all input BAM "
+                             "files"
+                          << std::endl;
+                reader.Close();
+                return false;
+            }
+            if (!reader.SetRegions(bedRegions)) {
+                std::cerr << "bamtools filter ERROR: set regions failed. Check that BED file "
+                             "describes valid ranges"
+                          << std::endl;
+                reader.Close();
+                return false;
             }
         }
+
+        // otherwise, if filters only pass certain references/positions & index data is
+        // available, just read those regions
+        else {
+            std::vector<BamRegion> filterRegions;
+            if (GetFilterRegions(filterRegions) && reader.LocateIndexes() && reader.HasIndexes() &&
+                !reader.SetRegions(filterRegions)) {
+                std::cerr << "bamtools filter ERROR: could not set regions derived from filters"
+                          << std::endl;
+                reader.Close();
+                return false;
+            }
+        }
+
+        FilterAlignments(reader, writer);
     }
 
     // otherwise attempt to use region as constraint
@@ -872,25 +1738,13 @@ bool FilterTool::FilterToolPrivate::Run()
                 }
 
                 // everything checks out, just iterate through specified region, filtering alignments
-                while (reader.GetNextAlignment(al)) {
-                    if (CheckAlignment(al)) {
-                        writer.SaveAlignment(al);
-                    }
-                }
+                FilterAlignments(reader, writer);
             }
 
             // no index data available, we have to iterate through until we
             // find overlapping alignments
             else {
-                while (reader.GetNextAlignment(al)) {
-                    if ((al.RefID >= region.LeftRefID) &&
-                        ((al.Position + al.Length) >= region.LeftPosition) &&
-                        (al.RefID <= region.RightRefID) && (al.Position <= region.RightPosition)) {
-                        if (CheckAlignment(al)) {
-                            writer.SaveAlignment(al);
-                        }
-                    }
-                }
+                FilterAlignments(reader, writer, &region);
             }
         }
 
@@ -909,9 +1763,52 @@ bool FilterTool::FilterToolPrivate::Run()
     // clean up & exit
     reader.Close();
     writer.Close();
+    if (m_settings->IsProfiling) {
+        PrintProfile();
+    }
     return true;
 }
 
+// reports how often each filter & property check ran & passed, in evaluation order
+void FilterTool::FilterToolPrivate::PrintProfile()
+{
+
+    std::cerr << "bamtools filter profile:" << std::endl;
+    std::cerr << "alignments checked: " << m_numChecked << std::endl;
+    std::cerr << "alignments kept:    " << m_numKept << "\t("
+              << (m_numChecked ? ((double)m_numKept / m_numChecked) * 100 : 0.0) << "%)"
+              << std::endl;
+
+    // compiled filters come in filterNames() order
+    const std::vector<std::string> filterNames = m_filterEngine.filterNames();
+    const std::vector<BamAlignmentChecker::CompiledFilter>& filters =
+        m_filterEngine.compiledFilters();
+    for (std::size_t i = 0; i < filterNames.size() && i < filters.size(); ++i) {
+        const BamAlignmentChecker::CompiledFilter& filter = filters.at(i);
+        std::cerr << std::endl;
+        std::cerr << "filter " << filterNames.at(i) << ": checked " << filter.NumChecked
+                  << ", passed " << filter.NumPassed << "\t("
+                  << (filter.NumChecked ? ((double)filter.NumPassed / filter.NumChecked) * 100
+                                        : 0.0)
+                  << "%)" << std::endl;
+
+        std::vector<AlignmentPredicate>::const_iterator predicateIter = filter.Predicates.begin();
+        std::vector<AlignmentPredicate>::const_iterator predicateEnd = filter.Predicates.end();
+        for (; predicateIter != predicateEnd; ++predicateIter) {
+            const AlignmentPredicate& predicate = (*predicateIter);
+            std::cerr << "    " << predicate.Description << ": checked " << predicate.NumChecked
+                      << ", passed " << predicate.NumPassed << "\t("
+                      << (predicate.NumChecked
+                              ? ((double)predicate.NumPassed / predicate.NumChecked) * 100
+                              : 0.0)
+                      << "%)\t"
+                      << (predicate.NumChecked ? (predicate.Seconds / predicate.NumChecked) * 1.0e9
+                                               : 0.0)
+                      << " ns/check, " << predicate.Seconds << " s total" << std::endl;
+        }
+    }
+}
+
 bool FilterTool::FilterToolPrivate::SetupFilters()
 {
 
@@ -941,7 +1838,8 @@ FilterTool::FilterTool()
 
     const std::string usage =
         "[-in <filename> -in <filename> ... | -list <filelist>] "
-        "[-out <filename> | [-forceCompression]] [-region <REGION>] "
+        "[-out <filename> | [-forceCompression]] [-level <0-9>] [-region <REGION> | -bed "
+        "<filename>] [-threads <N>] [-profile] "
         "[ [-script <filename] | [filterOptions] ]";
 
     Options::SetProgramInfo("bamtools filter", "filters BAM file(s)", usage);
@@ -956,11 +1854,22 @@ FilterTool::FilterTool()
     const std::string outDesc = "the output BAM file";
     const std::string regionDesc =
         "only read data from this genomic region (see documentation for more details)";
+    const std::string bedDesc =
+        "only read data overlapping any region in this BED file. Requires index file";
     const std::string scriptDesc = "the filter script file (see documentation for more details)";
     const std::string forceDesc =
         "if results are sent to stdout (like when piping to another tool), "
         "default behavior is to leave output uncompressed. Use this flag to "
         "override and force compression";
+    const std::string levelDesc =
+        "compression level for output BAM file, from 0 (none) to 9 (smallest). Ignored for "
+        "uncompressed output to stdout (see -forceCompression)";
+    const std::string threadsDesc =
+        "number of threads used to check alignments against filters, to read ahead from input "
+        "files and to compress output. Output order is unchanged";
+    const std::string profileDesc =
+        "report to stderr how many alignments each filter & property check saw & passed, "
+        "and the time spent in each property check";
 
     Options::AddValueOption("-in", "BAM filename", inDesc, "", m_settings->HasInput,
                             m_settings->InputFiles, IO_Opts, Options::StandardIn());
@@ -970,9 +1879,16 @@ FilterTool::FilterTool()
                             m_settings->OutputFilename, IO_Opts, Options::StandardOut());
     Options::AddValueOption("-region", "REGION", regionDesc, "", m_settings->HasRegion,
                             m_settings->Region, IO_Opts);
+    Options::AddValueOption("-bed", "filename", bedDesc, "", m_settings->HasBed,
+                            m_settings->BedFilename, IO_Opts);
     Options::AddValueOption("-script", "filename", scriptDesc, "", m_settings->HasScript,
                             m_settings->ScriptFilename, IO_Opts);
     Options::AddOption("-forceCompression", forceDesc, m_settings->IsForceCompression, IO_Opts);
+    Options::AddValueOption("-level", "0-9", levelDesc, "", m_settings->HasCompressionLevel,
+                            m_settings->CompressionLevel, IO_Opts);
+    Options::AddValueOption("-threads", "N", threadsDesc, "", m_settings->HasNumThreads,
+                            m_settings->NumThreads, IO_Opts);
+    Options::AddOption("-profile", profileDesc, m_settings->IsProfiling, IO_Opts);
 
     // ----------------------------------
     // general filter options
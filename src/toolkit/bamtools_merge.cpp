@@ -31,7 +31,9 @@ struct MergeTool::MergeSettings
     bool HasInputFilelist;
     bool HasOutput;
     bool IsForceCompression;
+    bool HasCompressionLevel;
     bool HasRegion;
+    bool HasNumThreads;
 
     // filenames
     std::vector<std::string> InputFiles;
@@ -40,6 +42,8 @@ struct MergeTool::MergeSettings
     // other parameters
     std::string OutputFilename;
     std::string Region;
+    unsigned int CompressionLevel;
+    unsigned int NumThreads;
 
     // constructor
     MergeSettings()
@@ -47,8 +51,12 @@ struct MergeTool::MergeSettings
         , HasInputFilelist(false)
         , HasOutput(false)
         , IsForceCompression(false)
+        , HasCompressionLevel(false)
         , HasRegion(false)
+        , HasNumThreads(false)
         , OutputFilename(Options::StandardOut())
+        , CompressionLevel(6)
+        , NumThreads(1)
     {}
 };
 
@@ -76,6 +84,12 @@ private:
 bool MergeTool::MergeToolPrivate::Run()
 {
 
+    // check compression level (BamWriter would quietly treat levels above 9 as 9)
+    if (m_settings->HasCompressionLevel && m_settings->CompressionLevel > 9) {
+        std::cerr << "bamtools merge ERROR: -level must be from 0 to 9... Aborting." << std::endl;
+        return false;
+    }
+
     // set to default input if none provided
     if (!m_settings->HasInput && !m_settings->HasInputFilelist) {
         m_settings->InputFiles.push_back(Options::StandardIn());
@@ -99,6 +113,9 @@ bool MergeTool::MergeToolPrivate::Run()
 
     // opens the BAM files (by default without checking for indexes)
     BamMultiReader reader;
+    if (m_settings->HasNumThreads) {
+        reader.SetNumThreads(m_settings->NumThreads);
+    }
     if (!reader.Open(m_settings->InputFiles)) {
         std::cerr << "bamtools merge ERROR: could not open input BAM file(s)... Aborting."
                   << std::endl;
@@ -120,6 +137,12 @@ bool MergeTool::MergeToolPrivate::Run()
     // open BamWriter
     BamWriter writer;
     writer.SetCompressionMode(compressionMode);
+    if (m_settings->HasCompressionLevel && !writeUncompressed) {
+        writer.SetCompressionLevel(m_settings->CompressionLevel);
+    }
+    if (m_settings->HasNumThreads) {
+        writer.SetNumThreads(m_settings->NumThreads);
+    }
     if (!writer.Open(m_settings->OutputFilename, mergedHeader, references)) {
         std::cerr << "bamtools merge ERROR: could not open " << m_settings->OutputFilename
                   << " for writing." << std::endl;
@@ -131,7 +154,7 @@ bool MergeTool::MergeToolPrivate::Run()
     if (!m_settings->HasRegion) {
         BamAlignment al;
         while (reader.GetNextAlignmentCore(al)) {
-            writer.SaveAlignment(al);
+            writer.SaveRawAlignment(al);
         }
     }
 
@@ -161,7 +184,7 @@ bool MergeTool::MergeToolPrivate::Run()
                 // everything checks out, just iterate through specified region, storing alignments
                 BamAlignment al;
                 while (reader.GetNextAlignmentCore(al)) {
-                    writer.SaveAlignment(al);
+                    writer.SaveRawAlignment(al);
                 }
             }
 
@@ -173,7 +196,7 @@ bool MergeTool::MergeToolPrivate::Run()
                     if ((al.RefID >= region.LeftRefID) &&
                         ((al.Position + al.Length) >= region.LeftPosition) &&
                         (al.RefID <= region.RightRefID) && (al.Position <= region.RightPosition)) {
-                        writer.SaveAlignment(al);
+                        writer.SaveRawAlignment(al);
                     }
                 }
             }
@@ -209,7 +232,8 @@ MergeTool::MergeTool()
     // set program details
     Options::SetProgramInfo("bamtools merge", "merges multiple BAM files into one",
                             "[-in <filename> -in <filename> ... | -list <filelist>] [-out "
-                            "<filename> | [-forceCompression]] [-region <REGION>]");
+                            "<filename> | [-forceCompression]] [-level <0-9>] [-region <REGION>] "
+                            "[-threads <N>]");
 
     // set up options
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
@@ -224,8 +248,17 @@ MergeTool::MergeTool()
                        "behavior is to leave output uncompressed. Use this flag to override and "
                        "force compression",
                        m_settings->IsForceCompression, IO_Opts);
+    Options::AddValueOption(
+        "-level", "0-9",
+        "compression level for output BAM file, from 0 (none) to 9 (smallest). Ignored for "
+        "uncompressed output to stdout (see -forceCompression)",
+        "", m_settings->HasCompressionLevel, m_settings->CompressionLevel, IO_Opts);
     Options::AddValueOption("-region", "REGION", "genomic region. See README for more details", "",
                             m_settings->HasRegion, m_settings->Region, IO_Opts);
+    Options::AddValueOption("-threads", "N",
+                            "number of threads used to read ahead from input files and to "
+                            "compress output",
+                            "", m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts);
 }
 
 MergeTool::~MergeTool()
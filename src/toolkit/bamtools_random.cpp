@@ -226,7 +226,7 @@ bool RandomTool::RandomToolPrivate::Run()
         if (reader.Jump(randomRefId, randomPosition)) {
             while (reader.GetNextAlignmentCore(al)) {
                 if (al.RefID == randomRefId && al.Position >= randomPosition) {
-                    writer.SaveAlignment(al);
+                    writer.SaveRawAlignment(al);
                     ++i;
                     break;
                 }
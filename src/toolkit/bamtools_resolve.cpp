@@ -1276,7 +1276,7 @@ void ResolveTool::ResolveToolPrivate::ResolveAlignment(BamAlignment& al)
 
     // quit check if alignment is not a "candidate proper pair"
     std::map<std::string, bool>::const_iterator readNameIter;
-    readNameIter = resolver.ReadNames.find(al.Name);
+    readNameIter = resolver.ReadNames.find(al.GetName());
     if (readNameIter == resolver.ReadNames.end()) {
         return;
     }
@@ -1342,11 +1342,12 @@ bool ResolveTool::ResolveToolPrivate::ResolvePairs()
     }
 
     // plow through alignments, setting/clearing 'proper pair' flag
-    // and writing to new output BAM file
+    // and writing to new output BAM file (only the name & read group are needed, so the
+    // char data is left raw & copied straight through)
     BamAlignment al;
-    while (reader.GetNextAlignment(al)) {
+    while (reader.GetNextAlignmentCore(al)) {
         ResolveAlignment(al);
-        writer.SaveAlignment(al);
+        writer.SaveRawAlignment(al);
     }
 
     // clean up & return success
@@ -20,9 +20,14 @@ using namespace BamTools::Algorithms;
 #include <algorithm>
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace BamTools {
@@ -34,8 +39,358 @@ namespace BamTools {
 //    I say 'optimized' because each system will naturally perform
 //    differently.  We will attempt to determine a sensible
 //    compromise that should perform well on average.
-const unsigned int SORT_DEFAULT_MAX_BUFFER_COUNT = 500000;  // max numberOfAlignments for buffer
-const unsigned int SORT_DEFAULT_MAX_BUFFER_MEMORY = 1024;   // Mb
+const unsigned int SORT_DEFAULT_MAX_BUFFER_MEMORY = 1024;  // Mb
+const unsigned int SORT_DEFAULT_MAX_OPEN_FILES = 128;      // max temp files merged at once
+
+// temp files are read back once & deleted, so favor speed over size
+const int SORT_TEMP_COMPRESSION_LEVEL = 1;
+
+// run buffers allocate memory in blocks of 1/16 of their budget, within these limits
+const std::size_t SORT_MIN_BUFFER_BLOCK_SIZE = 64 * 1024;         // bytes
+const std::size_t SORT_MAX_BUFFER_BLOCK_SIZE = 16 * 1024 * 1024;  // bytes
+
+// thread entry points for ParallelStableSort()
+template <typename Iterator, typename Compare>
+void StableSortRange(Iterator first, Iterator last, Compare comp)
+{
+    std::stable_sort(first, last, comp);
+}
+
+template <typename Iterator, typename Compare>
+void MergeRanges(Iterator first, Iterator middle, Iterator last, Compare comp)
+{
+    std::inplace_merge(first, middle, last, comp);
+}
+
+// stable sort of [first, last) using up to numThreads threads
+//
+// Splits the range into equal chunks & sorts each on its own thread, then merges neighbouring
+// chunks pairwise (also in parallel) until one sorted range remains. Both steps keep equal
+// elements in their original order, so results match a single std::stable_sort().
+template <typename Iterator, typename Compare>
+void ParallelStableSort(Iterator first, Iterator last, const Compare& comp, unsigned int numThreads)
+{
+    const std::size_t size = last - first;
+    if (numThreads <= 1 || size < 2 * numThreads) {
+        std::stable_sort(first, last, comp);
+        return;
+    }
+
+    std::vector<Iterator> bounds;
+    for (std::size_t i = 0; i <= numThreads; ++i) {
+        bounds.push_back(first + (size * i / numThreads));
+    }
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < numThreads; ++i) {
+        workers.push_back(
+            std::thread(StableSortRange<Iterator, Compare>, bounds[i], bounds[i + 1], comp));
+    }
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+    }
+
+    for (std::size_t width = 1; width < numThreads; width *= 2) {
+        workers.clear();
+        for (std::size_t i = 0; i + width < numThreads; i += 2 * width) {
+            const std::size_t end = std::min<std::size_t>(i + 2 * width, numThreads);
+            workers.push_back(std::thread(MergeRanges<Iterator, Compare>, bounds[i],
+                                          bounds[i + width], bounds[end], comp));
+        }
+        for (std::size_t i = 0; i < workers.size(); ++i) {
+            workers[i].join();
+        }
+    }
+}
+
+// alignments buffered for one sorted run
+//
+// Alignments are kept packed (see BamAlignment::Pack()) in fixed-size blocks of memory, so
+// memory use is close to their size on disk & can be measured directly. Blocks are never
+// reallocated, which would briefly need the old & new memory together, and are kept for the
+// next run. Sorting only moves small entries holding each alignment's sort key & location.
+class SortRunBuffer
+{
+
+    // enums
+public:
+    enum SortOrder
+    {
+        PositionOrder = 0,  // like Sort::ByPosition
+        NameOrder,          // like Sort::ByName
+        NaturalNameOrder    // like Sort::ByNaturalName
+    };
+
+    // ctor
+public:
+    explicit SortRunBuffer(SortOrder order = PositionOrder,
+                           std::size_t blockSize = SORT_MAX_BUFFER_BLOCK_SIZE);
+
+    // SortRunBuffer interface
+public:
+    bool Add(BamAlignment& al);
+    void Clear();
+    std::size_t Count() const;
+    bool IsEmpty() const;
+    std::size_t MemoryUsed() const;  // bytes allocated for buffered alignments
+    void Sort(unsigned int numThreads);
+    void Swap(SortRunBuffer& other);
+    bool Write(BamWriter& writer) const;
+
+    // internal types & methods
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> Data;
+        std::size_t Size;
+    };
+
+    struct Entry
+    {
+        uint64_t Key;      // see MakeNameKey() & Sort::PositionKey
+        const char* Data;  // packed alignment
+        uint32_t Length;   // size of packed alignment
+        const char* Name;  // null-terminated read name, if sorting by name
+    };
+
+    // radix sort key, which is exact for Sort::ByPosition
+    struct EntryKey
+    {
+        uint64_t operator()(const Entry& entry) const
+        {
+            return entry.Key;
+        }
+    };
+
+    // orders by key (name prefix), then by full name
+    struct EntryByName
+    {
+        explicit EntryByName(bool isNatural)
+            : IsNatural(isNatural)
+        {}
+        bool operator()(const Entry& lhs, const Entry& rhs) const
+        {
+            if (lhs.Key != rhs.Key) {
+                return lhs.Key < rhs.Key;
+            }
+            if (IsNatural) {
+                return Sort::ByNaturalName::CompareNames(lhs.Name, rhs.Name) < 0;
+            }
+            return std::strcmp(lhs.Name, rhs.Name) < 0;
+        }
+        bool IsNatural;
+    };
+
+    char* Allocate(std::size_t numBytes);
+    void MakeNameKeys();
+    static uint64_t MakeNameKey(const char* name, bool isNatural);
+
+    // data members
+private:
+    SortOrder m_order;
+    std::size_t m_blockSize;
+    std::vector<Block> m_blocks;    // packed alignments & read names, kept between runs
+    std::size_t m_numBlocksUsed;    // blocks used by this run, the last one partly
+    std::size_t m_lastBlockUsed;    // bytes used in last block
+    std::size_t m_blockMemoryUsed;  // total size of blocks used by this run
+    std::string m_packed;           // alignment being added
+    std::vector<Entry> m_entries;
+};
+
+SortRunBuffer::SortRunBuffer(SortOrder order, std::size_t blockSize)
+    : m_order(order)
+    , m_blockSize(blockSize)
+    , m_numBlocksUsed(0)
+    , m_lastBlockUsed(0)
+    , m_blockMemoryUsed(0)
+{}
+
+bool SortRunBuffer::Add(BamAlignment& al)
+{
+    m_packed.clear();
+    if (!al.Pack(m_packed)) {
+        return false;
+    }
+    Entry entry;
+    char* data = Allocate(m_packed.size());
+    std::memcpy(data, m_packed.data(), m_packed.size());
+    entry.Data = data;
+    entry.Length = m_packed.size();
+
+    // name keys depend on all names in the run, so are made when sorting
+    if (m_order == PositionOrder) {
+        entry.Key = Sort::PositionKey()(al);
+        entry.Name = 0;
+    } else {
+        const std::string& name = al.GetName();
+        char* nameData = Allocate(name.size() + 1);
+        std::memcpy(nameData, name.c_str(), name.size() + 1);
+        entry.Key = 0;
+        entry.Name = nameData;
+    }
+    m_entries.push_back(entry);
+    return true;
+}
+
+// returns space for numBytes in the last block used, moving on to the next block if needed
+char* SortRunBuffer::Allocate(std::size_t numBytes)
+{
+    if (m_numBlocksUsed == 0 || m_lastBlockUsed + numBytes > m_blocks[m_numBlocksUsed - 1].Size) {
+
+        // reuse the next block if it's big enough, otherwise (re)allocate it
+        // (blocks are only larger than m_blockSize if a single alignment is)
+        if (m_numBlocksUsed == m_blocks.size()) {
+            m_blocks.push_back(Block());
+        }
+        Block& block = m_blocks[m_numBlocksUsed];
+        if (block.Size < numBytes || !block.Data) {
+            block.Size = std::max(numBytes, m_blockSize);
+            block.Data.reset(new char[block.Size]);
+        }
+        ++m_numBlocksUsed;
+        m_lastBlockUsed = 0;
+        m_blockMemoryUsed += block.Size;
+    }
+
+    char* data = m_blocks[m_numBlocksUsed - 1].Data.get() + m_lastBlockUsed;
+    m_lastBlockUsed += numBytes;
+    return data;
+}
+
+void SortRunBuffer::Clear()
+{
+    m_numBlocksUsed = 0;
+    m_lastBlockUsed = 0;
+    m_blockMemoryUsed = 0;
+
+    // entries are a small part of the memory, & regrowing them is cheap
+    std::vector<Entry>().swap(m_entries);
+}
+
+std::size_t SortRunBuffer::Count() const
+{
+    return m_entries.size();
+}
+
+bool SortRunBuffer::IsEmpty() const
+{
+    return m_entries.empty();
+}
+
+// first 8 characters of read name, big-endian so that keys compare like the names do
+//
+// For natural order, the key stops at the first digit, which is stored as '0': any digit
+// compares the same way against a non-digit, and numbers themselves are left to the full
+// name comparison.
+uint64_t SortRunBuffer::MakeNameKey(const char* name, bool isNatural)
+{
+    uint64_t key = 0;
+    bool isKeyDone = false;
+    for (std::size_t i = 0; i < 8; ++i) {
+        key <<= 8;
+        if (isKeyDone) {
+            continue;
+        }
+        const unsigned char c = name[i];
+        if (c == '\0') {
+            isKeyDone = true;
+        } else if (isNatural && c >= '0' && c <= '9') {
+            key |= '0';
+            isKeyDone = true;
+        } else {
+            key |= c;
+        }
+    }
+    return key;
+}
+
+// sets name keys of all entries
+//
+// Read names in a file usually share a long prefix (instrument, run, flowcell...), which
+// would leave every key the same. So keys start after the prefix shared by all names in the
+// run, which never changes how two names compare.
+void SortRunBuffer::MakeNameKeys()
+{
+    if (m_entries.empty()) {
+        return;
+    }
+
+    // find prefix shared by all names
+    const char* firstName = m_entries.front().Name;
+    std::size_t prefixLength = std::strlen(firstName);
+    std::vector<Entry>::const_iterator entryIter = m_entries.begin();
+    std::vector<Entry>::const_iterator entryEnd = m_entries.end();
+    for (; entryIter != entryEnd && prefixLength > 0; ++entryIter) {
+        const char* name = entryIter->Name;
+        std::size_t i = 0;
+        while (i < prefixLength && name[i] == firstName[i]) {
+            ++i;
+        }
+        prefixLength = i;
+    }
+
+    // for natural order, numbers must not be split by the prefix
+    const bool isNatural = (m_order == NaturalNameOrder);
+    if (isNatural) {
+        while (prefixLength > 0 && firstName[prefixLength - 1] >= '0' &&
+               firstName[prefixLength - 1] <= '9') {
+            --prefixLength;
+        }
+    }
+
+    // make keys from rest of names
+    std::vector<Entry>::iterator keyIter = m_entries.begin();
+    std::vector<Entry>::iterator keyEnd = m_entries.end();
+    for (; keyIter != keyEnd; ++keyIter) {
+        keyIter->Key = MakeNameKey(keyIter->Name + prefixLength, isNatural);
+    }
+}
+
+// counts whole blocks & entry capacity, i.e. what is actually allocated for this run
+std::size_t SortRunBuffer::MemoryUsed() const
+{
+    return m_blockMemoryUsed + (m_entries.capacity() * sizeof(Entry));
+}
+
+// sorts entries, alignments with equal sort keys keep their order
+void SortRunBuffer::Sort(unsigned int numThreads)
+{
+    if (m_order == PositionOrder) {
+        // position keys are exact, so a (single-threaded) radix sort beats comparisons
+        Sort::SortByKey(m_entries, EntryKey());
+    } else {
+        MakeNameKeys();
+        const EntryByName comp(m_order == NaturalNameOrder);
+        ParallelStableSort(m_entries.begin(), m_entries.end(), comp, numThreads);
+    }
+}
+
+void SortRunBuffer::Swap(SortRunBuffer& other)
+{
+    std::swap(m_order, other.m_order);
+    std::swap(m_blockSize, other.m_blockSize);
+    m_blocks.swap(other.m_blocks);
+    std::swap(m_numBlocksUsed, other.m_numBlocksUsed);
+    std::swap(m_lastBlockUsed, other.m_lastBlockUsed);
+    std::swap(m_blockMemoryUsed, other.m_blockMemoryUsed);
+    m_packed.swap(other.m_packed);
+    m_entries.swap(other.m_entries);
+}
+
+// writes buffered alignments to writer, in entry order
+bool SortRunBuffer::Write(BamWriter& writer) const
+{
+    BamAlignment al;
+    std::vector<Entry>::const_iterator entryIter = m_entries.begin();
+    std::vector<Entry>::const_iterator entryEnd = m_entries.end();
+    for (; entryIter != entryEnd; ++entryIter) {
+        const Entry& entry = (*entryIter);
+        if (!al.Unpack(entry.Data, entry.Length) || !writer.SaveRawAlignment(al)) {
+            return false;
+        }
+    }
+    return true;
+}
 
 }  // namespace BamTools
 
@@ -46,31 +401,45 @@ struct SortTool::SortSettings
 {
 
     // flags
+    bool HasCompressionLevel;
     bool HasInputBamFilename;
     bool HasMaxBufferCount;
     bool HasMaxBufferMemory;
+    bool HasMaxOpenFiles;
+    bool HasNumThreads;
     bool HasOutputBamFilename;
     bool IsSortingByName;
+    bool IsSortingNaturally;
 
     // filenames
     std::string InputBamFilename;
     std::string OutputBamFilename;
 
     // parameters
+    unsigned int CompressionLevel;
     unsigned int MaxBufferCount;
     unsigned int MaxBufferMemory;
+    unsigned int MaxOpenFiles;
+    unsigned int NumThreads;
 
     // constructor
     SortSettings()
-        : HasInputBamFilename(false)
+        : HasCompressionLevel(false)
+        , HasInputBamFilename(false)
         , HasMaxBufferCount(false)
         , HasMaxBufferMemory(false)
+        , HasMaxOpenFiles(false)
+        , HasNumThreads(false)
         , HasOutputBamFilename(false)
         , IsSortingByName(false)
+        , IsSortingNaturally(false)
         , InputBamFilename(Options::StandardIn())
         , OutputBamFilename(Options::StandardOut())
-        , MaxBufferCount(SORT_DEFAULT_MAX_BUFFER_COUNT)
+        , CompressionLevel(6)
+        , MaxBufferCount(0)
         , MaxBufferMemory(SORT_DEFAULT_MAX_BUFFER_MEMORY)
+        , MaxOpenFiles(SORT_DEFAULT_MAX_OPEN_FILES)
+        , NumThreads(1)
     {}
 };
 
@@ -90,11 +459,17 @@ public:
 
     // internal methods
 private:
-    bool CreateSortedTempFile(std::vector<BamAlignment>& buffer);
+    bool CreateSortedTempFile(SortRunBuffer& buffer);
     bool GenerateSortedRuns();
+    bool IsBufferFull(const SortRunBuffer& buffer) const;
+    bool IsSortingByName() const;
+    bool MergeFiles(const std::vector<std::string>& filenames, BamWriter& writer);
     bool MergeSortedRuns();
-    bool WriteTempFile(const std::vector<BamAlignment>& buffer, const std::string& tempFilename);
-    void SortBuffer(std::vector<BamAlignment>& buffer);
+    bool MergeTempFiles(const std::vector<std::string>& filenames, const std::string& tempFilename);
+    std::string NextTempFilename();
+    bool SortAndWriteTempFile(SortRunBuffer& buffer, const std::string& tempFilename);
+    bool WaitForPendingRun();
+    bool WriteTempFile(const SortRunBuffer& buffer, const std::string& tempFilename);
 
     // data members
 private:
@@ -104,12 +479,20 @@ private:
     std::string m_headerText;
     RefVector m_references;
     std::vector<std::string> m_tempFilenames;
+    unsigned int m_numThreads;
+    std::size_t m_maxBufferMemory;  // bytes per run buffer
+
+    // run being sorted & written on a worker thread, while the next one is read
+    SortRunBuffer m_pendingRunBuffer;
+    std::future<bool> m_pendingRun;
 };
 
 // constructor
 SortTool::SortToolPrivate::SortToolPrivate(SortTool::SortSettings* settings)
     : m_settings(settings)
     , m_numberOfRuns(0)
+    , m_numThreads(1)
+    , m_maxBufferMemory(0)
 {
     // set filename stub depending on inputfile path
     // that way multiple sort runs don't trip on each other's temp files
@@ -119,6 +502,15 @@ SortTool::SortToolPrivate::SortToolPrivate(SortTool::SortSettings* settings)
             m_tempFilenameStub = m_settings->InputBamFilename.substr(0, extensionFound);
         }
         m_tempFilenameStub.append(".sort.temp.");
+        if (m_settings->HasNumThreads && m_settings->NumThreads > 1) {
+            m_numThreads = m_settings->NumThreads;
+        }
+
+        // when pipelining runs, memory is shared by the run being read & the one being written
+        m_maxBufferMemory = static_cast<std::size_t>(m_settings->MaxBufferMemory) * 1024 * 1024;
+        if (m_numThreads > 1) {
+            m_maxBufferMemory /= 2;
+        }
     }
 }
 
@@ -128,6 +520,7 @@ bool SortTool::SortToolPrivate::GenerateSortedRuns()
 
     // open input BAM file
     BamReader reader;
+    reader.SetNumThreads(m_numThreads);
     if (!reader.Open(m_settings->InputBamFilename)) {
         std::cerr << "bamtools sort ERROR: could not open " << m_settings->InputBamFilename
                   << " for reading... Aborting." << std::endl;
@@ -139,147 +532,261 @@ bool SortTool::SortToolPrivate::GenerateSortedRuns()
     if (!header.HasVersion()) {
         header.Version = Constants::SAM_CURRENT_VERSION;
     }
-    header.SortOrder = (m_settings->IsSortingByName ? Constants::SAM_HD_SORTORDER_QUERYNAME
-                                                    : Constants::SAM_HD_SORTORDER_COORDINATE);
+    header.SortOrder = (IsSortingByName() ? Constants::SAM_HD_SORTORDER_QUERYNAME
+                                          : Constants::SAM_HD_SORTORDER_COORDINATE);
+
+    // replace any sub-sort order, flagging natural order (for merging temp files too)
+    std::vector<CustomHeaderTag>& hdTags = header.CustomTags;
+    for (std::size_t i = 0; i < hdTags.size();) {
+        if (hdTags[i].TagName == Constants::SAM_HD_SUBSORTORDER_TAG) {
+            hdTags.erase(hdTags.begin() + i);
+        } else {
+            ++i;
+        }
+    }
+    if (m_settings->IsSortingNaturally) {
+        CustomHeaderTag subSortTag;
+        subSortTag.TagName = Constants::SAM_HD_SUBSORTORDER_TAG;
+        subSortTag.TagValue = Constants::SAM_HD_SUBSORTORDER_QUERYNAME_NATURAL;
+        hdTags.push_back(subSortTag);
+    }
     m_headerText = header.ToString();
     m_references = reader.GetReferenceData();
 
     // set up alignments buffer
     BamAlignment al;
-    std::vector<BamAlignment> buffer;
-    buffer.reserve(static_cast<std::size_t>(m_settings->MaxBufferCount * 1.1));
-    bool bufferFull = false;
-
-    // if sorting by name, we need to generate full char data
-    // so can't use GetNextAlignmentCore()
-    if (m_settings->IsSortingByName) {
-
-        // iterate through file
-        while (reader.GetNextAlignment(al)) {
-
-            // check buffer's usage
-            bufferFull = (buffer.size() >= m_settings->MaxBufferCount);
-
-            // store alignments until buffer is "full"
-            if (!bufferFull) {
-                buffer.push_back(al);
-
-                // if buffer is "full"
-            } else {
-                // so create a sorted temp file with current buffer contents
-                // then push "al" into fresh buffer
-                CreateSortedTempFile(buffer);
-                buffer.push_back(al);
-            }
-        }
+    SortRunBuffer::SortOrder sortOrder = SortRunBuffer::PositionOrder;
+    if (m_settings->IsSortingNaturally) {
+        sortOrder = SortRunBuffer::NaturalNameOrder;
+    } else if (m_settings->IsSortingByName) {
+        sortOrder = SortRunBuffer::NameOrder;
     }
+    //   * buffers grow as needed (& keep their memory between runs), so small inputs stay cheap
+    //   * a run's memory may pass the budget by one block, so blocks are a fraction of it
+    const std::size_t blockSize = std::min(
+        std::max(m_maxBufferMemory / 16, SORT_MIN_BUFFER_BLOCK_SIZE), SORT_MAX_BUFFER_BLOCK_SIZE);
+    SortRunBuffer buffer(sortOrder, blockSize);
+    m_pendingRunBuffer =
+        SortRunBuffer(sortOrder, blockSize);  // swapped with buffer when pipelining
+    bool success = true;
+
+    // iterate through file, using GNACore() speedup
+    // (read names are decoded on demand when sorting by name)
+    while (success && reader.GetNextAlignmentCore(al)) {
+
+        // if buffer is "full", create a sorted temp file with its contents first
+        if (IsBufferFull(buffer)) {
+            success = CreateSortedTempFile(buffer);
+        }
 
-    // sorting by position, can take advantage of GNACore() speedup
-    else {
-
-        // iterate through file
-        while (reader.GetNextAlignmentCore(al)) {
-
-            // check buffer's usage
-            bufferFull = (buffer.size() >= m_settings->MaxBufferCount);
-
-            // store alignments until buffer is "full"
-            if (!bufferFull) {
-                buffer.push_back(al);
-
-                // if buffer is "full"
-            } else {
-                // create a sorted temp file with current buffer contents
-                // then push "al" into fresh buffer
-                CreateSortedTempFile(buffer);
-                buffer.push_back(al);
-            }
+        // store alignment
+        if (success && !buffer.Add(al)) {
+            std::cerr << "bamtools sort ERROR: could not buffer alignment: " << al.GetErrorString()
+                      << std::endl;
+            success = false;
         }
     }
 
     // handle any leftover buffer contents
-    if (!buffer.empty()) {
-        CreateSortedTempFile(buffer);
+    if (success && !buffer.IsEmpty()) {
+        success = CreateSortedTempFile(buffer);
     }
 
+    // make sure last run is on disk
+    if (!WaitForPendingRun()) {
+        success = false;
+    }
+    m_pendingRunBuffer = SortRunBuffer();  // releases its memory before merging
+
     // close reader & return success
     reader.Close();
-    return true;
+    return success;
 }
 
-bool SortTool::SortToolPrivate::CreateSortedTempFile(std::vector<BamAlignment>& buffer)
+// sorts buffer & writes it to next temp file
+//
+// With multiple threads, the buffer is handed over to a worker thread (leaving it empty), so
+// the caller can go on filling it with the next run. A failure to write the previous run is
+// reported here.
+bool SortTool::SortToolPrivate::CreateSortedTempFile(SortRunBuffer& buffer)
 {
 
-    // do sorting
-    SortBuffer(buffer);
-
-    // write sorted contents to temp file, store success/fail
-    std::stringstream tempStr;
-    tempStr << m_tempFilenameStub << m_numberOfRuns;
-    bool success = WriteTempFile(buffer, tempStr.str());
-
     // save temp filename for merging later
-    m_tempFilenames.push_back(tempStr.str());
-
-    // clear buffer contents & update run counter
-    buffer.clear();
-    ++m_numberOfRuns;
+    const std::string tempFilename = NextTempFilename();
+    m_tempFilenames.push_back(tempFilename);
+
+    // single-threaded, sort & write in place
+    if (m_numThreads <= 1) {
+        const bool success = SortAndWriteTempFile(buffer, tempFilename);
+        buffer.Clear();
+        return success;
+    }
 
-    // return success/fail of writing to temp file
-    // TODO: a failure returned here is not actually caught and handled anywhere
+    // wait for previous run, then recycle its buffer for the next one
+    const bool success = WaitForPendingRun();
+    m_pendingRunBuffer.Swap(buffer);
+    buffer.Clear();
+    m_pendingRun = std::async(std::launch::async, &SortToolPrivate::SortAndWriteTempFile, this,
+                              std::ref(m_pendingRunBuffer), tempFilename);
     return success;
 }
 
-// merges sorted temp BAM files into single sorted output BAM file
-bool SortTool::SortToolPrivate::MergeSortedRuns()
+// returns true if buffer has reached the memory budget (or requested alignment count)
+bool SortTool::SortToolPrivate::IsBufferFull(const SortRunBuffer& buffer) const
+{
+    if (buffer.IsEmpty()) {
+        return false;
+    }
+    if (m_settings->HasMaxBufferCount && buffer.Count() >= m_settings->MaxBufferCount) {
+        return true;
+    }
+    return (buffer.MemoryUsed() >= m_maxBufferMemory);
+}
+
+// returns true if sorting by name, in either order
+bool SortTool::SortToolPrivate::IsSortingByName() const
+{
+    return (m_settings->IsSortingByName || m_settings->IsSortingNaturally);
+}
+
+// copies all alignments from sorted BAM files into writer, deleting the files afterwards
+bool SortTool::SortToolPrivate::MergeFiles(const std::vector<std::string>& filenames,
+                                           BamWriter& writer)
 {
 
-    // open up multi reader for all of our temp files
-    // this might get broken up if we do a multi-pass system later ??
+    // open up multi reader for files
+    // files are runs in input order, so breaking ties by file keeps the sort stable
     BamMultiReader multiReader;
-    if (!multiReader.Open(m_tempFilenames)) {
+    multiReader.SetNumThreads(m_numThreads);
+    multiReader.SetStableMerge(true);
+    if (!multiReader.Open(filenames)) {
         std::cerr << "bamtools sort ERROR: could not open BamMultiReader for merging temp files... "
                      "Aborting."
                   << std::endl;
         return false;
     }
 
-    // open writer for our completely sorted output BAM file
-    BamWriter mergedWriter;
-    if (!mergedWriter.Open(m_settings->OutputBamFilename, m_headerText, m_references)) {
-        std::cerr << "bamtools sort ERROR: could not open " << m_settings->OutputBamFilename
-                  << " for writing... Aborting." << std::endl;
-        multiReader.Close();
-        return false;
-    }
-
     // while data available in temp files
+    bool success = true;
     BamAlignment al;
     while (multiReader.GetNextAlignmentCore(al)) {
-        mergedWriter.SaveAlignment(al);
+        if (!writer.SaveRawAlignment(al)) {
+            std::cerr << "bamtools sort ERROR: could not write merged alignments: "
+                      << writer.GetErrorString() << std::endl;
+            success = false;
+            break;
+        }
     }
 
-    // close files
+    // close reader
     multiReader.Close();
-    mergedWriter.Close();
 
-    // delete all temp files
-    std::vector<std::string>::const_iterator tempIter = m_tempFilenames.begin();
-    std::vector<std::string>::const_iterator tempEnd = m_tempFilenames.end();
+    // delete merged temp files
+    std::vector<std::string>::const_iterator tempIter = filenames.begin();
+    std::vector<std::string>::const_iterator tempEnd = filenames.end();
     for (; tempIter != tempEnd; ++tempIter) {
         const std::string& tempFilename = (*tempIter);
         remove(tempFilename.c_str());
     }
 
-    // return success
-    return true;
+    // return success/fail
+    return success;
+}
+
+// merges sorted temp BAM files into single sorted output BAM file
+bool SortTool::SortToolPrivate::MergeSortedRuns()
+{
+
+    // if there are too many temp files to open at once, merge groups of them into larger
+    // temp files first. Each merge reduces the file count by (group size - 1), so groups are
+    // only as large as needed to get down to the limit, keeping the re-written data small.
+    const std::size_t maxOpenFiles = std::max(m_settings->MaxOpenFiles, 2u);
+    while (m_tempFilenames.size() > maxOpenFiles) {
+
+        std::vector<std::string> mergedFilenames;
+        std::vector<std::string>::const_iterator tempIter = m_tempFilenames.begin();
+        std::vector<std::string>::const_iterator tempEnd = m_tempFilenames.end();
+        while (tempIter != tempEnd) {
+
+            // stop merging once the remaining files fit, or are left for next pass
+            const std::size_t numRemaining = tempEnd - tempIter;
+            const std::size_t numFiles = mergedFilenames.size() + numRemaining;
+            const std::size_t groupSize =
+                std::min(std::min(maxOpenFiles, numFiles - maxOpenFiles + 1), numRemaining);
+            if (numFiles <= maxOpenFiles || groupSize < 2) {
+                mergedFilenames.insert(mergedFilenames.end(), tempIter, tempEnd);
+                break;
+            }
+
+            // merge next group into new temp file
+            const std::vector<std::string> group(tempIter, tempIter + groupSize);
+            const std::string tempFilename = NextTempFilename();
+            if (!MergeTempFiles(group, tempFilename)) {
+                return false;
+            }
+            mergedFilenames.push_back(tempFilename);
+            tempIter += groupSize;
+        }
+        m_tempFilenames.swap(mergedFilenames);
+    }
+
+    // open writer for our completely sorted output BAM file
+    BamWriter mergedWriter;
+    mergedWriter.SetNumThreads(m_numThreads);
+    if (m_settings->HasCompressionLevel) {
+        mergedWriter.SetCompressionLevel(m_settings->CompressionLevel);
+    }
+    if (!mergedWriter.Open(m_settings->OutputBamFilename, m_headerText, m_references)) {
+        std::cerr << "bamtools sort ERROR: could not open " << m_settings->OutputBamFilename
+                  << " for writing... Aborting." << std::endl;
+        return false;
+    }
+
+    // merge all temp files into output
+    const bool success = MergeFiles(m_tempFilenames, mergedWriter);
+    mergedWriter.Close();
+    return success;
+}
+
+// merges sorted temp BAM files into a new (larger) temp file
+bool SortTool::SortToolPrivate::MergeTempFiles(const std::vector<std::string>& filenames,
+                                               const std::string& tempFilename)
+{
+    // open temp file for writing
+    BamWriter tempWriter;
+    tempWriter.SetCompressionLevel(SORT_TEMP_COMPRESSION_LEVEL);
+    tempWriter.SetNumThreads(m_numThreads);
+    if (!tempWriter.Open(tempFilename, m_headerText, m_references)) {
+        std::cerr << "bamtools sort ERROR: could not open " << tempFilename << " for writing."
+                  << std::endl;
+        return false;
+    }
+
+    // merge files & close temp file
+    const bool success = MergeFiles(filenames, tempWriter);
+    tempWriter.Close();
+    return success;
+}
+
+std::string SortTool::SortToolPrivate::NextTempFilename()
+{
+    std::stringstream tempStr;
+    tempStr << m_tempFilenameStub << m_numberOfRuns;
+    ++m_numberOfRuns;
+    return tempStr.str();
 }
 
 bool SortTool::SortToolPrivate::Run()
 {
 
-    // this does a single pass, chunking up the input file into smaller sorted temp files,
-    // then write out using BamMultiReader to handle merging
+    // check compression level (BamWriter would quietly treat levels above 9 as 9)
+    if (m_settings->HasCompressionLevel && m_settings->CompressionLevel > 9) {
+        std::cerr << "bamtools sort ERROR: -level must be from 0 to 9... Aborting." << std::endl;
+        return false;
+    }
+
+    // this chunks up the input file into smaller sorted temp files, then writes out using
+    // BamMultiReader to handle merging (in several passes, if there are many temp files)
 
     if (GenerateSortedRuns()) {
         return MergeSortedRuns();
@@ -288,24 +795,29 @@ bool SortTool::SortToolPrivate::Run()
     }
 }
 
-void SortTool::SortToolPrivate::SortBuffer(std::vector<BamAlignment>& buffer)
+bool SortTool::SortToolPrivate::SortAndWriteTempFile(SortRunBuffer& buffer,
+                                                     const std::string& tempFilename)
 {
+    buffer.Sort(m_numThreads);
+    return WriteTempFile(buffer, tempFilename);
+}
 
-    // ** add further custom sort options later ?? **
-
-    // sort buffer by desired method
-    if (m_settings->IsSortingByName) {
-        std::stable_sort(buffer.begin(), buffer.end(), Sort::ByName());
-    } else {
-        std::stable_sort(buffer.begin(), buffer.end(), Sort::ByPosition());
+// waits for run being written on a worker thread (if any), returns its success/fail
+bool SortTool::SortToolPrivate::WaitForPendingRun()
+{
+    if (!m_pendingRun.valid()) {
+        return true;
     }
+    return m_pendingRun.get();
 }
 
-bool SortTool::SortToolPrivate::WriteTempFile(const std::vector<BamAlignment>& buffer,
+bool SortTool::SortToolPrivate::WriteTempFile(const SortRunBuffer& buffer,
                                               const std::string& tempFilename)
 {
     // open temp file for writing
     BamWriter tempWriter;
+    tempWriter.SetCompressionLevel(SORT_TEMP_COMPRESSION_LEVEL);
+    tempWriter.SetNumThreads(m_numThreads);
     if (!tempWriter.Open(tempFilename, m_headerText, m_references)) {
         std::cerr << "bamtools sort ERROR: could not open " << tempFilename << " for writing."
                   << std::endl;
@@ -313,16 +825,14 @@ bool SortTool::SortToolPrivate::WriteTempFile(const std::vector<BamAlignment>& b
     }
 
     // write data
-    std::vector<BamAlignment>::const_iterator buffIter = buffer.begin();
-    std::vector<BamAlignment>::const_iterator buffEnd = buffer.end();
-    for (; buffIter != buffEnd; ++buffIter) {
-        const BamAlignment& al = (*buffIter);
-        tempWriter.SaveAlignment(al);
+    const bool success = buffer.Write(tempWriter);
+    if (!success) {
+        std::cerr << "bamtools sort ERROR: could not write to " << tempFilename << std::endl;
     }
 
     // close temp file & return success
     tempWriter.Close();
-    return true;
+    return success;
 }
 
 // ---------------------------------------------
@@ -334,8 +844,9 @@ SortTool::SortTool()
     , m_impl(0)
 {
     // set program details
-    Options::SetProgramInfo("bamtools sort", "sorts a BAM file",
-                            "[-in <filename>] [-out <filename>] [sortOptions]");
+    Options::SetProgramInfo(
+        "bamtools sort", "sorts a BAM file",
+        "[-in <filename>] [-out <filename>] [-level <0-9>] [-threads <N>] [sortOptions]");
 
     // set up options
     OptionGroup* IO_Opts = Options::CreateOptionGroup("Input & Output");
@@ -345,16 +856,34 @@ SortTool::SortTool()
     Options::AddValueOption("-out", "BAM filename", "the output BAM file", "",
                             m_settings->HasOutputBamFilename, m_settings->OutputBamFilename,
                             IO_Opts, Options::StandardOut());
+    Options::AddValueOption(
+        "-level", "0-9", "compression level for output BAM file, from 0 (none) to 9 (smallest)", "",
+        m_settings->HasCompressionLevel, m_settings->CompressionLevel, IO_Opts);
+    Options::AddValueOption("-threads", "N",
+                            "number of threads used to sort & compress temp files, while reading "
+                            "ahead from the input",
+                            "", m_settings->HasNumThreads, m_settings->NumThreads, IO_Opts);
 
     OptionGroup* SortOpts = Options::CreateOptionGroup("Sorting Methods");
     Options::AddOption("-byname", "sort by alignment name", m_settings->IsSortingByName, SortOpts);
+    Options::AddOption("-natural",
+                       "sort by alignment name, comparing numbers in names by value (e.g. read9 "
+                       "before read10), like samtools",
+                       m_settings->IsSortingNaturally, SortOpts);
 
     OptionGroup* MemOpts = Options::CreateOptionGroup("Memory Settings");
-    Options::AddValueOption("-n", "count", "max number of alignments per tempfile", "",
-                            m_settings->HasMaxBufferCount, m_settings->MaxBufferCount, MemOpts,
-                            SORT_DEFAULT_MAX_BUFFER_COUNT);
-    Options::AddValueOption("-mem", "Mb", "max memory to use", "", m_settings->HasMaxBufferMemory,
-                            m_settings->MaxBufferMemory, MemOpts, SORT_DEFAULT_MAX_BUFFER_MEMORY);
+    Options::AddValueOption("-n", "count",
+                            "max number of alignments per tempfile (by default, tempfiles are "
+                            "only limited by -mem)",
+                            "", m_settings->HasMaxBufferCount, m_settings->MaxBufferCount, MemOpts);
+    Options::AddValueOption("-mem", "Mb", "max memory used to buffer alignments", "",
+                            m_settings->HasMaxBufferMemory, m_settings->MaxBufferMemory, MemOpts,
+                            SORT_DEFAULT_MAX_BUFFER_MEMORY);
+    Options::AddValueOption("-maxfiles", "count",
+                            "max number of tempfiles merged at once. If there are more, they are "
+                            "merged in several passes",
+                            "", m_settings->HasMaxOpenFiles, m_settings->MaxOpenFiles, MemOpts,
+                            SORT_DEFAULT_MAX_OPEN_FILES);
 }
 
 SortTool::~SortTool()
@@ -71,6 +71,7 @@ struct SplitTool::SplitSettings
 {
 
     // flags
+    bool HasCompressionLevel;
     bool HasInputFilename;
     bool HasCustomOutputStub;
     bool HasCustomRefPrefix;
@@ -89,9 +90,13 @@ struct SplitTool::SplitSettings
     std::string TagToSplit;
     std::string ListTagDelimiter;
 
+    // other parameters
+    unsigned int CompressionLevel;
+
     // constructor
     SplitSettings()
-        : HasInputFilename(false)
+        : HasCompressionLevel(false)
+        , HasInputFilename(false)
         , HasCustomOutputStub(false)
         , HasCustomRefPrefix(false)
         , HasCustomTagPrefix(false)
@@ -102,6 +107,7 @@ struct SplitTool::SplitSettings
         , IsSplittingTag(false)
         , InputFilename(Options::StandardIn())
         , ListTagDelimiter("--")
+        , CompressionLevel(6)
     {}
 };
 
@@ -200,6 +206,12 @@ bool SplitTool::SplitToolPrivate::OpenReader()
 bool SplitTool::SplitToolPrivate::Run()
 {
 
+    // check compression level (BamWriter would quietly treat levels above 9 as 9)
+    if (m_settings->HasCompressionLevel && m_settings->CompressionLevel > 9) {
+        std::cerr << "bamtools split ERROR: -level must be from 0 to 9... Aborting." << std::endl;
+        return false;
+    }
+
     // determine output stub
     DetermineOutputFilenameStub();
 
@@ -241,7 +253,7 @@ bool SplitTool::SplitToolPrivate::SplitMapped()
     BamAlignment al;
     BamWriter* writer;
     bool isCurrentAlignmentMapped;
-    while (m_reader.GetNextAlignment(al)) {
+    while (m_reader.GetNextAlignmentCore(al)) {
 
         // see if bool value exists
         isCurrentAlignmentMapped = al.IsMapped();
@@ -255,6 +267,9 @@ bool SplitTool::SplitToolPrivate::SplitMapped()
                 m_outputFilenameStub +
                 (isCurrentAlignmentMapped ? SPLIT_MAPPED_TOKEN : SPLIT_UNMAPPED_TOKEN) + ".bam";
             writer = new BamWriter;
+            if (m_settings->HasCompressionLevel) {
+                writer->SetCompressionLevel(m_settings->CompressionLevel);
+            }
             if (!writer->Open(outputFilename, m_header, m_references)) {
                 std::cerr << "bamtools split ERROR: could not open " << outputFilename
                           << " for writing." << std::endl;
@@ -272,7 +287,7 @@ bool SplitTool::SplitToolPrivate::SplitMapped()
 
         // store alignment in proper BAM output file
         if (writer) {
-            writer->SaveAlignment(al);
+            writer->SaveRawAlignment(al);
         }
     }
 
@@ -294,7 +309,7 @@ bool SplitTool::SplitToolPrivate::SplitPaired()
     BamAlignment al;
     BamWriter* writer;
     bool isCurrentAlignmentPaired;
-    while (m_reader.GetNextAlignment(al)) {
+    while (m_reader.GetNextAlignmentCore(al)) {
 
         // see if bool value exists
         isCurrentAlignmentPaired = al.IsPaired();
@@ -308,6 +323,9 @@ bool SplitTool::SplitToolPrivate::SplitPaired()
                 m_outputFilenameStub +
                 (isCurrentAlignmentPaired ? SPLIT_PAIRED_TOKEN : SPLIT_SINGLE_TOKEN) + ".bam";
             writer = new BamWriter;
+            if (m_settings->HasCompressionLevel) {
+                writer->SetCompressionLevel(m_settings->CompressionLevel);
+            }
             if (!writer->Open(outputFilename, m_header, m_references)) {
                 std::cerr << "bamtool split ERROR: could not open " << outputFilename
                           << " for writing." << std::endl;
@@ -325,7 +343,7 @@ bool SplitTool::SplitToolPrivate::SplitPaired()
 
         // store alignment in proper BAM output file
         if (writer) {
-            writer->SaveAlignment(al);
+            writer->SaveRawAlignment(al);
         }
     }
 
@@ -359,7 +377,7 @@ bool SplitTool::SplitToolPrivate::SplitReference()
     BamAlignment al;
     BamWriter* writer;
     int32_t currentRefId;
-    while (m_reader.GetNextAlignment(al)) {
+    while (m_reader.GetNextAlignmentCore(al)) {
 
         // see if bool value exists
         currentRefId = al.RefID;
@@ -381,6 +399,9 @@ bool SplitTool::SplitToolPrivate::SplitReference()
 
             // open new BamWriter
             writer = new BamWriter;
+            if (m_settings->HasCompressionLevel) {
+                writer->SetCompressionLevel(m_settings->CompressionLevel);
+            }
             if (!writer->Open(outputFilename, m_header, m_references)) {
                 std::cerr << "bamtools split ERROR: could not open " << outputFilename
                           << " for writing." << std::endl;
@@ -398,7 +419,7 @@ bool SplitTool::SplitToolPrivate::SplitReference()
 
         // store alignment in proper BAM output file
         if (writer) {
-            writer->SaveAlignment(al);
+            writer->SaveRawAlignment(al);
         }
     }
 
@@ -415,7 +436,7 @@ bool SplitTool::SplitToolPrivate::SplitTag()
 
     // iterate through alignments, until we hit TAG
     BamAlignment al;
-    while (m_reader.GetNextAlignment(al)) {
+    while (m_reader.GetNextAlignmentCore(al)) {
 
         // look for tag in this alignment and get tag type
         char tagType(0);
@@ -550,7 +571,7 @@ bool SplitTool::SplitToolPrivate::SplitListTagImpl(BamAlignment& al)
     const std::string tag = m_settings->TagToSplit;
     BamWriter* writer;
     TagValueType currentValue;
-    while (m_reader.GetNextAlignment(al)) {
+    while (m_reader.GetNextAlignmentCore(al)) {
 
         std::string listTagLabel;
         if (!al.GetTag(tag, currentValue)) {
@@ -582,6 +603,9 @@ bool SplitTool::SplitToolPrivate::SplitListTagImpl(BamAlignment& al)
             outputFilenameStream << m_outputFilenameStub << tagPrefix << tag << '_' << listTagLabel
                                  << ".bam";
             writer = new BamWriter;
+            if (m_settings->HasCompressionLevel) {
+                writer->SetCompressionLevel(m_settings->CompressionLevel);
+            }
             if (!writer->Open(outputFilenameStream.str(), m_header, m_references)) {
                 std::cerr << "bamtools split ERROR: could not open " << outputFilenameStream.str()
                           << " for writing." << std::endl;
@@ -599,7 +623,7 @@ bool SplitTool::SplitToolPrivate::SplitListTagImpl(BamAlignment& al)
 
         // store alignment in proper BAM output file
         if (writer) {
-            writer->SaveAlignment(al);
+            writer->SaveRawAlignment(al);
         }
     }
 
@@ -646,12 +670,15 @@ bool SplitTool::SplitToolPrivate::SplitTagImpl(BamAlignment& al)
         outputFilenameStream << m_outputFilenameStub << tagPrefix << tag << '_' << currentValue
                              << ".bam";
         writer = new BamWriter;
+        if (m_settings->HasCompressionLevel) {
+            writer->SetCompressionLevel(m_settings->CompressionLevel);
+        }
         if (!writer->Open(outputFilenameStream.str(), m_header, m_references)) {
             std::cerr << "bamtools split ERROR: could not open " << outputFilenameStream.str()
                       << " for writing." << std::endl;
             return false;
         }
-        writer->SaveAlignment(al);
+        writer->SaveRawAlignment(al);
 
         // store in map
         outputFiles.insert(std::make_pair(currentValue, writer));
@@ -661,7 +688,7 @@ bool SplitTool::SplitToolPrivate::SplitTagImpl(BamAlignment& al)
     }
 
     // iterate through remaining alignments
-    while (m_reader.GetNextAlignment(al)) {
+    while (m_reader.GetNextAlignmentCore(al)) {
 
         // skip if this alignment doesn't have TAG
         if (!al.GetTag(tag, currentValue)) {
@@ -678,6 +705,9 @@ bool SplitTool::SplitToolPrivate::SplitTagImpl(BamAlignment& al)
             outputFilenameStream << m_outputFilenameStub << tagPrefix << tag << '_' << currentValue
                                  << ".bam";
             writer = new BamWriter;
+            if (m_settings->HasCompressionLevel) {
+                writer->SetCompressionLevel(m_settings->CompressionLevel);
+            }
             if (!writer->Open(outputFilenameStream.str(), m_header, m_references)) {
                 std::cerr << "bamtool split ERROR: could not open " << outputFilenameStream.str()
                           << " for writing." << std::endl;
@@ -698,7 +728,7 @@ bool SplitTool::SplitToolPrivate::SplitTagImpl(BamAlignment& al)
 
         // store alignment in proper BAM output file
         if (writer) {
-            writer->SaveAlignment(al);
+            writer->SaveRawAlignment(al);
         }
     }
 
@@ -723,7 +753,8 @@ SplitTool::SplitTool()
         "splits a BAM file on user-specified property, creating a new BAM output file for each "
         "value found";
     const std::string args =
-        "[-in <filename>] [-stub <filename stub>] < -mapped | -paired | -reference [-refPrefix "
+        "[-in <filename>] [-stub <filename stub>] [-level <0-9>] < -mapped | -paired | -reference "
+        "[-refPrefix "
         "<prefix>] | -tag <TAG> > ";
     Options::SetProgramInfo(name, description, args);
 
@@ -753,6 +784,9 @@ SplitTool::SplitTool()
                             "splitting on list-type tags [--]",
                             "", m_settings->HasListTagDelimiter, m_settings->ListTagDelimiter,
                             IO_Opts);
+    Options::AddValueOption(
+        "-level", "0-9", "compression level for output BAM files, from 0 (none) to 9 (smallest)",
+        "", m_settings->HasCompressionLevel, m_settings->CompressionLevel, IO_Opts);
 
     OptionGroup* SplitOpts = Options::CreateOptionGroup("Split Options");
     Options::AddOption("-mapped", "split mapped/unmapped alignments", m_settings->IsSplittingMapped,
@@ -36,6 +36,32 @@
 //
 //    This allows for more complex queries (than simple isEqual?) against a variety of data types.
 //
+// Before the first query is checked, each filter set is compiled by the FilterChecker into
+// whatever form it checks fastest, and the rule queue is turned into an expression tree over
+// those compiled filters. Operands of AND|OR are evaluated cheapest first (by the checker's
+// cost estimate) & short-circuit. A FilterChecker must therefore provide:
+//
+//     typedef ... CompiledFilter;
+//     CompiledFilter compile(const PropertyFilter& filter);
+//     double cost(const CompiledFilter& filter);
+//     bool check(const CompiledFilter& filter, T& query);
+//
+// As filters may be skipped, or checked in any order, checks must not have side effects
+// (other than on-demand decoding of query data, say).
+//
+// check() is not safe to call from several threads at once (the first call compiles, & a
+// FilterChecker may keep state such as counters). To check on several threads, give each
+// its own copy of the engine, made after compiling (say, via compiledFilters()).
+//
+// bounds<Bounds>() folds the rule tree into a Bounds on which queries may pass at all (to
+// limit what has to be read, say). This needs the FilterChecker to also provide:
+//
+//     void bound(const CompiledFilter& filter, Bounds& bounds);
+//
+// where a default-constructed Bounds lets everything through, and Bounds provides
+// intersect(const Bounds&) & unite(const Bounds&), each of which may widen the exact result.
+// NOT is never bounded.
+//
 // ***************************************************************************
 
 #ifndef BAMTOOLS_FILTER_ENGINE_H
@@ -79,6 +105,8 @@ class UTILS_EXPORT FilterEngine
 public:
     FilterEngine()
         : m_isRuleQueueGenerated(false)
+        , m_ruleRootNode(0)
+        , m_isRuleProgramCompiled(false)
         , m_defaultCompareType(FilterCompareType::OR)
         , AND_OPERATOR(1, '&')
         , OR_OPERATOR(1, '|')
@@ -131,14 +159,50 @@ public:
 public:
     // returns true if query passes all filters in FilterEngine
     template <typename T>
-    bool check(const T& query);
+    bool check(T& query);
+
+    // returns bounds on queries that may pass the filter rules
+    template <typename Bounds>
+    Bounds bounds();
+
+    // access to checker & compiled filter sets (in filterNames() order, once compiled)
+public:
+    FilterChecker& checker();
+    const std::vector<typename FilterChecker::CompiledFilter>& compiledFilters();
 
     // internal rule-handling methods
 private:
     void buildDefaultRuleString();
     void buildRuleQueue();
+    void buildRuleTree();
+    void compileFilters();
+    template <typename Bounds>
+    Bounds boundNode(const std::size_t& nodeIndex);
+    template <typename T>
+    bool evaluateNode(const std::size_t& nodeIndex, T& query);
     template <typename T>
-    bool evaluateFilterRules(const T& query);
+    bool evaluateFilterRules(T& query);
+
+    // rule expression tree node, either a filter or an operator on its child nodes
+    struct RuleNode
+    {
+        bool IsFilter;
+        FilterCompareType::Type Operator;
+        std::size_t FilterIndex;
+        std::vector<std::size_t> Children;
+        double Cost;
+    };
+    struct RuleNodeCostLess
+    {
+        const std::vector<RuleNode>& Nodes;
+        RuleNodeCostLess(const std::vector<RuleNode>& nodes)
+            : Nodes(nodes)
+        {}
+        bool operator()(const std::size_t& lhs, const std::size_t& rhs) const
+        {
+            return Nodes[lhs].Cost < Nodes[rhs].Cost;
+        }
+    };
 
     // data members
 private:
@@ -158,6 +222,12 @@ private:
     // flag to test if the rule expression queue has been generated
     bool m_isRuleQueueGenerated;
 
+    // filter sets & rule expression tree, compiled for checking (rebuilt if either changes)
+    std::vector<typename FilterChecker::CompiledFilter> m_compiledFilters;
+    std::vector<RuleNode> m_ruleNodes;
+    std::size_t m_ruleRootNode;
+    bool m_isRuleProgramCompiled;
+
     // 'default' comparison operator between filters if no rule string given
     // if this is changed, m_ruleString is used to build new m_ruleQueue
     FilterCompareType::Type m_defaultCompareType;
@@ -182,6 +252,7 @@ private:
 template <typename FilterChecker>
 bool FilterEngine<FilterChecker>::addFilter(const std::string& filterName)
 {
+    m_isRuleProgramCompiled = false;
     return (m_filters.insert(std::make_pair(filterName, PropertyFilter()))).second;
 }
 
@@ -270,12 +341,49 @@ void FilterEngine<FilterChecker>::buildRuleQueue()
 
     // set flag if rule queue contains any values
     m_isRuleQueueGenerated = (!m_ruleQueue.empty());
+    m_isRuleProgramCompiled = false;
+}
+
+// returns bounds on queries that may pass the filter rules
+template <typename FilterChecker>
+template <typename Bounds>
+Bounds FilterEngine<FilterChecker>::bounds()
+{
+
+    // compile rules & filters if not done before
+    if (!m_isRuleProgramCompiled) {
+        compileFilters();
+    }
+
+    // no rule (i.e. no filters) lets everything through
+    if (m_ruleRootNode >= m_ruleNodes.size()) {
+        return Bounds();
+    }
+    return boundNode<Bounds>(m_ruleRootNode);
+}
+
+// returns checker used by FilterEngine
+template <typename FilterChecker>
+FilterChecker& FilterEngine<FilterChecker>::checker()
+{
+    return m_checker;
+}
+
+// returns compiled filter sets, compiling them if not done before
+template <typename FilterChecker>
+const std::vector<typename FilterChecker::CompiledFilter>&
+FilterEngine<FilterChecker>::compiledFilters()
+{
+    if (!m_isRuleProgramCompiled) {
+        compileFilters();
+    }
+    return m_compiledFilters;
 }
 
 // returns whether query value passes filter engine rules
 template <class FilterChecker>
 template <typename T>
-bool FilterEngine<FilterChecker>::check(const T& query)
+bool FilterEngine<FilterChecker>::check(T& query)
 {
 
     // return result of querying against filter rules
@@ -301,68 +409,209 @@ const std::vector<std::string> FilterEngine<FilterChecker>::enabledPropertyNames
     return names;
 }
 
-// evaluates postfix rule queue - with each filter as an operand, AND|OR|NOT as operators
-template <class FilterChecker>
-template <typename T>
-bool FilterEngine<FilterChecker>::evaluateFilterRules(const T& query)
+// builds expression tree from postfix rule queue, over already compiled filter sets
+template <typename FilterChecker>
+void FilterEngine<FilterChecker>::buildRuleTree()
 {
 
-    // build ruleQueue if not done before
-    if (!m_isRuleQueueGenerated) {
-        buildRuleQueue();
-    }
-
-    std::stack<bool> resultStack;
-    FilterMap::const_iterator filterIter;
+    m_ruleNodes.clear();
+    std::stack<std::size_t> operands;
     std::queue<std::string> ruleQueueCopy = m_ruleQueue;
     while (!ruleQueueCopy.empty()) {
         const std::string& token = ruleQueueCopy.front();
 
+        RuleNode node;
+        node.IsFilter = false;
+        node.Operator = FilterCompareType::AND;
+        node.FilterIndex = 0;
+        node.Cost = 0.0;
+
         // token is NOT_OPERATOR
         if (token == FilterEngine<FilterChecker>::NOT_OPERATOR) {
-            BAMTOOLS_ASSERT_MESSAGE(!resultStack.empty(),
+            BAMTOOLS_ASSERT_MESSAGE(!operands.empty(),
                                     "Empty result stack - cannot apply operator: !");
-            resultStack.top() = !resultStack.top();
-        }
-
-        // token is AND_OPERATOR
-        else if (token == FilterEngine<FilterChecker>::AND_OPERATOR) {
-            BAMTOOLS_ASSERT_MESSAGE(resultStack.size() >= 2,
-                                    "Not enough operands - cannot apply operator: &");
-            bool topResult = resultStack.top();
-            resultStack.pop();
-            resultStack.top() &= topResult;
+            node.Operator = FilterCompareType::NOT;
+            node.Children.push_back(operands.top());
+            node.Cost = m_ruleNodes[operands.top()].Cost;
+            operands.pop();
         }
 
-        // token is OR_OPERATOR
-        else if (token == FilterEngine<FilterChecker>::OR_OPERATOR) {
-            BAMTOOLS_ASSERT_MESSAGE(resultStack.size() >= 2,
-                                    "Not enough operands - cannot apply operator: |");
-            bool topResult = resultStack.top();
-            resultStack.pop();
-            resultStack.top() |= topResult;
+        // token is AND_OPERATOR or OR_OPERATOR
+        else if (token == FilterEngine<FilterChecker>::AND_OPERATOR ||
+                 token == FilterEngine<FilterChecker>::OR_OPERATOR) {
+            BAMTOOLS_ASSERT_MESSAGE(operands.size() >= 2,
+                                    "Not enough operands - cannot apply operator: " + token);
+            node.Operator = (token == FilterEngine<FilterChecker>::AND_OPERATOR)
+                                ? FilterCompareType::AND
+                                : FilterCompareType::OR;
+            const std::size_t rhs = operands.top();
+            operands.pop();
+            const std::size_t lhs = operands.top();
+            operands.pop();
+
+            // merge operands that apply the same operator, "a & (b & c)" => "&(a, b, c)"
+            const std::size_t sides[2] = {lhs, rhs};
+            for (int i = 0; i < 2; ++i) {
+                const RuleNode& side = m_ruleNodes[sides[i]];
+                if (!side.IsFilter && side.Operator == node.Operator) {
+                    node.Children.insert(node.Children.end(), side.Children.begin(),
+                                         side.Children.end());
+                } else {
+                    node.Children.push_back(sides[i]);
+                }
+                node.Cost += side.Cost;
+            }
         }
 
-        // token is an operand
+        // token is an operand, look up PropertyFilter that matches it
         else {
-            // look up PropertyFilter that matches this token
-            filterIter = m_filters.find(token);
+            FilterMap::const_iterator filterIter = m_filters.find(token);
             BAMTOOLS_ASSERT_MESSAGE((filterIter != m_filters.end()),
                                     "Filter mentioned in rule, not found in FilterEngine");
-            const PropertyFilter& filter = (*filterIter).second;
-            bool result = m_checker.check(filter, query);
-            resultStack.push(result);
+            node.IsFilter = true;
+            if (filterIter != m_filters.end()) {
+                FilterMap::const_iterator filterBegin = m_filters.begin();
+                node.FilterIndex = std::distance(filterBegin, filterIter);
+            } else {
+                // unknown filter has no properties set, so it lets everything through
+                node.FilterIndex = m_compiledFilters.size();
+                m_compiledFilters.push_back(m_checker.compile(PropertyFilter()));
+            }
+            node.Cost = m_checker.cost(m_compiledFilters[node.FilterIndex]);
         }
 
+        // store node & push as operand for next operator
+        m_ruleNodes.push_back(node);
+        operands.push(m_ruleNodes.size() - 1);
+
         // pop token from ruleQueue
         ruleQueueCopy.pop();
     }
 
-    // return last result
+    // evaluate cheapest operands of AND|OR first
+    // (stable, so equal-cost operands keep rule order)
+    typename std::vector<RuleNode>::iterator nodeIter = m_ruleNodes.begin();
+    typename std::vector<RuleNode>::iterator nodeEnd = m_ruleNodes.end();
+    for (; nodeIter != nodeEnd; ++nodeIter) {
+        RuleNode& node = (*nodeIter);
+        if (!node.IsFilter && node.Operator != FilterCompareType::NOT) {
+            std::stable_sort(node.Children.begin(), node.Children.end(),
+                             RuleNodeCostLess(m_ruleNodes));
+        }
+    }
+
     BAMTOOLS_ASSERT_MESSAGE(
-        resultStack.size() == 1,
+        operands.size() <= 1,
         "Result stack should only have one value remaining - cannot return result");
-    return resultStack.top();
+    m_ruleRootNode = (operands.empty() ? m_ruleNodes.size() : operands.top());
+}
+
+// compiles filter sets & builds rule expression tree over them
+template <typename FilterChecker>
+void FilterEngine<FilterChecker>::compileFilters()
+{
+
+    // build ruleQueue if not done before
+    if (!m_isRuleQueueGenerated) {
+        buildRuleQueue();
+    }
+
+    // compile each filter set, in FilterMap order
+    m_compiledFilters.clear();
+    m_compiledFilters.reserve(m_filters.size());
+    FilterMap::const_iterator filterIter = m_filters.begin();
+    FilterMap::const_iterator filterEnd = m_filters.end();
+    for (; filterIter != filterEnd; ++filterIter) {
+        m_compiledFilters.push_back(m_checker.compile((*filterIter).second));
+    }
+
+    buildRuleTree();
+    m_isRuleProgramCompiled = true;
+}
+
+// bounds rule expression (sub)tree
+template <class FilterChecker>
+template <typename Bounds>
+Bounds FilterEngine<FilterChecker>::boundNode(const std::size_t& nodeIndex)
+{
+
+    Bounds result;
+    const RuleNode& node = m_ruleNodes[nodeIndex];
+    if (node.IsFilter) {
+        m_checker.bound(m_compiledFilters[node.FilterIndex], result);
+        return result;
+    }
+
+    // complement of bounds is not bounded, leave NOT unbounded
+    if (node.Operator == FilterCompareType::NOT) {
+        return result;
+    }
+
+    std::vector<std::size_t>::const_iterator childIter = node.Children.begin();
+    std::vector<std::size_t>::const_iterator childEnd = node.Children.end();
+    result = boundNode<Bounds>(*childIter);
+    for (++childIter; childIter != childEnd; ++childIter) {
+        if (node.Operator == FilterCompareType::AND) {
+            result.intersect(boundNode<Bounds>(*childIter));
+        } else {
+            result.unite(boundNode<Bounds>(*childIter));
+        }
+    }
+    return result;
+}
+
+// evaluates rule expression (sub)tree, skipping operands once the result is known
+template <class FilterChecker>
+template <typename T>
+bool FilterEngine<FilterChecker>::evaluateNode(const std::size_t& nodeIndex, T& query)
+{
+
+    const RuleNode& node = m_ruleNodes[nodeIndex];
+    if (node.IsFilter) {
+        return m_checker.check(m_compiledFilters[node.FilterIndex], query);
+    }
+
+    std::vector<std::size_t>::const_iterator childIter = node.Children.begin();
+    std::vector<std::size_t>::const_iterator childEnd = node.Children.end();
+    switch (node.Operator) {
+        case (FilterCompareType::NOT):
+            return !evaluateNode(node.Children.front(), query);
+        case (FilterCompareType::AND):
+            for (; childIter != childEnd; ++childIter) {
+                if (!evaluateNode(*childIter, query)) {
+                    return false;
+                }
+            }
+            return true;
+        case (FilterCompareType::OR):
+            for (; childIter != childEnd; ++childIter) {
+                if (evaluateNode(*childIter, query)) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            BAMTOOLS_ASSERT_UNREACHABLE;
+    }
+    return false;
+}
+
+// evaluates rule expression - with each filter as an operand, AND|OR|NOT as operators
+template <class FilterChecker>
+template <typename T>
+bool FilterEngine<FilterChecker>::evaluateFilterRules(T& query)
+{
+
+    // compile rules & filters if not done before
+    if (!m_isRuleProgramCompiled) {
+        compileFilters();
+    }
+
+    // no rule (i.e. no filters) lets everything through
+    if (m_ruleRootNode >= m_ruleNodes.size()) {
+        return true;
+    }
+    return evaluateNode(m_ruleRootNode, query);
 }
 
 // return list of current filter names
@@ -567,6 +816,7 @@ bool FilterEngine<FilterChecker>::setProperty(const std::string& filterName,
     if (!success) {
         return false;
     }
+    m_isRuleProgramCompiled = false;
 
     // --------------------------------------------
     // otherwise, set Property.IsEnabled to true
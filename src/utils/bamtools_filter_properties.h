@@ -80,6 +80,12 @@ struct UTILS_EXPORT PropertyFilterValue
     bool check(const T& query) const;
     bool check(const std::string& query) const;
 
+    // compares query against an already-typed filter value
+    template <typename T>
+    static bool compare(const T& query, const T& value, const ValueCompareType& type);
+    static bool compare(const std::string& query, const std::string& value,
+                        const ValueCompareType& type);
+
     // data members
     Variant Value;
     ValueCompareType Type;
@@ -103,19 +109,26 @@ bool PropertyFilterValue::check(const T& query) const
     }
 
     // numeric matching based on our filter type
-    switch (Type) {
+    return compare(query, Value.get<T>(), Type);
+}
+
+// compares a (numeric) query against filter value, based on compare type
+template <typename T>
+bool PropertyFilterValue::compare(const T& query, const T& value, const ValueCompareType& type)
+{
+    switch (type) {
         case (PropertyFilterValue::EXACT):
-            return (query == Value.get<T>());
+            return (query == value);
         case (PropertyFilterValue::GREATER_THAN):
-            return (query > Value.get<T>());
+            return (query > value);
         case (PropertyFilterValue::GREATER_THAN_EQUAL):
-            return (query >= Value.get<T>());
+            return (query >= value);
         case (PropertyFilterValue::LESS_THAN):
-            return (query < Value.get<T>());
+            return (query < value);
         case (PropertyFilterValue::LESS_THAN_EQUAL):
-            return (query <= Value.get<T>());
+            return (query <= value);
         case (PropertyFilterValue::NOT):
-            return (query != Value.get<T>());
+            return (query != value);
         default:
             BAMTOOLS_ASSERT_UNREACHABLE;
     }
@@ -132,11 +145,15 @@ inline bool PropertyFilterValue::check(const std::string& query) const
         return false;
     }
 
-    // localize string version of our filter value
-    const std::string& valueString = Value.get<std::string>();
-
     // string matching based on our filter type
-    switch (Type) {
+    return compare(query, Value.get<std::string>(), Type);
+}
+
+// compares a string query against filter value, based on compare type
+inline bool PropertyFilterValue::compare(const std::string& query, const std::string& valueString,
+                                         const ValueCompareType& type)
+{
+    switch (type) {
         case (PropertyFilterValue::CONTAINS):
             return (query.find(valueString) != std::string::npos);
         case (PropertyFilterValue::ENDS_WITH):
@@ -18,6 +18,8 @@ using namespace BamTools;
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <sstream>
 
 namespace BamTools {
@@ -305,6 +307,59 @@ bool Utilities::ParseRegionString(const std::string& regionString, const BamMult
     return true;
 }
 
+// Parses regions from a BED file (zero-based, half-open) into 'regions', skipping comment,
+// header & blank lines, as well as references not found in 'references'
+// Returns success (true/false)
+bool Utilities::ParseBedFile(const std::string& filename, const RefVector& references,
+                             std::vector<BamRegion>& regions)
+{
+
+    // open BED file
+    std::ifstream bedStream(filename.c_str());
+    if (!bedStream) {
+        return false;
+    }
+
+    // look up reference IDs by name
+    std::map<std::string, int> refIds;
+    for (std::size_t i = 0; i < references.size(); ++i) {
+        refIds.insert(std::make_pair(references[i].RefName, static_cast<int>(i)));
+    }
+
+    std::string line;
+    while (std::getline(bedStream, line)) {
+
+        // skip blank, comment & header lines
+        const std::size_t firstChar = line.find_first_not_of(" \t\r");
+        if (firstChar == std::string::npos || line[firstChar] == '#' || StartsWith(line, "track") ||
+            StartsWith(line, "browser")) {
+            continue;
+        }
+
+        // read chrom, start & end (any remaining fields are ignored)
+        std::istringstream lineStream(line);
+        std::string chrom;
+        long start;
+        long end;
+        if (!(lineStream >> chrom >> start >> end) || start < 0 || start > end ||
+            end > std::numeric_limits<int>::max()) {
+            return false;
+        }
+
+        // skip empty intervals & references not in BAM file
+        const std::map<std::string, int>::const_iterator refIter = refIds.find(chrom);
+        if (start == end || refIter == refIds.end()) {
+            continue;
+        }
+
+        // store region
+        regions.push_back(BamRegion(refIter->second, static_cast<int>(start), refIter->second,
+                                    static_cast<int>(end)));
+    }
+
+    return true;
+}
+
 void Utilities::Reverse(std::string& sequence)
 {
     reverse(sequence.begin(), sequence.end());
@@ -38,6 +38,12 @@ public:
     // check if a file exists
     static bool FileExists(const std::string& fname);
 
+    // Parses regions from a BED file (zero-based, half-open), skipping comment, header & blank
+    // lines as well as any references not found in 'references'
+    // Returns success (true/false), fails if file can't be read or has malformed lines
+    static bool ParseBedFile(const std::string& filename, const RefVector& references,
+                             std::vector<BamRegion>& regions);
+
     // Parses a region string, uses reader to do validation (valid ID's, positions), stores in Region struct
     // Returns success (true/false)
     static bool ParseRegionString(const std::string& regionString, const BamReader& reader,
@@ -0,0 +1,722 @@
+// ***************************************************************************
+// bamtools_benchmark.cpp (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 17 October 2026
+// ---------------------------------------------------------------------------
+// Times BamTools operations on generated alignments. Not run by ctest - use
+// the 'benchmark' target, or run it directly.
+//
+// Usage: bamtools_benchmark <work dir> <bamtools executable>
+//                           [numAlignments [numThreads [benchmark ...]]]
+// Runs all benchmarks unless some are named.
+//
+// The compression benchmark also uses the test data in BENCHMARK_DATA_DIR.
+// BGZF (de)compression uses the backend the library was built with
+// (BENCHMARK_DEFLATE_BACKEND, see EnableLibDeflate), so compare builds with it
+// ON and OFF.
+// ***************************************************************************
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "api/BamAlignment.h"
+#include "api/BamMultiReader.h"
+#include "api/BamReader.h"
+#include "api/BamWriter.h"
+using namespace BamTools;
+
+// counts heap allocations, for the allocation benchmark
+static std::atomic<std::size_t> NumAllocations(0);
+
+void* operator new(std::size_t size)
+{
+    ++NumAllocations;
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p)noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+const int READ_LENGTH = 100;
+const std::size_t NUM_MERGE_INPUTS = 256;
+
+// filters the 'filter' benchmark checks every alignment against
+const char FILTER_SCRIPT[] =
+    "{\n"
+    "    \"filters\": [\n"
+    "        { \"id\": \"good\", \"mapQuality\": \">=30\", \"isProperPair\": \"true\",\n"
+    "          \"tag\": \"NM:<2\" },\n"
+    "        { \"id\": \"clipped\", \"cigar\": \"*S*\", \"name\": \"frag:*\" },\n"
+    "        { \"id\": \"reverse\", \"isReverseStrand\": \"true\", \"length\": \">=100\" }\n"
+    "    ],\n"
+    "    \"rule\": \"(good | clipped) & !reverse\"\n"
+    "}\n";
+
+// inputs shared by all benchmarks
+struct BenchmarkData
+{
+    std::string WorkDir;
+    std::string Bamtools;                  // bamtools executable
+    std::vector<BamAlignment> Alignments;  // generated, position-sorted
+    std::string Filename;                  // Alignments, written at level 6
+    int NumThreads;
+};
+
+class Timer
+{
+public:
+    Timer()
+        : m_start(std::chrono::steady_clock::now())
+    {}
+
+    double Seconds() const
+    {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+        return elapsed.count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+void Report(const std::string& name, const double seconds, const std::size_t numAlignments)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-36s %9.3f s %12.0f alignments/s", name.c_str(), seconds,
+                  (seconds > 0 ? numAlignments / seconds : 0.0));
+    std::cout << line << std::endl;
+}
+
+// same as Report(), adding the output size & its ratio to the uncompressed size
+void ReportSize(const std::string& name, const double seconds, const std::size_t numAlignments,
+                const std::size_t size, const std::size_t uncompressedSize)
+{
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-36s %9.3f s %12.0f alignments/s %9.2f MB %6.1f%%",
+                  name.c_str(), seconds, (seconds > 0 ? numAlignments / seconds : 0.0), size / 1e6,
+                  (uncompressedSize > 0 ? 100.0 * size / uncompressedSize : 0.0));
+    std::cout << line << std::endl;
+}
+
+// reports throughput in MB/s of uncompressed data
+void ReportThroughput(const std::string& name, const double seconds, const std::size_t numBytes)
+{
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-36s %9.3f s %12.1f MB/s", name.c_str(), seconds,
+                  (seconds > 0 ? numBytes / 1e6 / seconds : 0.0));
+    std::cout << line << std::endl;
+}
+
+std::size_t FileSize(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+    return (file ? static_cast<std::size_t>(file.tellg()) : 0);
+}
+
+std::string Header()
+{
+    return "@HD\tVN:1.4\tSO:coordinate\n"
+           "@SQ\tSN:chr1\tLN:250000000\n"
+           "@SQ\tSN:chr2\tLN:250000000\n"
+           "@RG\tID:rg1\tSM:a\n"
+           "@RG\tID:rg2\tSM:b\n";
+}
+
+RefVector References()
+{
+    RefVector references;
+    references.push_back(RefData("chr1", 250000000));
+    references.push_back(RefData("chr2", 250000000));
+    return references;
+}
+
+// generates position-sorted alignments with realistic fields & tags
+std::vector<BamAlignment> GenerateAlignments(const std::size_t numAlignments,
+                                             const int readLength = READ_LENGTH)
+{
+    std::mt19937 random(11);
+    const char bases[] = "ACGT";
+    const char qualities[] = "#+5?I";
+
+    std::vector<BamAlignment> alignments(numAlignments);
+    int32_t position = 0;
+    for (std::size_t i = 0; i < numAlignments; ++i) {
+        BamAlignment& al = alignments[i];
+        const bool isFragment = (random() % 3 == 0);
+        std::ostringstream name;
+        name << (isFragment ? "frag:" : "read:") << random() % 100000 << ":" << i;
+        al.Name = name.str();
+        al.Length = readLength;
+        al.QueryBases.resize(readLength);
+        al.Qualities.resize(readLength);
+        for (int j = 0; j < readLength; ++j) {
+            al.QueryBases[j] = bases[random() % 4];
+            al.Qualities[j] = qualities[random() % 5];
+        }
+
+        if (i == numAlignments / 2) {
+            position = 0;
+        }
+        position += random() % 50;
+        al.RefID = (i < numAlignments / 2 ? 0 : 1);
+        al.Position = position;
+        al.MapQuality = random() % 61;
+        al.AlignmentFlag =
+            1 | (random() % 2 ? 16 : 0) | (i % 2 ? 64 : 128) | (random() % 3 ? 2 : 0);
+        if (random() % 5 == 0) {
+            al.CigarData.push_back(CigarOp('S', 5));
+            al.CigarData.push_back(CigarOp('M', readLength - 5));
+        } else {
+            al.CigarData.push_back(CigarOp('M', readLength));
+        }
+        al.MateRefID = al.RefID;
+        al.MatePosition = al.Position + 200;
+        al.InsertSize = 300;
+
+        al.AddTag("RG", "Z", std::string(random() % 2 ? "rg1" : "rg2"));
+        al.AddTag("NM", "i", static_cast<int32_t>(random() % 5));
+        al.AddTag("MD", "Z", std::string("40A59"));
+        al.AddTag("AS", "i", static_cast<int32_t>(random() % 100));
+        al.AddTag("XS", "i", static_cast<int32_t>(random() % 100));
+        if (random() % 4 == 0) {
+            al.AddTag("XF", "f", static_cast<float>(random() % 1000) / 10);
+        }
+    }
+    return alignments;
+}
+
+bool WriteAlignments(const std::string& filename, const std::string& header,
+                     const RefVector& references, const std::vector<BamAlignment>& alignments,
+                     const int numThreads, const int level,
+                     const BamWriter::CompressionStrategy strategy = BamWriter::DefaultStrategy)
+{
+    BamWriter writer;
+    writer.SetNumThreads(numThreads);
+    writer.SetCompressionLevel(level);
+    writer.SetCompressionStrategy(strategy);
+    if (!writer.Open(filename, header, references)) {
+        std::cerr << writer.GetErrorString() << std::endl;
+        return false;
+    }
+    for (std::vector<BamAlignment>::const_iterator al = alignments.begin(); al != alignments.end();
+         ++al) {
+        if (!writer.SaveAlignment(*al)) {
+            std::cerr << writer.GetErrorString() << std::endl;
+            return false;
+        }
+    }
+    writer.Close();
+    return true;
+}
+
+bool WriteAlignments(const std::string& filename, const std::vector<BamAlignment>& alignments,
+                     const int numThreads, const int level,
+                     const BamWriter::CompressionStrategy strategy = BamWriter::DefaultStrategy)
+{
+    return WriteAlignments(filename, Header(), References(), alignments, numThreads, level,
+                           strategy);
+}
+
+// writing at the default level, serial vs. compressing on worker threads
+bool BenchmarkThreadedWrite(const BenchmarkData& data)
+{
+    const std::string filename = data.WorkDir + "/write.bam";
+    for (int pass = 0; pass < 2; ++pass) {
+        const int numThreads = (pass == 0 ? 1 : data.NumThreads);
+        const Timer timer;
+        if (!WriteAlignments(filename, data.Alignments, numThreads, 6)) {
+            return false;
+        }
+        Report(pass == 0 ? "write" : "write, threads", timer.Seconds(), data.Alignments.size());
+    }
+    std::remove(filename.c_str());
+    return true;
+}
+
+// reading core-only & fully decoded, serial vs. decompressing ahead on worker threads
+bool BenchmarkReadAhead(const BenchmarkData& data)
+{
+    for (int pass = 0; pass < 4; ++pass) {
+        const bool isCore = (pass % 2 == 0);
+        const bool isThreaded = (pass >= 2);
+
+        BamReader reader;
+        reader.SetNumThreads(isThreaded ? data.NumThreads : 1);
+        if (!reader.Open(data.Filename)) {
+            std::cerr << reader.GetErrorString() << std::endl;
+            return false;
+        }
+
+        const Timer timer;
+        BamAlignment al;
+        std::size_t numAlignments = 0;
+        if (isCore) {
+            while (reader.GetNextAlignmentCore(al)) {
+                ++numAlignments;
+            }
+        } else {
+            while (reader.GetNextAlignment(al)) {
+                ++numAlignments;
+            }
+        }
+        std::string name = (isCore ? "read core" : "read full");
+        if (isThreaded) {
+            name += ", threads";
+        }
+        Report(name, timer.Seconds(), numAlignments);
+    }
+    return true;
+}
+
+// writes alignments at each compression level & strategy, reporting time & output size
+bool WriteCompressionLevels(const std::string& workDir, const std::string& inputName,
+                            const std::string& header, const RefVector& references,
+                            const std::vector<BamAlignment>& alignments)
+{
+    struct Case
+    {
+        const char* Name;
+        int Level;
+        BamWriter::CompressionStrategy Strategy;
+    };
+    const Case cases[] = {{"level 0", 0, BamWriter::DefaultStrategy},
+                          {"level 1", 1, BamWriter::DefaultStrategy},
+                          {"level 6", 6, BamWriter::DefaultStrategy},
+                          {"level 6, filtered", 6, BamWriter::Filtered},
+                          {"level 6, run length", 6, BamWriter::RunLength},
+                          {"level 9", 9, BamWriter::DefaultStrategy}};
+
+    // level 0 comes first, its (stored) output size serves as the uncompressed size
+    const std::string filename = workDir + "/levels.bam";
+    std::size_t uncompressedSize = 0;
+    for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        const Timer timer;
+        if (!WriteAlignments(filename, header, references, alignments, 1, cases[i].Level,
+                             cases[i].Strategy)) {
+            return false;
+        }
+        const double seconds = timer.Seconds();
+        const std::size_t size = FileSize(filename);
+        if (cases[i].Level == 0) {
+            uncompressedSize = size;
+        }
+        ReportSize(inputName + ", " + cases[i].Name, seconds, alignments.size(), size,
+                   uncompressedSize);
+    }
+    std::remove(filename.c_str());
+    return true;
+}
+
+// compression levels & strategies, on generated alignments & on the test data
+bool BenchmarkCompressionLevels(const BenchmarkData& data)
+{
+    if (!WriteCompressionLevels(data.WorkDir, "generated", Header(), References(),
+                                data.Alignments)) {
+        return false;
+    }
+
+    // repeat the test data's alignments up to the number of generated ones, to get
+    // measurable times (each BGZF block is still compressed on its own)
+    const std::string filename = std::string(BENCHMARK_DATA_DIR) + "/synthetic.bam";
+    BamReader reader;
+    if (!reader.Open(filename)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return false;
+    }
+    std::vector<BamAlignment> fileAlignments;
+    BamAlignment al;
+    while (reader.GetNextAlignment(al)) {
+        fileAlignments.push_back(al);
+    }
+    if (fileAlignments.empty()) {
+        std::cerr << filename << ": no alignments" << std::endl;
+        return false;
+    }
+    std::vector<BamAlignment> alignments;
+    while (alignments.size() < data.Alignments.size()) {
+        alignments.insert(alignments.end(), fileAlignments.begin(), fileAlignments.end());
+    }
+    return WriteCompressionLevels(data.WorkDir, "synthetic.bam", reader.GetHeaderText(),
+                                  reader.GetReferenceData(), alignments);
+}
+
+// compression & decompression throughput of the deflate backend, on a single thread
+bool BenchmarkDeflateBackend(const BenchmarkData& data)
+{
+    const std::string backend = BENCHMARK_DEFLATE_BACKEND;
+    const std::string filename = data.WorkDir + "/backend.bam";
+    if (!WriteAlignments(filename, data.Alignments, 1, 0)) {
+        return false;
+    }
+    const std::size_t uncompressedSize = FileSize(filename);
+
+    // the filtered strategy is always left to zlib, for comparison within a libdeflate build
+    const int levels[] = {1, 6, 6};
+    for (int i = 0; i < 3; ++i) {
+        const bool isFiltered = (i == 2);
+        std::ostringstream name;
+        name << "level " << levels[i] << ", " << (isFiltered ? "zlib filtered" : backend.c_str());
+
+        const Timer writeTimer;
+        if (!WriteAlignments(filename, data.Alignments, 1, levels[i],
+                             (isFiltered ? BamWriter::Filtered : BamWriter::DefaultStrategy))) {
+            return false;
+        }
+        ReportThroughput("compress " + name.str(), writeTimer.Seconds(), uncompressedSize);
+
+        BamReader reader;
+        if (!reader.Open(filename)) {
+            std::cerr << reader.GetErrorString() << std::endl;
+            return false;
+        }
+        const Timer readTimer;
+        BamAlignment al;
+        while (reader.GetNextAlignmentCore(al)) {
+            // core-only reading is mostly decompression
+        }
+        ReportThroughput("decompress " + name.str(), readTimer.Seconds(), uncompressedSize);
+    }
+    std::remove(filename.c_str());
+    return true;
+}
+
+// heap allocations per alignment read, core-only & fully decoded
+bool BenchmarkAllocations(const BenchmarkData& data)
+{
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool isCore = (pass == 0);
+        BamReader reader;
+        if (!reader.Open(data.Filename)) {
+            std::cerr << reader.GetErrorString() << std::endl;
+            return false;
+        }
+
+        BamAlignment al;
+        std::size_t numAlignments = 0;
+        const std::size_t numAllocations = NumAllocations;
+        if (isCore) {
+            while (reader.GetNextAlignmentCore(al)) {
+                ++numAlignments;
+            }
+        } else {
+            while (reader.GetNextAlignment(al)) {
+                ++numAlignments;
+            }
+        }
+        const double perAlignment =
+            static_cast<double>(NumAllocations - numAllocations) / numAlignments;
+
+        char line[128];
+        std::snprintf(line, sizeof(line), "%-36s %12.3f allocations/alignment",
+                      (isCore ? "read core" : "read full"), perAlignment);
+        std::cout << line << std::endl;
+    }
+    return true;
+}
+
+// per-read cost of encoding (SaveAlignment) & decoding (GetQueryBases() & GetQualities() after
+// a core-only read) sequences & qualities, for short & long reads
+bool BenchmarkReadLengths(const BenchmarkData& data)
+{
+    const int readLengths[] = {150, 10000};
+    const int numPasses = 5;
+    const std::string filename = data.WorkDir + "/lengths.bam";
+    for (int i = 0; i < 2; ++i) {
+
+        // as many bases as the generated alignments, uncompressed so that codec costs show
+        const std::size_t numAlignments =
+            std::max<std::size_t>(data.Alignments.size() * READ_LENGTH / readLengths[i], 100);
+        const std::vector<BamAlignment> alignments =
+            GenerateAlignments(numAlignments, readLengths[i]);
+        const double numBases = static_cast<double>(numAlignments) * readLengths[i];
+
+        // best of several passes: core-only reads, reads decoding bases & qualities, writes
+        double seconds[3] = {1e9, 1e9, 1e9};
+        for (int pass = 0; pass < numPasses; ++pass) {
+            const Timer writeTimer;
+            if (!WriteAlignments(filename, alignments, 1, 0)) {
+                return false;
+            }
+            seconds[2] = std::min(seconds[2], writeTimer.Seconds());
+
+            for (int j = 0; j < 2; ++j) {
+                BamReader reader;
+                if (!reader.Open(filename)) {
+                    std::cerr << reader.GetErrorString() << std::endl;
+                    return false;
+                }
+                const Timer readTimer;
+                BamAlignment al;
+                std::size_t numDecoded = 0;
+                while (reader.GetNextAlignmentCore(al)) {
+                    if (j == 1) {
+                        numDecoded += al.GetQueryBases().size() + al.GetQualities().size();
+                    }
+                }
+                seconds[j] = std::min(seconds[j], readTimer.Seconds());
+                if (j == 1 && numDecoded != 2 * numBases) {
+                    std::cerr << "decoded " << numDecoded << " bases & qualities, expected "
+                              << 2 * numBases << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        const char* names[] = {"read core", "decode bases & qualities", "write level 0"};
+        const double costs[] = {seconds[0], seconds[1] - seconds[0], seconds[2]};
+        for (int j = 0; j < 3; ++j) {
+            std::ostringstream name;
+            name << readLengths[i] << "bp " << names[j];
+            char line[128];
+            std::snprintf(line, sizeof(line), "%-36s %10.3f us/read %8.3f ns/base",
+                          name.str().c_str(), costs[j] * 1e6 / numAlignments,
+                          costs[j] * 1e9 / numBases);
+            std::cout << line << std::endl;
+        }
+    }
+    std::remove(filename.c_str());
+    return true;
+}
+
+// HasTag() on records with 10 tags, with & without building the tag index first
+bool BenchmarkTagLookups(const BenchmarkData& data)
+{
+    // a few thousand records, with tags of varying lengths as in real data
+    std::mt19937 random(7);
+    std::vector<BamAlignment> alignments(4096, data.Alignments.front());
+    for (std::size_t i = 0; i < alignments.size(); ++i) {
+        BamAlignment& al = alignments[i];
+        al.TagData.clear();
+        al.AddTag("RG", "Z", std::string(random() % 2 ? "rg1" : "readgroup2"));
+        al.AddTag("NM", "i", static_cast<int32_t>(random() % 5));
+        al.AddTag("MD", "Z", std::string(5 + random() % 20, '4') + "A" + "59");
+        al.AddTag("AS", "i", static_cast<int32_t>(random() % 100));
+        al.AddTag("XS", "i", static_cast<int32_t>(random() % 100));
+        al.AddTag("ZB", std::vector<int16_t>(random() % 16, 7));
+        al.AddTag("XA", "Z", std::string(random() % 80, 'c'));
+        al.AddTag("MQ", "i", static_cast<int32_t>(random() % 61));
+        al.AddTag("XF", "f", static_cast<float>(random() % 1000) / 10);
+        al.AddTag("YT", "Z", std::string("CP"));
+    }
+    const std::string names[] = {"RG", "NM", "MD", "AS", "XS", "ZB", "XA", "MQ", "XF", "YT"};
+
+    // querying the first tag, all of them, or the last one, per record
+    struct Case
+    {
+        const char* Name;
+        int First;
+        int Last;
+    };
+    const Case cases[] = {
+        {"1st of 10 tags", 0, 1}, {"all 10 tags", 0, 10}, {"10th of 10 tags", 9, 10}};
+    const std::size_t numRecords = data.Alignments.size() * 4;
+    for (std::size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        for (int pass = 0; pass < 2; ++pass) {
+            const bool useIndex = (pass == 1);
+            std::vector<BamAlignment> records(alignments);  // copies start without an index
+            std::size_t numFound = 0;
+            const Timer timer;
+            for (std::size_t j = 0; j < numRecords; ++j) {
+                BamAlignment& al = records[j % records.size()];
+                if (useIndex) {
+                    al.BuildTagIndex();
+                }
+                for (int k = cases[i].First; k < cases[i].Last; ++k) {
+                    numFound += al.HasTag(names[k]);
+                }
+            }
+            const double seconds = timer.Seconds();
+            if (numFound != numRecords * (cases[i].Last - cases[i].First)) {
+                std::cerr << "missing tags" << std::endl;
+                return false;
+            }
+
+            const std::string name = std::string(cases[i].Name) + (useIndex ? ", tag index" : "");
+            char line[128];
+            std::snprintf(line, sizeof(line), "%-36s %10.1f ns/record", name.c_str(),
+                          seconds * 1e9 / numRecords);
+            std::cout << line << std::endl;
+        }
+    }
+    return true;
+}
+
+// deals the alignments out round-robin to the merge inputs, keeping each input sorted
+bool WriteMergeInputs(const BenchmarkData& data, std::vector<std::string>& filenames)
+{
+    for (std::size_t i = 0; i < NUM_MERGE_INPUTS; ++i) {
+        std::vector<BamAlignment> input;
+        for (std::size_t j = i; j < data.Alignments.size(); j += NUM_MERGE_INPUTS) {
+            input.push_back(data.Alignments[j]);
+        }
+        std::ostringstream filename;
+        filename << data.WorkDir << "/merge_" << i << ".bam";
+        filenames.push_back(filename.str());
+        if (!WriteAlignments(filenames.back(), input, 1, 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// reads the merged inputs core-only, reading ahead on numThreads threads if more than 1
+bool RunMerge(const std::vector<std::string>& filenames, const std::string& name,
+              const int numThreads)
+{
+    BamMultiReader reader;
+    reader.SetNumThreads(numThreads);
+    if (!reader.Open(filenames)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return false;
+    }
+    const Timer timer;
+    BamAlignment al;
+    std::size_t numAlignments = 0;
+    while (reader.GetNextAlignmentCore(al)) {
+        ++numAlignments;
+    }
+    Report(name, timer.Seconds(), numAlignments);
+    return true;
+}
+
+// k-way merge of many position-sorted inputs, serial vs. reading ahead on worker threads
+bool BenchmarkMerge(const BenchmarkData& data)
+{
+    std::vector<std::string> filenames;
+    std::ostringstream name;
+    name << "merge " << NUM_MERGE_INPUTS << " inputs, core";
+    const bool success = WriteMergeInputs(data, filenames) && RunMerge(filenames, name.str(), 1) &&
+                         RunMerge(filenames, name.str() + ", threads", data.NumThreads);
+    for (std::size_t i = 0; i < filenames.size(); ++i) {
+        std::remove(filenames[i].c_str());
+    }
+    return success;
+}
+
+// runs 'bamtools filter' with the multi-filter script, on numThreads threads if more than 1
+bool RunFilter(const BenchmarkData& data, const std::string& name, const int numThreads)
+{
+    const std::string scriptFilename = data.WorkDir + "/filter_script.json";
+    std::ofstream script(scriptFilename.c_str());
+    script << FILTER_SCRIPT;
+    script.close();
+
+    const std::string outputFilename = data.WorkDir + "/filter.bam";
+    std::ostringstream command;
+    command << "\"" << data.Bamtools << "\" filter -in \"" << data.Filename << "\" -out \""
+            << outputFilename << "\" -script \"" << scriptFilename << "\"";
+    if (numThreads > 1) {
+        command << " -threads " << numThreads;
+    }
+
+    const Timer timer;
+    const bool success = (std::system(command.str().c_str()) == 0);
+    if (success) {
+        Report(name, timer.Seconds(), data.Alignments.size());
+    } else {
+        std::cerr << "failed: " << command.str() << std::endl;
+    }
+    std::remove(outputFilename.c_str());
+    std::remove(scriptFilename.c_str());
+    return success;
+}
+
+// 'bamtools filter' with a multi-filter script, serial vs. checking filters on worker threads
+bool BenchmarkFilter(const BenchmarkData& data)
+{
+    return RunFilter(data, "bamtools filter", 1) &&
+           RunFilter(data, "bamtools filter, threads", data.NumThreads);
+}
+
+struct Benchmark
+{
+    const char* Name;
+    bool (*Run)(const BenchmarkData& data);
+};
+
+const Benchmark BENCHMARKS[] = {{"threadedwrite", &BenchmarkThreadedWrite},
+                                {"readahead", &BenchmarkReadAhead},
+                                {"levels", &BenchmarkCompressionLevels},
+                                {"backend", &BenchmarkDeflateBackend},
+                                {"allocations", &BenchmarkAllocations},
+                                {"readlengths", &BenchmarkReadLengths},
+                                {"tags", &BenchmarkTagLookups},
+                                {"merge", &BenchmarkMerge},
+                                {"filter", &BenchmarkFilter}};
+const std::size_t NUM_BENCHMARKS = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        std::cerr << "usage: bamtools_benchmark <work dir> <bamtools executable> "
+                     "[numAlignments [numThreads [benchmark ...]]]\n"
+                     "benchmarks:";
+        for (std::size_t i = 0; i < NUM_BENCHMARKS; ++i) {
+            std::cerr << " " << BENCHMARKS[i].Name;
+        }
+        std::cerr << std::endl;
+        return 1;
+    }
+    BenchmarkData data;
+    data.WorkDir = argv[1];
+    data.Bamtools = argv[2];
+    const std::size_t numAlignments = (argc > 3 ? std::strtoul(argv[3], 0, 10) : 250000);
+    data.NumThreads = (argc > 4 ? std::atoi(argv[4]) : 4);
+    if (numAlignments == 0 || data.NumThreads < 1) {
+        std::cerr << "numAlignments & numThreads must be positive" << std::endl;
+        return 1;
+    }
+
+    // run the named benchmarks, or all of them
+    std::vector<const Benchmark*> benchmarks;
+    for (int i = 5; i < argc; ++i) {
+        std::size_t j = 0;
+        while (j < NUM_BENCHMARKS && argv[i] != std::string(BENCHMARKS[j].Name)) {
+            ++j;
+        }
+        if (j == NUM_BENCHMARKS) {
+            std::cerr << "unknown benchmark: " << argv[i] << std::endl;
+            return 1;
+        }
+        benchmarks.push_back(&BENCHMARKS[j]);
+    }
+    if (benchmarks.empty()) {
+        for (std::size_t i = 0; i < NUM_BENCHMARKS; ++i) {
+            benchmarks.push_back(&BENCHMARKS[i]);
+        }
+    }
+
+    std::cout << numAlignments << " alignments, " << data.NumThreads << " threads" << std::endl;
+    data.Alignments = GenerateAlignments(numAlignments);
+    data.Filename = data.WorkDir + "/benchmark.bam";
+    if (!WriteAlignments(data.Filename, data.Alignments, data.NumThreads, 6)) {
+        return 1;
+    }
+
+    bool success = true;
+    for (std::size_t i = 0; i < benchmarks.size() && success; ++i) {
+        success = benchmarks[i]->Run(data);
+    }
+    std::remove(data.Filename.c_str());
+    return (success ? 0 : 1);
+}
@@ -0,0 +1,615 @@
+// ***************************************************************************
+// bamtools_check.cpp (c) 2026 BamTools contributors
+// ---------------------------------------------------------------------------
+// Last modified: 17 October 2026
+// ---------------------------------------------------------------------------
+// Checks BAM file contents for the output comparison tests, using reference
+// implementations that are independent of the code under test.
+//
+// Usage: bamtools_check threadedwrite <filename> <serial output> <threaded output>
+//        bamtools_check codec <output>
+//        bamtools_check tagedits <filename>
+//        bamtools_check rawedits <filename> <output>
+//        bamtools_check order <filename> <position|name|natural>
+// Returns 0 if the check passes.
+// ***************************************************************************
+
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "api/BamAlignment.h"
+#include "api/BamReader.h"
+#include "api/BamWriter.h"
+#include "api/internal/bam/BamSequenceCodec_p.h"
+using namespace BamTools;
+
+namespace {
+
+// copies all alignments of filename to outputFilename, compressing on numThreads threads
+bool CopyAlignments(const std::string& filename, const std::string& outputFilename,
+                    const int numThreads)
+{
+    BamReader reader;
+    if (!reader.Open(filename)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return false;
+    }
+    BamWriter writer;
+    writer.SetNumThreads(numThreads);
+    if (!writer.Open(outputFilename, reader.GetHeaderText(), reader.GetReferenceData())) {
+        std::cerr << writer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    BamAlignment al;
+    std::size_t numAlignments = 0;
+    while (reader.GetNextAlignment(al)) {
+        if (!writer.SaveAlignment(al)) {
+            std::cerr << writer.GetErrorString() << std::endl;
+            return false;
+        }
+        ++numAlignments;
+    }
+    writer.Close();
+
+    if (numAlignments == 0) {
+        std::cerr << filename << ": no alignments" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// writes the same alignments serially & on several threads, for comparing the outputs
+int CheckThreadedWrite(const std::string& filename, const std::string& serialFilename,
+                       const std::string& threadedFilename)
+{
+    if (!CopyAlignments(filename, serialFilename, 1) ||
+        !CopyAlignments(filename, threadedFilename, 3)) {
+        return 1;
+    }
+    return 0;
+}
+
+// sequence lengths covering odd lengths, the 16- & 32-byte SIMD blocks and their tails
+std::vector<std::size_t> CodecLengths()
+{
+    std::vector<std::size_t> lengths;
+    for (std::size_t length = 0; length <= 130; ++length) {
+        lengths.push_back(length);
+    }
+    const std::size_t longLengths[] = {255, 256, 257, 1000, 10001};
+    lengths.insert(lengths.end(), longLengths, longLengths + 5);
+    return lengths;
+}
+
+// runs the current codec kernels & the scalar ones on the same input, returns false if they differ
+class CodecComparison
+{
+public:
+    explicit CodecComparison(const std::string& kernelName)
+        : m_kernelName(kernelName)
+    {}
+
+    bool DecodeBases(const std::string& packed, const std::size_t numBases)
+    {
+        std::string expected(numBases + 64, '#');
+        std::string actual(numBases + 64, '#');
+        Internal::BamSequenceCodec::DecodeBases(packed.data(), numBases, &actual[0]);
+        Internal::BamSequenceCodec::UseKernels("scalar");
+        Internal::BamSequenceCodec::DecodeBases(packed.data(), numBases, &expected[0]);
+        Internal::BamSequenceCodec::UseKernels(m_kernelName);
+        return Check(expected == actual, "DecodeBases", numBases);
+    }
+
+    bool EncodeBases(const std::string& bases)
+    {
+        const std::size_t numBytes = (bases.size() + 1) / 2;
+        std::string expected(numBytes + 64, '#');
+        std::string actual(numBytes + 64, '#');
+        const std::size_t actualResult =
+            Internal::BamSequenceCodec::EncodeBases(bases.data(), bases.size(), &actual[0]);
+        Internal::BamSequenceCodec::UseKernels("scalar");
+        const std::size_t expectedResult =
+            Internal::BamSequenceCodec::EncodeBases(bases.data(), bases.size(), &expected[0]);
+        Internal::BamSequenceCodec::UseKernels(m_kernelName);
+
+        // packed output is only defined if all bases are valid
+        if (expectedResult != bases.size()) {
+            return Check(actualResult == expectedResult, "EncodeBases (invalid base)",
+                         bases.size());
+        }
+        return Check(actualResult == expectedResult && actual == expected, "EncodeBases",
+                     bases.size());
+    }
+
+    bool Qualities(const std::string& input)
+    {
+        std::string expected(input.size() + 64, '#');
+        std::string actual(input.size() + 64, '#');
+        Internal::BamSequenceCodec::DecodeQualities(input.data(), input.size(), &actual[0]);
+        Internal::BamSequenceCodec::UseKernels("scalar");
+        Internal::BamSequenceCodec::DecodeQualities(input.data(), input.size(), &expected[0]);
+        Internal::BamSequenceCodec::UseKernels(m_kernelName);
+        if (!Check(expected == actual, "DecodeQualities", input.size())) {
+            return false;
+        }
+
+        Internal::BamSequenceCodec::EncodeQualities(input.data(), input.size(), &actual[0]);
+        Internal::BamSequenceCodec::UseKernels("scalar");
+        Internal::BamSequenceCodec::EncodeQualities(input.data(), input.size(), &expected[0]);
+        Internal::BamSequenceCodec::UseKernels(m_kernelName);
+        return Check(expected == actual, "EncodeQualities", input.size());
+    }
+
+private:
+    bool Check(const bool ok, const std::string& function, const std::size_t length) const
+    {
+        if (!ok) {
+            std::cerr << m_kernelName << " " << function << " differs from scalar for length "
+                      << length << std::endl;
+        }
+        return ok;
+    }
+
+    std::string m_kernelName;
+};
+
+// compares the named kernels with the scalar ones on generated sequences & qualities
+bool CheckCodecKernels(const std::string& kernelName)
+{
+    static const char VALID_BASES[] = "=ACMGRSVTWYHKDBN";
+    static const char INVALID_BASES[] = {'a', 'c', 'g',  't',    'n',   'X',
+                                         '*', '.', '\0', '\x80', '\xFF'};
+    std::mt19937 random(42);
+    CodecComparison compare(kernelName);
+
+    const std::vector<std::size_t> lengths = CodecLengths();
+    for (std::size_t i = 0; i < lengths.size(); ++i) {
+        const std::size_t length = lengths[i];
+
+        // every packed byte value, as well as all 16 valid bases
+        std::string packed((length + 1) / 2, '\0');
+        std::string bases(length, 'A');
+        std::string qualities(length, '\0');
+        for (std::size_t j = 0; j < length; ++j) {
+            packed[j / 2] = static_cast<char>(random() & 0xFF);
+            bases[j] = VALID_BASES[random() % 16];
+            qualities[j] = static_cast<char>(random() & 0xFF);
+        }
+        if (!compare.DecodeBases(packed, length) || !compare.EncodeBases(bases) ||
+            !compare.Qualities(qualities) ||
+            !compare.Qualities(std::string(length, static_cast<char>(0xFF)))) {
+            return false;
+        }
+
+        // a lowercase or invalid base at block boundaries & random positions
+        const std::size_t positions[] = {0, 1, 15, 16, 31, 32, length / 2, length - 1, random()};
+        for (std::size_t j = 0; j < length && j < 9; ++j) {
+            std::string invalid = bases;
+            invalid[positions[j] % length] = INVALID_BASES[random() % sizeof(INVALID_BASES)];
+            if (!compare.EncodeBases(invalid)) {
+                return false;
+            }
+        }
+        std::string lowercase = bases;
+        for (std::size_t j = 0; j < length; ++j) {
+            lowercase[j] = static_cast<char>(std::tolower(lowercase[j]));
+        }
+        if (!compare.EncodeBases(lowercase)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// writes & reads back alignments with the named kernels, including unstored qualities (0xFF)
+bool CheckCodecRoundTrip(const std::string& kernelName, const std::string& outputFilename)
+{
+    std::vector<BamAlignment> alignments;
+    const std::vector<std::size_t> lengths = CodecLengths();
+    for (std::size_t i = 0; i < lengths.size(); ++i) {
+        if (lengths[i] == 0) {
+            continue;
+        }
+        BamAlignment al;
+        al.Name = "read" + std::to_string(lengths[i]);
+        al.AlignmentFlag = 0x4;
+        al.QueryBases.resize(lengths[i]);
+        al.Qualities.resize(lengths[i]);
+        for (std::size_t j = 0; j < lengths[i]; ++j) {
+            al.QueryBases[j] = "ACGTN"[(i + j) % 5];
+            al.Qualities[j] = static_cast<char>('!' + (i * 7 + j) % 94);
+        }
+        alignments.push_back(al);
+        al.Qualities = "*";
+        alignments.push_back(al);
+        al.Qualities = std::string(lengths[i], static_cast<char>(0xFF));
+        alignments.push_back(al);
+    }
+
+    BamWriter writer;
+    if (!writer.Open(outputFilename, std::string(), RefVector())) {
+        std::cerr << writer.GetErrorString() << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < alignments.size(); ++i) {
+        writer.SaveAlignment(alignments[i]);
+    }
+    writer.Close();
+
+    BamReader reader;
+    if (!reader.Open(outputFilename)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return false;
+    }
+    BamAlignment al;
+    for (std::size_t i = 0; i < alignments.size(); ++i) {
+        const BamAlignment& expected = alignments[i];
+        const std::string expectedQualities =
+            (expected.Qualities == "*"
+                 ? std::string(expected.QueryBases.size(), static_cast<char>(0xFF))
+                 : expected.Qualities);
+        if (!reader.GetNextAlignment(al) || al.QueryBases != expected.QueryBases ||
+            al.Qualities != expectedQualities) {
+            std::cerr << kernelName << ": " << expected.Name << " (" << i % 3
+                      << ") does not read back as written" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// checks every SIMD kernel set this CPU supports against the scalar kernels
+int CheckCodec(const std::string& outputFilename)
+{
+    const char* kernelNames[] = {"scalar", "sse2", "ssse3", "avx2"};
+    for (std::size_t i = 0; i < 4; ++i) {
+        if (!Internal::BamSequenceCodec::UseKernels(kernelNames[i])) {
+            std::cout << kernelNames[i] << ": not supported by this CPU, skipped" << std::endl;
+            continue;
+        }
+        if (!CheckCodecKernels(kernelNames[i]) ||
+            !CheckCodecRoundTrip(kernelNames[i], outputFilename)) {
+            return 1;
+        }
+        std::cout << kernelNames[i] << ": ok" << std::endl;
+    }
+    return 0;
+}
+
+// rebuilds the expected tags of an edited alignment from scratch, in their original order
+bool ExpectedTagData(const BamAlignment& original, std::string& tagData)
+{
+    BamAlignment expected;
+    int32_t numMismatches = 0;
+    std::string mismatches;
+    if (!original.GetTag("NM", numMismatches) || !original.GetTag("MD", mismatches)) {
+        return false;
+    }
+    expected.AddTag("NM", "i", static_cast<int32_t>(numMismatches + 100));
+    expected.AddTag("MD", "Z", mismatches + "^A");
+    float score = 0;
+    if (original.GetTag("XF", score)) {
+        expected.AddTag("XF", "f", score);
+    }
+    std::vector<int16_t> values;
+    if (original.GetTag("ZB", values)) {
+        values.push_back(1);
+        expected.AddTag("ZB", values);
+    }
+    expected.AddTag("XX", "Z", std::string("added"));
+    tagData = expected.TagData;
+    return true;
+}
+
+// edits tags one at a time & in bulk, checking both against tags rebuilt from scratch
+int CheckTagEdits(const std::string& filename)
+{
+    BamReader reader;
+    if (!reader.Open(filename)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return 1;
+    }
+
+    BamAlignment al;
+    std::size_t numAlignments = 0;
+    while (reader.GetNextAlignment(al)) {
+        ++numAlignments;
+
+        // values for same-size, resized, removed & added tags
+        int32_t numMismatches = 0;
+        std::string mismatches;
+        al.GetTag("NM", numMismatches);
+        al.GetTag("MD", mismatches);
+        std::vector<int16_t> values;
+        const bool hasArray = al.GetTag("ZB", values);
+        values.push_back(1);
+
+        // edit one tag at a time
+        BamAlignment single(al);
+        single.BuildTagIndex();
+        single.EditTag("NM", "i", static_cast<int32_t>(numMismatches + 100));
+        int32_t editedMismatches = 0;
+        if (!single.GetTag("NM", editedMismatches) || editedMismatches != numMismatches + 100) {
+            std::cerr << al.Name << ": EditTag did not update NM in place" << std::endl;
+            return 1;
+        }
+        single.EditTag("MD", "Z", mismatches + "^A");
+        single.RemoveTag("RG");
+        if (hasArray) {
+            single.EditTag("ZB", values);
+        }
+        single.EditTag("XX", "Z", std::string("added"));
+
+        // & all at once
+        BamTagEdits edits;
+        edits.Edit("XX", "Z", std::string("added"));
+        edits.Edit("NM", "i", static_cast<int32_t>(numMismatches + 100));
+        edits.Remove("RG");
+        edits.Edit("MD", "Z", mismatches + "^A");
+        if (hasArray) {
+            edits.Edit("ZB", values);
+        }
+        BamAlignment bulk(al);
+        if (!bulk.EditTags(edits)) {
+            std::cerr << al.Name << ": EditTags failed" << std::endl;
+            return 1;
+        }
+
+        // compare against each other & a from-scratch rebuild
+        std::string expected;
+        if (!ExpectedTagData(al, expected)) {
+            std::cerr << al.Name << ": missing NM or MD tag" << std::endl;
+            return 1;
+        }
+        if (single.TagData != expected) {
+            std::cerr << al.Name << ": EditTag/RemoveTag result differs from expected tags"
+                      << std::endl;
+            return 1;
+        }
+        if (bulk.TagData != expected) {
+            std::cerr << al.Name << ": EditTags result differs from expected tags" << std::endl;
+            return 1;
+        }
+    }
+
+    if (numAlignments == 0) {
+        std::cerr << filename << ": no alignments" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// char data fields edited by EditRawField()
+const char* const RAW_FIELDS[] = {"Name", "QueryBases", "Qualities", "CigarData", "TagData"};
+
+// edits one char data field in place, keeping its length
+void EditRawField(BamAlignment& al, const std::size_t field)
+{
+    switch (field % 5) {
+        case 0:
+            al.Name[0] = (al.Name[0] == 'x' ? 'y' : 'x');
+            break;
+        case 1:
+            if (!al.QueryBases.empty()) {
+                al.QueryBases[0] = (al.QueryBases[0] == 'A' ? 'C' : 'A');
+            }
+            break;
+        case 2:
+            if (!al.Qualities.empty()) {
+                al.Qualities[0] = (al.Qualities[0] == '#' ? '?' : '#');
+            }
+            break;
+        case 3:
+            if (!al.CigarData.empty()) {
+                al.CigarData[0].Type = (al.CigarData[0].Type == 'M' ? '=' : 'M');
+            }
+            break;
+        default:
+            if (!al.TagData.empty()) {
+                al.TagData[0] = (al.TagData[0] == 'X' ? 'Y' : 'X');
+            }
+            break;
+    }
+}
+
+bool IsSameCigar(const std::vector<CigarOp>& lhs, const std::vector<CigarOp>& rhs)
+{
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].Type != rhs[i].Type || lhs[i].Length != rhs[i].Length) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// edits the char data fields of alignments in place (same lengths as the raw data), saves them
+// with SaveRawAlignment() & checks that the edited values are read back
+int CheckRawEdits(const std::string& filename, const std::string& outputFilename)
+{
+    BamReader reader;
+    if (!reader.Open(filename)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return 1;
+    }
+    BamWriter writer;
+    if (!writer.Open(outputFilename, reader.GetHeaderText(), reader.GetReferenceData())) {
+        std::cerr << writer.GetErrorString() << std::endl;
+        return 1;
+    }
+
+    // edit every other alignment, cycling through the fields
+    std::vector<BamAlignment> expected;
+    BamAlignment al;
+    while (reader.GetNextAlignment(al)) {
+        if (expected.size() % 2 == 1) {
+            EditRawField(al, expected.size() / 2);
+        }
+        if (!writer.SaveRawAlignment(al)) {
+            std::cerr << writer.GetErrorString() << std::endl;
+            return 1;
+        }
+        expected.push_back(al);
+    }
+    writer.Close();
+    reader.Close();
+    if (expected.empty()) {
+        std::cerr << filename << ": no alignments" << std::endl;
+        return 1;
+    }
+
+    if (!reader.Open(outputFilename)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return 1;
+    }
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        const BamAlignment& edited = expected[i];
+        if (!reader.GetNextAlignment(al) || al.Name != edited.Name ||
+            al.QueryBases != edited.QueryBases || al.Qualities != edited.Qualities ||
+            !IsSameCigar(al.CigarData, edited.CigarData) || al.TagData != edited.TagData) {
+            std::cerr << "alignment " << i << " (edited "
+                      << (i % 2 == 1 ? RAW_FIELDS[(i / 2) % 5] : "nothing")
+                      << ") does not read back as saved" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+bool IsDigit(const char c)
+{
+    return (c >= '0' && c <= '9');
+}
+
+// compares names, treating runs of digits as numbers: returns <0, 0 or >0 like strcmp()
+int CompareNatural(const std::string& lhs, const std::string& rhs)
+{
+    std::size_t l = 0;
+    std::size_t r = 0;
+    while (l < lhs.size() && r < rhs.size()) {
+
+        // compare other characters one at a time
+        if (!IsDigit(lhs[l]) || !IsDigit(rhs[r])) {
+            if (lhs[l] != rhs[r]) {
+                return static_cast<unsigned char>(lhs[l]) - static_cast<unsigned char>(rhs[r]);
+            }
+            ++l;
+            ++r;
+            continue;
+        }
+
+        // compare numbers by value: drop leading zeros, then longer is larger, then by digits
+        std::size_t lEnd = l;
+        std::size_t rEnd = r;
+        while (lEnd < lhs.size() && IsDigit(lhs[lEnd])) {
+            ++lEnd;
+        }
+        while (rEnd < rhs.size() && IsDigit(rhs[rEnd])) {
+            ++rEnd;
+        }
+        while (l + 1 < lEnd && lhs[l] == '0') {
+            ++l;
+        }
+        while (r + 1 < rEnd && rhs[r] == '0') {
+            ++r;
+        }
+        if (lEnd - l != rEnd - r) {
+            return (lEnd - l < rEnd - r ? -1 : 1);
+        }
+        const int result = lhs.compare(l, lEnd - l, rhs, r, rEnd - r);
+        if (result != 0) {
+            return result;
+        }
+        l = lEnd;
+        r = rEnd;
+    }
+    return (l < lhs.size() ? 1 : (r < rhs.size() ? -1 : 0));
+}
+
+// returns true if 'al' may follow 'previous' in the requested order
+bool IsInOrder(const BamAlignment& previous, const BamAlignment& al, const std::string& order)
+{
+    if (order == "position") {
+        // unmapped alignments (RefID -1) come last
+        const unsigned int previousRef = static_cast<unsigned int>(previous.RefID);
+        const unsigned int ref = static_cast<unsigned int>(al.RefID);
+        return (previousRef < ref || (previousRef == ref && previous.Position <= al.Position));
+    }
+    if (order == "name") {
+        return (std::strcmp(previous.Name.c_str(), al.Name.c_str()) <= 0);
+    }
+    return (CompareNatural(previous.Name, al.Name) <= 0);
+}
+
+// checks that a sorted file's alignments are in the requested order
+int CheckOrder(const std::string& filename, const std::string& order)
+{
+    if (order != "position" && order != "name" && order != "natural") {
+        std::cerr << "unknown order: " << order << std::endl;
+        return 1;
+    }
+
+    BamReader reader;
+    if (!reader.Open(filename)) {
+        std::cerr << reader.GetErrorString() << std::endl;
+        return 1;
+    }
+
+    BamAlignment previous;
+    BamAlignment al;
+    std::size_t numAlignments = 0;
+    while (reader.GetNextAlignment(al)) {
+        if (numAlignments > 0 && !IsInOrder(previous, al, order)) {
+            std::cerr << filename << ": " << al.Name << " (" << al.RefID << ":" << al.Position
+                      << ") follows " << previous.Name << " (" << previous.RefID << ":"
+                      << previous.Position << ") in " << order << " order" << std::endl;
+            return 1;
+        }
+        previous = al;
+        ++numAlignments;
+    }
+
+    if (numAlignments == 0) {
+        std::cerr << filename << ": no alignments" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::string command = (argc > 1 ? argv[1] : "");
+    if (command == "threadedwrite" && argc == 5) {
+        return CheckThreadedWrite(argv[2], argv[3], argv[4]);
+    }
+    if (command == "codec" && argc == 3) {
+        return CheckCodec(argv[2]);
+    }
+    if (command == "tagedits" && argc == 3) {
+        return CheckTagEdits(argv[2]);
+    }
+    if (command == "rawedits" && argc == 4) {
+        return CheckRawEdits(argv[2], argv[3]);
+    }
+    if (command == "order" && argc == 4) {
+        return CheckOrder(argv[2], argv[3]);
+    }
+
+    std::cerr << "usage: bamtools_check threadedwrite <filename> <serial output> <threaded "
+                 "output>\n"
+                 "       bamtools_check codec <output>\n"
+                 "       bamtools_check tagedits <filename>\n"
+                 "       bamtools_check rawedits <filename> <output>\n"
+                 "       bamtools_check order <filename> <position|name|natural>"
+              << std::endl;
+    return 1;
+}
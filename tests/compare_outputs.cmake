@@ -0,0 +1,194 @@
+# Runs one output comparison test: produces the same data in two different ways (serial vs.
+# threaded, indexed vs. full scan, etc.) & fails if the results differ.
+#
+# Usage: cmake -DCOMPARISON=<name> -DBAMTOOLS=<path> -DCHECK=<path> -DDATA_DIR=<path>
+#              -DWORK_DIR=<path> -P compare_outputs.cmake
+
+set(INPUT ${DATA_DIR}/synthetic.bam)
+set(OUT ${WORK_DIR}/${COMPARISON})
+file(REMOVE_RECURSE ${OUT})
+file(MAKE_DIRECTORY ${OUT})
+
+# runs bamtools with the given arguments, failing the test on error
+function(run_bamtools)
+    execute_process(
+        COMMAND ${BAMTOOLS} ${ARGN}
+        RESULT_VARIABLE result
+        ERROR_VARIABLE errors)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "bamtools ${ARGN} failed (${result}):\n${errors}")
+    endif()
+endfunction()
+
+# same as run_bamtools(), saving standard output to a file
+function(run_bamtools_to_file output)
+    execute_process(
+        COMMAND ${BAMTOOLS} ${ARGN}
+        OUTPUT_FILE ${output}
+        RESULT_VARIABLE result
+        ERROR_VARIABLE errors)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "bamtools ${ARGN} failed (${result}):\n${errors}")
+    endif()
+endfunction()
+
+# fails the test if bamtools succeeds with the given arguments
+function(run_bamtools_failing)
+    execute_process(
+        COMMAND ${BAMTOOLS} ${ARGN}
+        RESULT_VARIABLE result
+        OUTPUT_QUIET
+        ERROR_QUIET)
+    if(result EQUAL 0)
+        message(FATAL_ERROR "bamtools ${ARGN} should have failed")
+    endif()
+endfunction()
+
+# runs bamtools_check with the given arguments, failing the test if the check fails
+function(run_check)
+    execute_process(
+        COMMAND ${CHECK} ${ARGN}
+        RESULT_VARIABLE result
+        ERROR_VARIABLE errors)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "bamtools_check ${ARGN} failed (${result}):\n${errors}")
+    endif()
+endfunction()
+
+# fails the test if the files' contents differ
+function(compare_files expected actual)
+    execute_process(
+        COMMAND ${CMAKE_COMMAND} -E compare_files ${expected} ${actual}
+        RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${actual} differs from ${expected}")
+    endif()
+endfunction()
+
+# writes alignments of a BAM file as SAM records, without header
+function(convert_to_sam input output)
+    run_bamtools(convert -format sam -noheader -in ${input} -out ${output} ${ARGN})
+endfunction()
+
+# sets variable to the size of the file in bytes
+function(get_file_size filename variable)
+    file(READ ${filename} contents HEX)
+    string(LENGTH "${contents}" numHexDigits)
+    math(EXPR size "${numHexDigits} / 2")
+    set(${variable} ${size} PARENT_SCOPE)
+endfunction()
+
+if(COMPARISON STREQUAL "threads_write")
+
+    # compressing blocks on worker threads must give the same bytes as serial compression
+    run_check(threadedwrite ${INPUT} ${OUT}/serial.bam ${OUT}/threads.bam)
+    compare_files(${OUT}/serial.bam ${OUT}/threads.bam)
+
+elseif(COMPARISON STREQUAL "merge_level" OR COMPARISON STREQUAL "filter_level")
+
+    # -level 9 must not give larger output than -level 1, with the same alignments
+    string(REPLACE "_level" "" tool ${COMPARISON})
+    run_bamtools(${tool} -in ${INPUT} -out ${OUT}/level1.bam -level 1)
+    run_bamtools(${tool} -in ${INPUT} -out ${OUT}/level9.bam -level 9)
+    get_file_size(${OUT}/level1.bam level1Size)
+    get_file_size(${OUT}/level9.bam level9Size)
+    if(level9Size GREATER level1Size)
+        message(FATAL_ERROR "-level 9 output (${level9Size} bytes) is larger than -level 1 "
+                            "output (${level1Size} bytes)")
+    endif()
+    convert_to_sam(${OUT}/level1.bam ${OUT}/level1.sam)
+    convert_to_sam(${OUT}/level9.bam ${OUT}/level9.sam)
+    compare_files(${OUT}/level1.sam ${OUT}/level9.sam)
+
+    # uncompressed output to stdout stays uncompressed, levels above 9 are rejected
+    run_bamtools_to_file(${OUT}/stdout.bam ${tool} -in ${INPUT})
+    run_bamtools_to_file(${OUT}/stdout_level9.bam ${tool} -in ${INPUT} -level 9)
+    compare_files(${OUT}/stdout.bam ${OUT}/stdout_level9.bam)
+    run_bamtools_failing(${tool} -in ${INPUT} -out ${OUT}/level10.bam -level 10)
+
+elseif(COMPARISON STREQUAL "tag_edits")
+
+    run_check(tagedits ${INPUT})
+
+elseif(COMPARISON STREQUAL "raw_edits")
+
+    run_check(rawedits ${INPUT} ${OUT}/edited.bam)
+
+elseif(COMPARISON STREQUAL "threads_merge")
+
+    run_bamtools(merge -in ${INPUT} -in ${INPUT} -out ${OUT}/serial.bam)
+    run_bamtools(merge -in ${INPUT} -in ${INPUT} -out ${OUT}/threads.bam -threads 3)
+    compare_files(${OUT}/serial.bam ${OUT}/threads.bam)
+
+elseif(COMPARISON STREQUAL "threads_sort")
+
+    # many small runs, with & without threads, must match sorting in a single run
+    # (sorting the name-sorted file by position puts the unmapped alignments' ties in play)
+    run_bamtools(sort -byname -in ${INPUT} -out ${OUT}/single.bam)
+    run_bamtools(sort -byname -in ${INPUT} -out ${OUT}/runs.bam -n 150 -maxfiles 4)
+    run_bamtools(sort -byname -in ${INPUT} -out ${OUT}/threads.bam -n 150 -maxfiles 4 -threads 3)
+    compare_files(${OUT}/single.bam ${OUT}/runs.bam)
+    compare_files(${OUT}/single.bam ${OUT}/threads.bam)
+    run_bamtools(sort -in ${OUT}/single.bam -out ${OUT}/position_single.bam)
+    run_bamtools(sort -in ${OUT}/single.bam -out ${OUT}/position_runs.bam -n 150 -threads 3)
+    compare_files(${OUT}/position_single.bam ${OUT}/position_runs.bam)
+
+elseif(COMPARISON STREQUAL "sort_order")
+
+    # name orders, checked against reference comparisons
+    run_bamtools(sort -byname -in ${INPUT} -out ${OUT}/byname.bam)
+    run_check(order ${OUT}/byname.bam name)
+    run_bamtools(sort -natural -in ${INPUT} -out ${OUT}/natural.bam)
+    run_check(order ${OUT}/natural.bam natural)
+
+    # position order, from shuffled input, must restore the (position-sorted) input
+    run_bamtools(sort -in ${OUT}/byname.bam -out ${OUT}/position.bam)
+    run_check(order ${OUT}/position.bam position)
+    convert_to_sam(${INPUT} ${OUT}/input.sam)
+    convert_to_sam(${OUT}/position.bam ${OUT}/position.sam)
+    compare_files(${OUT}/input.sam ${OUT}/position.sam)
+
+elseif(COMPARISON STREQUAL "filter_pushdown")
+
+    # reference/position filters on an indexed file read only matching regions, which must
+    # give the same result as checking every alignment of the unindexed file
+    set(script -script ${DATA_DIR}/pushdown_script.json)
+    configure_file(${INPUT} ${OUT}/indexed.bam COPYONLY)
+    configure_file(${INPUT} ${OUT}/unindexed.bam COPYONLY)
+    run_bamtools(index -in ${OUT}/indexed.bam)
+    run_bamtools(filter -in ${OUT}/unindexed.bam -out ${OUT}/scan.bam ${script})
+    run_bamtools(filter -in ${OUT}/indexed.bam -out ${OUT}/pushdown.bam ${script})
+    compare_files(${OUT}/scan.bam ${OUT}/pushdown.bam)
+
+elseif(COMPARISON STREQUAL "regions_bed")
+
+    # -bed (SetRegions) must match one -region (SetRegion) run per BED region, concatenated
+    # BED regions are sorted & far enough apart that no alignment overlaps two of them
+    set(bam ${OUT}/indexed.bam)
+    configure_file(${INPUT} ${bam} COPYONLY)
+    run_bamtools(index -in ${bam})
+    convert_to_sam(${bam} ${OUT}/bed.sam -bed ${DATA_DIR}/synthetic.bed)
+    file(WRITE ${OUT}/regions.sam "")
+    file(STRINGS ${DATA_DIR}/synthetic.bed bedLines REGEX "^chr[12]\t")
+    foreach(bedLine ${bedLines})
+        string(REPLACE "\t" ";" fields "${bedLine}")
+        list(GET fields 0 chrom)
+        list(GET fields 1 start)
+        list(GET fields 2 end)
+        convert_to_sam(${bam} ${OUT}/region.sam -region ${chrom}:${start}..${end})
+        file(READ ${OUT}/region.sam regionAlignments)
+        file(APPEND ${OUT}/regions.sam "${regionAlignments}")
+    endforeach()
+    compare_files(${OUT}/regions.sam ${OUT}/bed.sam)
+
+elseif(COMPARISON STREQUAL "threads_filter")
+
+    # threaded read-ahead, filter checks & compression must give the same bytes as serial
+    set(options -mapQuality >=20 -isProperPair true -tag NM:<3)
+    run_bamtools(filter -in ${INPUT} -out ${OUT}/serial.bam ${options})
+    run_bamtools(filter -in ${INPUT} -out ${OUT}/threads.bam -threads 3 ${options})
+    compare_files(${OUT}/serial.bam ${OUT}/threads.bam)
+
+else()
+    message(FATAL_ERROR "unknown comparison: ${COMPARISON}")
+endif()